@@ -6,6 +6,7 @@
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/TextureBatchLoader.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -105,6 +106,7 @@ private:
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+	TextureCache mTextureCache;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
@@ -195,6 +197,8 @@ bool CrateApp::Initialize()
     // Wait until initialization is complete.
     FlushCommandQueue();
 
+    mTextureCache.ReleaseCompleted(mFence->GetCompletedValue());
+
     return true;
 }
  
@@ -449,14 +453,14 @@ void CrateApp::UpdateMainPassCB(const GameTimer& gt)
 
 void CrateApp::LoadTextures()
 {
-	auto woodCrateTex = std::make_unique<Texture>();
-	woodCrateTex->Name = "woodCrateTex";
-	woodCrateTex->Filename = L"../Textures/MipLevel.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), woodCrateTex->Filename.c_str(),
-		woodCrateTex->Resource, woodCrateTex->UploadHeap));
- 
-	mTextures[woodCrateTex->Name] = std::move(woodCrateTex);
+	std::vector<TextureLoadEntry> textures =
+	{
+		{ "woodCrateTex", L"../Textures/MipLevel.dds" },
+	};
+
+	auto report = TextureBatchLoader::Load(md3dDevice.Get(), mCommandList.Get(), mCurrentFence + 1,
+		textures, mTextures, mTextureCache);
+	OutputDebugString(report.ToString().c_str());
 }
 
 void CrateApp::BuildRootSignature()
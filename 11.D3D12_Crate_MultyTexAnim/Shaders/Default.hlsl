@@ -1,4 +1,4 @@
-﻿a//***************************************************************************************
+﻿//***************************************************************************************
 // Default.hlsl by Frank Luna (C) 2015 All Rights Reserved.
 //
 // Default shader, currently supports lighting.
@@ -20,8 +20,8 @@
 // Include structures and functions for lighting.
 #include "LightingUtil.hlsl"
 
-Texture2D	gDiffuseMapWood : register(t0);
-Texture2D	gDiffuseMapWire : register(t1);
+// Slice 0 is the alpha flare, slice 1 the colored flare.
+Texture2DArray gFlareMaps : register(t0);
 
 //SamplerState gsamLinear  : register(s0);
 SamplerState gsamPointWrap        : register(s0);
@@ -110,8 +110,8 @@ VertexOut VS(VertexIn vin)
 
 float4 PS(VertexOut pin) : SV_Target
 {
-	float4 diffuseAlbedo = gDiffuseMapWood.Sample(gsamLinear, pin.TexC) * gDiffuseAlbedo;
-	//float4 diffuseAlbedo = (gDiffuseMapWood.Sample(gsamAnisotropicWrap, pin.TexC) * gDiffuseMapWire.Sample(gsamAnisotropicWrap, pin.TexC)) * gDiffuseAlbedo;
+	float4 diffuseAlbedo = gFlareMaps.Sample(gsamLinearWrap, float3(pin.TexC, 0.0f)) * gDiffuseAlbedo;
+	//float4 diffuseAlbedo = (gFlareMaps.Sample(gsamAnisotropicWrap, float3(pin.TexC, 0.0f)) * gFlareMaps.Sample(gsamAnisotropicWrap, float3(pin.TexC, 1.0f))) * gDiffuseAlbedo;
 
 	// Interpolating normal can unnormalize it, so renormalize it.
 	pin.NormalW = normalize(pin.NormalW);
@@ -8,6 +8,7 @@
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/MeshUtil.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -609,6 +610,7 @@ void ShapesApp::BuildShapeGeometry()
 	geo->DrawArgs["grid"] = gridSubmesh;
 	geo->DrawArgs["sphere"] = sphereSubmesh;
 	geo->DrawArgs["cylinder"] = cylinderSubmesh;
+	MeshUtil::ComputeSubmeshBounds(*geo);
 
 	mGeometries[geo->Name] = std::move(geo);
 }
@@ -677,6 +679,7 @@ void ShapesApp::BuildSkullGeometry()
 	submesh.BaseVertexLocation = 0;
 
 	geo->DrawArgs["skull"] = submesh;
+	MeshUtil::ComputeSubmeshBounds(*geo);
 
 	mGeometries[geo->Name] = std::move(geo);
 }
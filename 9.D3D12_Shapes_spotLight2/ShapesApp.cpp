@@ -8,6 +8,9 @@
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/MeshCache.h"
+#include "../Common/MeshUtil.h"
+#include "../Common/PrimitiveLODSet.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -48,6 +51,16 @@ struct RenderItem
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+	// Bounds of the submesh in local space, and the same bounds moved by World.
+	BoundingBox Bounds;
+	BoundingSphere SphereBounds;
+	BoundingBox WorldBounds;
+	BoundingSphere WorldSphereBounds;
+
+	// Tessellation levels to pick the draw arguments from each frame, or null if the
+	// item always draws the same submesh.
+	const PrimitiveLODSet* LODs = nullptr;
 };
 
 class ShapesApp : public D3DApp
@@ -71,6 +84,8 @@ private:
 
     void OnKeyboardInput(const GameTimer& gt);
 	void UpdateCamera(const GameTimer& gt);
+	void UpdateWorldBounds(const GameTimer& gt);
+	void UpdateLODs(const GameTimer& gt);
 	void AnimateMaterials(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
@@ -99,6 +114,7 @@ private:
 	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
 
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
+	std::unordered_map<std::string, std::unique_ptr<PrimitiveLODSet>> mLODSets;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
@@ -119,6 +135,9 @@ private:
 	XMFLOAT4X4 mView = MathHelper::Identity4x4();
 	XMFLOAT4X4 mProj = MathHelper::Identity4x4();
 
+	// Vertical field of view of mProj.
+	float mFovY = 0.25f*MathHelper::Pi;
+
     float mTheta = 1.5f*XM_PI;
     float mPhi = 0.2f*XM_PI;
     float mRadius = 15.0f;
@@ -187,6 +206,17 @@ bool ShapesApp::Initialize()
     // Wait until initialization is complete.
     FlushCommandQueue();
 
+	// The GPU has the geometry now; release the CPU copies the policies do not keep.
+	for(auto& e : mGeometries)
+		e.second->ReleaseCpuGeometry();
+
+	MeshCache::CpuGeometryStats cpuGeometry = MeshCache::GetCpuGeometryStats(mGeometries);
+	std::wstring text = L"CPU geometry: " +
+		std::to_wstring(cpuGeometry.ResidentMeshCount) + L"/" + std::to_wstring(cpuGeometry.MeshCount) + L" meshes resident, " +
+		std::to_wstring(cpuGeometry.OwnedBytes) + L" bytes owned, " +
+		std::to_wstring(cpuGeometry.MappedBytes) + L" bytes mapped\n";
+	OutputDebugString(text.c_str());
+
     return true;
 }
  
@@ -195,7 +225,7 @@ void ShapesApp::OnResize()
     D3DApp::OnResize();
 
     // The window resized, so update the aspect ratio and recompute the projection matrix.
-    XMMATRIX P = XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
+    XMMATRIX P = XMMatrixPerspectiveFovLH(mFovY, AspectRatio(), 1.0f, 1000.0f);
     XMStoreFloat4x4(&mProj, P);
 }
 
@@ -203,6 +233,8 @@ void ShapesApp::Update(const GameTimer& gt)
 {
     OnKeyboardInput(gt);
 	UpdateCamera(gt);
+	UpdateWorldBounds(gt);
+	UpdateLODs(gt);
 
     // Cycle through the circular frame resource array.
     mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % gNumFrameResources;
@@ -347,6 +379,37 @@ void ShapesApp::UpdateCamera(const GameTimer& gt)
 	XMStoreFloat4x4(&mView, view);
 }
 
+void ShapesApp::UpdateWorldBounds(const GameTimer& gt)
+{
+	for(auto& e : mAllRitems)
+	{
+		XMMATRIX world = XMLoadFloat4x4(&e->World);
+		e->Bounds.Transform(e->WorldBounds, world);
+		e->SphereBounds.Transform(e->WorldSphereBounds, world);
+	}
+}
+
+void ShapesApp::UpdateLODs(const GameTimer& gt)
+{
+	XMVECTOR eyePos = XMLoadFloat3(&mEyePos);
+
+	for(auto& e : mAllRitems)
+	{
+		if(e->LODs == nullptr)
+			continue;
+
+		XMVECTOR center = XMLoadFloat3(&e->WorldSphereBounds.Center);
+		float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, eyePos)));
+
+		UINT level = e->LODs->SelectLevel(e->WorldSphereBounds.Radius, distance, mFovY, (float)mClientHeight);
+
+		const SubmeshGeometry& submesh = e->LODs->GetSubmesh(level);
+		e->IndexCount = submesh.IndexCount;
+		e->StartIndexLocation = submesh.StartIndexLocation;
+		e->BaseVertexLocation = submesh.BaseVertexLocation;
+	}
+}
+
 void ShapesApp::AnimateMaterials(const GameTimer& gt)
 {
 
@@ -503,8 +566,14 @@ void ShapesApp::BuildShapeGeometry()
     GeometryGenerator geoGen;
 	GeometryGenerator::MeshData box = geoGen.CreateBox(1.5f, 0.5f, 1.5f, 3);
 	GeometryGenerator::MeshData grid = geoGen.CreateGrid(20.0f, 30.0f, 60, 40);
-	GeometryGenerator::MeshData sphere = geoGen.CreateGeosphere(0.5f, 3);
-	GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
+
+	// The spheres and columns are drawn coarser as they get smaller on screen, so
+	// every tessellation level is packed into the buffers.
+	mLODSets["sphere"] = std::make_unique<PrimitiveLODSet>(PrimitiveLODSet::CreateGeosphere(0.5f, 3, 4));
+	mLODSets["cylinder"] = std::make_unique<PrimitiveLODSet>(PrimitiveLODSet::CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20, 4));
+
+	GeometryGenerator::MeshData sphere = mLODSets["sphere"]->Flatten();
+	GeometryGenerator::MeshData cylinder = mLODSets["cylinder"]->Flatten();
 
 	//
 	// We are concatenating all the geometry into one big vertex/index buffer.  So
@@ -536,16 +605,6 @@ void ShapesApp::BuildShapeGeometry()
 	gridSubmesh.StartIndexLocation = gridIndexOffset;
 	gridSubmesh.BaseVertexLocation = gridVertexOffset;
 
-	SubmeshGeometry sphereSubmesh;
-	sphereSubmesh.IndexCount = (UINT)sphere.Indices32.size();
-	sphereSubmesh.StartIndexLocation = sphereIndexOffset;
-	sphereSubmesh.BaseVertexLocation = sphereVertexOffset;
-
-	SubmeshGeometry cylinderSubmesh;
-	cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
-	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
-
 	//
 	// Extract the vertex elements we are interested in and pack the
 	// vertices of all the meshes into one vertex buffer.
@@ -615,76 +674,91 @@ void ShapesApp::BuildShapeGeometry()
 
 	geo->DrawArgs["box"] = boxSubmesh;
 	geo->DrawArgs["grid"] = gridSubmesh;
-	geo->DrawArgs["sphere"] = sphereSubmesh;
-	geo->DrawArgs["cylinder"] = cylinderSubmesh;
+	mLODSets["sphere"]->Register(*geo, "sphere", sphereIndexOffset, sphereVertexOffset);
+	mLODSets["cylinder"]->Register(*geo, "cylinder", cylinderIndexOffset, cylinderVertexOffset);
+
+	MeshUtil::ComputeSubmeshBounds(*geo);
+
+	// Generated on the fly and never read back on the CPU.
+	geo->CpuPolicy = CpuGeometryPolicy::Drop;
 
 	mGeometries[geo->Name] = std::move(geo);
 }
 
 void ShapesApp::BuildSkullGeometry()
 {
-	std::ifstream fin("Models/skull.txt");
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = "skullGeo";
 
-	if (!fin)
+	// Use the cooked copy of the model if it is still current; otherwise parse the
+	// text file and cook it for the next launch.
+	if(!MeshCache::Load(L"Models/skull.mesh", L"Models/skull.txt", sizeof(Vertex), *geo))
 	{
-		MessageBox(0, L"Models/skull.txt not found", 0, 0);
-		return;
-	}
+		GeometryGenerator::MeshData skull;
+		if(!MeshUtil::LoadTextModel(L"Models/skull.txt", skull))
+		{
+			MessageBox(0, L"Models/skull.txt not found", 0, 0);
+			return;
+		}
 
-	UINT vCount = 0;
-	UINT tCount = 0;
-	std::string ignore;
-	
-	fin >> ignore >> vCount;
-	fin >> ignore >> tCount;
-	fin >> ignore >> ignore >> ignore >> ignore;
+		// Merge any duplicate vertices the exporter left behind so they are neither
+		// uploaded nor shaded twice.
+		MeshUtil::WeldStats weld;
+		if(!MeshUtil::WeldVertices(skull, 1e-4f, weld))
+		{
+			MessageBox(0, L"Models/skull.txt has invalid indices", 0, 0);
+			return;
+		}
 
-	std::vector<Vertex> vertices(vCount);
-	for (UINT i = 0; i < vCount; i++) 
-	{
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-	}
-	fin >> ignore >> ignore >> ignore;
+		std::wstring text = L"Skull weld: " +
+			std::to_wstring(weld.VertexCountBefore) + L" -> " + std::to_wstring(weld.VertexCountAfter) + L" vertices, " +
+			std::to_wstring(weld.BytesSaved) + L" bytes saved\n";
+		OutputDebugString(text.c_str());
 
-	std::vector<std::int32_t> indices(3 * tCount);
+		std::vector<Vertex> vertices(skull.Vertices.size());
+		for(size_t i = 0; i < skull.Vertices.size(); ++i)
+		{
+			vertices[i].Pos = skull.Vertices[i].Position;
+			vertices[i].Normal = skull.Vertices[i].Normal;
+		}
 
-	for(UINT i = 0; i < tCount; i++) 
-	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-	}
+		std::vector<std::uint32_t> indices = std::move(skull.Indices32);
 
-	fin.close();
+		const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint32_t);
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(int32_t);
+		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "skullGeo";
+		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+		geo->VertexByteStride = sizeof(Vertex);
+		geo->VertexBufferByteSize = vbByteSize;
+		geo->IndexFormat = DXGI_FORMAT_R32_UINT;
+		geo->IndexBufferByteSize = ibByteSize;
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+		SubmeshGeometry submesh;
+		submesh.IndexCount = (UINT)indices.size();
+		submesh.StartIndexLocation = 0;
+		submesh.BaseVertexLocation = 0;
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+		geo->DrawArgs["skull"] = submesh;
+		MeshUtil::ComputeSubmeshBounds(*geo);
 
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+		if(MeshCache::Save(L"Models/skull.mesh", L"Models/skull.txt", *geo))
+			geo->CacheFile = L"Models/skull.mesh";
+	}
 
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R32_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
+	// The cooked file can be mapped again if something wants the triangles back; without
+	// one the copy is simply kept.
+	geo->CpuPolicy = geo->CacheFile.empty() ? CpuGeometryPolicy::Keep : CpuGeometryPolicy::Remap;
 
-	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
+		mCommandList.Get(), geo->VertexBufferCPU->GetBufferPointer(), geo->VertexBufferByteSize, geo->VertexBufferUploader);
 
-	geo->DrawArgs["skull"] = submesh;
+	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
+		mCommandList.Get(), geo->IndexBufferCPU->GetBufferPointer(), geo->IndexBufferByteSize, geo->IndexBufferUploader);
 
 	mGeometries[geo->Name] = std::move(geo);
 }
@@ -784,6 +858,8 @@ void ShapesApp::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].Bounds;
+	boxRitem->SphereBounds = boxRitem->Geo->DrawArgs["box"].SphereBounds;
 	mAllRitems.push_back(std::move(boxRitem));
 
     auto gridRitem = std::make_unique<RenderItem>();
@@ -796,6 +872,8 @@ void ShapesApp::BuildRenderItems()
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+    gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
+    gridRitem->SphereBounds = gridRitem->Geo->DrawArgs["grid"].SphereBounds;
 	mAllRitems.push_back(std::move(gridRitem));
 
 	auto skullRitem = std::make_unique<RenderItem>();
@@ -808,6 +886,8 @@ void ShapesApp::BuildRenderItems()
 	skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
 	skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
 	skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+	skullRitem->Bounds = skullRitem->Geo->DrawArgs["skull"].Bounds;
+	skullRitem->SphereBounds = skullRitem->Geo->DrawArgs["skull"].SphereBounds;
 	mAllRitems.push_back(std::move(skullRitem));
 
 	XMMATRIX brickTexTransform = XMMatrixScaling(1.0f, 1.0f, 1.0f);
@@ -831,9 +911,12 @@ void ShapesApp::BuildRenderItems()
 		leftCylRitem->Mat = mMaterials["bricks0"].get();
 		leftCylRitem->Geo = mGeometries["shapeGeo"].get();
 		leftCylRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
-		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
-		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder_lod0"].IndexCount;
+		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder_lod0"].StartIndexLocation;
+		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder_lod0"].BaseVertexLocation;
+		leftCylRitem->Bounds = leftCylRitem->Geo->DrawArgs["cylinder_lod0"].Bounds;
+		leftCylRitem->SphereBounds = leftCylRitem->Geo->DrawArgs["cylinder_lod0"].SphereBounds;
+		leftCylRitem->LODs = mLODSets["cylinder"].get();
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -841,9 +924,12 @@ void ShapesApp::BuildRenderItems()
 		rightCylRitem->Mat = mMaterials["bricks0"].get();
 		rightCylRitem->Geo = mGeometries["shapeGeo"].get();
 		rightCylRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
-		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
-		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder_lod0"].IndexCount;
+		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder_lod0"].StartIndexLocation;
+		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder_lod0"].BaseVertexLocation;
+		rightCylRitem->Bounds = rightCylRitem->Geo->DrawArgs["cylinder_lod0"].Bounds;
+		rightCylRitem->SphereBounds = rightCylRitem->Geo->DrawArgs["cylinder_lod0"].SphereBounds;
+		rightCylRitem->LODs = mLODSets["cylinder"].get();
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -851,9 +937,12 @@ void ShapesApp::BuildRenderItems()
 		leftSphereRitem->Mat = mMaterials["stone0"].get();
 		leftSphereRitem->Geo = mGeometries["shapeGeo"].get();
 		leftSphereRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
-		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
-		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere_lod0"].IndexCount;
+		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere_lod0"].StartIndexLocation;
+		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere_lod0"].BaseVertexLocation;
+		leftSphereRitem->Bounds = leftSphereRitem->Geo->DrawArgs["sphere_lod0"].Bounds;
+		leftSphereRitem->SphereBounds = leftSphereRitem->Geo->DrawArgs["sphere_lod0"].SphereBounds;
+		leftSphereRitem->LODs = mLODSets["sphere"].get();
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
 		rightSphereRitem->TexTransform = MathHelper::Identity4x4();
@@ -861,9 +950,12 @@ void ShapesApp::BuildRenderItems()
 		rightSphereRitem->Mat = mMaterials["stone0"].get();
 		rightSphereRitem->Geo = mGeometries["shapeGeo"].get();
 		rightSphereRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
-		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
-		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere_lod0"].IndexCount;
+		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere_lod0"].StartIndexLocation;
+		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere_lod0"].BaseVertexLocation;
+		rightSphereRitem->Bounds = rightSphereRitem->Geo->DrawArgs["sphere_lod0"].Bounds;
+		rightSphereRitem->SphereBounds = rightSphereRitem->Geo->DrawArgs["sphere_lod0"].SphereBounds;
+		rightSphereRitem->LODs = mLODSets["sphere"].get();
 
 		mAllRitems.push_back(std::move(leftCylRitem));
 		mAllRitems.push_back(std::move(rightCylRitem));
@@ -0,0 +1,822 @@
+//***************************************************************************************
+// BCEncoder.cpp
+//***************************************************************************************
+
+#include "BCEncoder.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	// The texels of one block, one vector per channel and row of four texels, in 0..255.
+	struct Block
+	{
+		XMVECTOR Channels[4][4];
+	};
+
+	// Channels past channelCount are zero, so they take no part in the fit.
+	void LoadBlock(const std::uint8_t* texels, int channelCount, Block& block)
+	{
+		for(int c = 0; c < 4; ++c)
+		{
+			for(int row = 0; row < 4; ++row)
+			{
+				const std::uint8_t* t = texels + 16*row + c;
+				block.Channels[c][row] = c < channelCount ?
+					XMVectorSet(t[0], t[4], t[8], t[12]) : XMVectorZero();
+			}
+		}
+	}
+
+	XMFLOAT4A StoreLanes(FXMVECTOR v)
+	{
+		XMFLOAT4A f;
+		XMStoreFloat4A(&f, v);
+		return f;
+	}
+
+	float HorizontalSum(FXMVECTOR v)
+	{
+		const XMFLOAT4A f = StoreLanes(v);
+		return f.x + f.y + f.z + f.w;
+	}
+
+	///<summary>
+	/// Mean of the block and the direction of largest variance through it, found by power
+	/// iteration on the covariance matrix.  The axis is zero if all texels are equal.
+	///</summary>
+	void FitAxis(const Block& block, float mean[4], float axis[4])
+	{
+		for(int c = 0; c < 4; ++c)
+		{
+			XMVECTOR sum = XMVectorAdd(XMVectorAdd(block.Channels[c][0], block.Channels[c][1]),
+				XMVectorAdd(block.Channels[c][2], block.Channels[c][3]));
+			mean[c] = HorizontalSum(sum) / 16.0f;
+		}
+
+		float cov[4][4];
+		for(int a = 0; a < 4; ++a)
+		{
+			const XMVECTOR meanA = XMVectorReplicate(mean[a]);
+			for(int b = a; b < 4; ++b)
+			{
+				const XMVECTOR meanB = XMVectorReplicate(mean[b]);
+
+				XMVECTOR sum = XMVectorZero();
+				for(int row = 0; row < 4; ++row)
+				{
+					sum = XMVectorMultiplyAdd(XMVectorSubtract(block.Channels[a][row], meanA),
+						XMVectorSubtract(block.Channels[b][row], meanB), sum);
+				}
+
+				cov[a][b] = cov[b][a] = HorizontalSum(sum);
+			}
+		}
+
+		// Start from the channel with the largest variance; its covariance row cannot be
+		// orthogonal to the principal axis.
+		int start = 0;
+		for(int c = 1; c < 4; ++c)
+		{
+			if(cov[c][c] > cov[start][start])
+				start = c;
+		}
+
+		std::fill(axis, axis + 4, 0.0f);
+		if(cov[start][start] < 1e-3f)
+			return;
+
+		float v[4] = { cov[start][0], cov[start][1], cov[start][2], cov[start][3] };
+		for(int iteration = 0; iteration < 8; ++iteration)
+		{
+			float w[4];
+			float largest = 0.0f;
+			for(int c = 0; c < 4; ++c)
+			{
+				w[c] = cov[c][0]*v[0] + cov[c][1]*v[1] + cov[c][2]*v[2] + cov[c][3]*v[3];
+				largest = std::max<float>(largest, fabsf(w[c]));
+			}
+
+			if(largest < 1e-6f)
+				return;
+
+			for(int c = 0; c < 4; ++c)
+				v[c] = w[c] / largest;
+		}
+
+		const float length = sqrtf(v[0]*v[0] + v[1]*v[1] + v[2]*v[2] + v[3]*v[3]);
+		for(int c = 0; c < 4; ++c)
+			axis[c] = v[c] / length;
+	}
+
+	// Endpoints at the extremes of the texels projected onto the axis: e0 at the low end.
+	void ProjectEndpoints(const Block& block, const float mean[4], const float axis[4], float e0[4], float e1[4])
+	{
+		XMVECTOR lo = XMVectorReplicate(FLT_MAX);
+		XMVECTOR hi = XMVectorReplicate(-FLT_MAX);
+
+		for(int row = 0; row < 4; ++row)
+		{
+			XMVECTOR t = XMVectorZero();
+			for(int c = 0; c < 4; ++c)
+			{
+				t = XMVectorMultiplyAdd(XMVectorSubtract(block.Channels[c][row], XMVectorReplicate(mean[c])),
+					XMVectorReplicate(axis[c]), t);
+			}
+
+			lo = XMVectorMin(lo, t);
+			hi = XMVectorMax(hi, t);
+		}
+
+		const XMFLOAT4A l = StoreLanes(lo);
+		const XMFLOAT4A h = StoreLanes(hi);
+		const float minT = std::min<float>(std::min<float>(l.x, l.y), std::min<float>(l.z, l.w));
+		const float maxT = std::max<float>(std::max<float>(h.x, h.y), std::max<float>(h.z, h.w));
+
+		for(int c = 0; c < 4; ++c)
+		{
+			e0[c] = std::min<float>(std::max<float>(mean[c] + axis[c]*minT, 0.0f), 255.0f);
+			e1[c] = std::min<float>(std::max<float>(mean[c] + axis[c]*maxT, 0.0f), 255.0f);
+		}
+	}
+
+	///<summary>
+	/// Picks the nearest palette entry for every texel, comparing four texels at a time.
+	/// Returns the summed squared error.
+	///</summary>
+	float SelectIndices(const Block& block, const XMFLOAT4* palette, int paletteSize, std::uint8_t indices[16])
+	{
+		XMVECTOR bestError[4];
+		XMVECTOR bestIndex[4];
+		for(int row = 0; row < 4; ++row)
+		{
+			bestError[row] = XMVectorReplicate(FLT_MAX);
+			bestIndex[row] = XMVectorZero();
+		}
+
+		for(int k = 0; k < paletteSize; ++k)
+		{
+			const XMVECTOR p[4] =
+			{
+				XMVectorReplicate(palette[k].x), XMVectorReplicate(palette[k].y),
+				XMVectorReplicate(palette[k].z), XMVectorReplicate(palette[k].w)
+			};
+			const XMVECTOR index = XMVectorReplicate((float)k);
+
+			for(int row = 0; row < 4; ++row)
+			{
+				XMVECTOR error = XMVectorZero();
+				for(int c = 0; c < 4; ++c)
+				{
+					XMVECTOR d = XMVectorSubtract(block.Channels[c][row], p[c]);
+					error = XMVectorMultiplyAdd(d, d, error);
+				}
+
+				XMVECTOR closer = XMVectorLess(error, bestError[row]);
+				bestError[row] = XMVectorSelect(bestError[row], error, closer);
+				bestIndex[row] = XMVectorSelect(bestIndex[row], index, closer);
+			}
+		}
+
+		float total = 0.0f;
+		for(int row = 0; row < 4; ++row)
+		{
+			const XMFLOAT4A i = StoreLanes(bestIndex[row]);
+			indices[4*row + 0] = (std::uint8_t)i.x;
+			indices[4*row + 1] = (std::uint8_t)i.y;
+			indices[4*row + 2] = (std::uint8_t)i.z;
+			indices[4*row + 3] = (std::uint8_t)i.w;
+
+			total += HorizontalSum(bestError[row]);
+		}
+
+		return total;
+	}
+
+	///<summary>
+	/// Least squares endpoints for the given indices, where weights[i] is the share of e1
+	/// in palette entry i.  Returns false if every texel has the same weight.
+	///</summary>
+	bool FitEndpoints(const std::uint8_t* texels, int channelCount, const std::uint8_t indices[16],
+		const float* weights, float e0[4], float e1[4])
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float x0[4] = {};
+		float x1[4] = {};
+
+		for(int i = 0; i < 16; ++i)
+		{
+			const float b = weights[indices[i]];
+			const float a = 1.0f - b;
+
+			aa += a*a;
+			ab += a*b;
+			bb += b*b;
+
+			for(int c = 0; c < channelCount; ++c)
+			{
+				x0[c] += a*texels[4*i + c];
+				x1[c] += b*texels[4*i + c];
+			}
+		}
+
+		const float det = aa*bb - ab*ab;
+		if(fabsf(det) < 1e-6f)
+			return false;
+
+		for(int c = 0; c < 4; ++c)
+		{
+			e0[c] = std::min<float>(std::max<float>((bb*x0[c] - ab*x1[c]) / det, 0.0f), 255.0f);
+			e1[c] = std::min<float>(std::max<float>((aa*x1[c] - ab*x0[c]) / det, 0.0f), 255.0f);
+		}
+
+		return true;
+	}
+
+	///<summary>
+	/// Fits a pair of endpoints to the first channelCount channels of a block: starts at
+	/// the extremes along the principal axis and refines them by least squares.  quantize
+	/// rounds float endpoints to the format's, buildPalette expands a pair to paletteSize
+	/// colors, and weights[i] is the share of the second endpoint in color i.  Returns the
+	/// squared error of the best pair.
+	///</summary>
+	template<typename Endpoint, typename Quantize, typename BuildPalette>
+	float FitBlock(const std::uint8_t* texels, int channelCount, const float* weights, int paletteSize,
+		Quantize quantize, BuildPalette buildPalette, Endpoint& best0, Endpoint& best1, std::uint8_t bestIndices[16])
+	{
+		Block block;
+		LoadBlock(texels, channelCount, block);
+
+		float mean[4], axis[4], e0[4], e1[4];
+		FitAxis(block, mean, axis);
+		ProjectEndpoints(block, mean, axis, e0, e1);
+
+		Endpoint q0 = quantize(e0);
+		Endpoint q1 = quantize(e1);
+		float bestError = FLT_MAX;
+
+		for(int pass = 0; pass < 3; ++pass)
+		{
+			XMFLOAT4 palette[16];
+			buildPalette(q0, q1, palette);
+
+			std::uint8_t indices[16];
+			const float error = SelectIndices(block, palette, paletteSize, indices);
+			if(error < bestError)
+			{
+				bestError = error;
+				best0 = q0;
+				best1 = q1;
+				std::memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if(!FitEndpoints(texels, channelCount, indices, weights, e0, e1))
+				break;
+
+			q0 = quantize(e0);
+			q1 = quantize(e1);
+		}
+
+		return bestError;
+	}
+
+	//
+	// BC1 color block, also used by BC3.
+	//
+
+	// Share of color1 in each palette entry of the four color mode.
+	const float ColorWeights[4] = { 0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f };
+
+	std::uint16_t Quantize565(const float c[4])
+	{
+		const int r = std::min<int>(std::max<int>((int)(c[0]*31.0f/255.0f + 0.5f), 0), 31);
+		const int g = std::min<int>(std::max<int>((int)(c[1]*63.0f/255.0f + 0.5f), 0), 63);
+		const int b = std::min<int>(std::max<int>((int)(c[2]*31.0f/255.0f + 0.5f), 0), 31);
+		return (std::uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	XMFLOAT4 Expand565(std::uint16_t c)
+	{
+		const int r = (c >> 11) & 31;
+		const int g = (c >> 5) & 63;
+		const int b = c & 31;
+		return XMFLOAT4((float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)), 0.0f);
+	}
+
+	void BuildColorPalette(std::uint16_t c0, std::uint16_t c1, XMFLOAT4 palette[4])
+	{
+		palette[0] = Expand565(c0);
+		palette[1] = Expand565(c1);
+		palette[2] = XMFLOAT4((2.0f*palette[0].x + palette[1].x) / 3.0f, (2.0f*palette[0].y + palette[1].y) / 3.0f,
+			(2.0f*palette[0].z + palette[1].z) / 3.0f, 0.0f);
+		palette[3] = XMFLOAT4((palette[0].x + 2.0f*palette[1].x) / 3.0f, (palette[0].y + 2.0f*palette[1].y) / 3.0f,
+			(palette[0].z + 2.0f*palette[1].z) / 3.0f, 0.0f);
+	}
+
+	// Writes the 8 byte color block of BC1 and BC3, always in the four color mode.
+	void EncodeColorBlock(const std::uint8_t* texels, std::uint8_t* out)
+	{
+		std::uint16_t bestC0 = 0, bestC1 = 0;
+		std::uint8_t bestIndices[16];
+		FitBlock(texels, 3, ColorWeights, 4, Quantize565, BuildColorPalette, bestC0, bestC1, bestIndices);
+
+		// color0 > color1 selects the four color mode.  Swapping the endpoints swaps
+		// indices 0 and 1, and 2 and 3.
+		if(bestC0 < bestC1)
+		{
+			std::swap(bestC0, bestC1);
+			for(auto& i : bestIndices)
+				i ^= 1;
+		}
+		else if(bestC0 == bestC1)
+		{
+			std::fill(bestIndices, bestIndices + 16, (std::uint8_t)0);
+		}
+
+		std::uint32_t bits = 0;
+		for(int i = 0; i < 16; ++i)
+			bits |= (std::uint32_t)bestIndices[i] << (2*i);
+
+		out[0] = (std::uint8_t)(bestC0 & 0xff);
+		out[1] = (std::uint8_t)(bestC0 >> 8);
+		out[2] = (std::uint8_t)(bestC1 & 0xff);
+		out[3] = (std::uint8_t)(bestC1 >> 8);
+		for(int i = 0; i < 4; ++i)
+			out[4 + i] = (std::uint8_t)(bits >> (8*i));
+	}
+
+	// Writes the 8 byte BC4 style alpha block of BC3, in the eight value mode.
+	void EncodeAlphaBlock(const std::uint8_t* texels, std::uint8_t* out)
+	{
+		int lo = 255;
+		int hi = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			lo = std::min<int>(lo, texels[4*i + 3]);
+			hi = std::max<int>(hi, texels[4*i + 3]);
+		}
+
+		out[0] = (std::uint8_t)hi;
+		out[1] = (std::uint8_t)lo;
+
+		std::uint64_t bits = 0;
+		if(hi > lo)
+		{
+			int palette[8] = { hi, lo };
+			for(int k = 2; k < 8; ++k)
+				palette[k] = ((8 - k)*hi + (k - 1)*lo) / 7;
+
+			for(int i = 0; i < 16; ++i)
+			{
+				const int a = texels[4*i + 3];
+
+				int best = 0;
+				for(int k = 1; k < 8; ++k)
+				{
+					if(abs(palette[k] - a) < abs(palette[best] - a))
+						best = k;
+				}
+
+				bits |= (std::uint64_t)best << (3*i);
+			}
+		}
+
+		for(int i = 0; i < 6; ++i)
+			out[2 + i] = (std::uint8_t)(bits >> (8*i));
+	}
+
+	//
+	// BC7.  Mode 6 has one RGBA endpoint pair of seven bits plus a p-bit each, and 4-bit
+	// indices.  Mode 5 (without channel rotation) has separate RGB and alpha pairs with
+	// 2-bit indices each, for blocks whose alpha does not follow the color.
+	//
+
+	const int Mode6Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	const int Mode5Weights[4] = { 0, 21, 43, 64 };
+
+	struct Mode6Endpoint
+	{
+		int Q[4];
+
+		// Lowest bit of all four channels.
+		int P;
+	};
+
+	struct Mode5Endpoint
+	{
+		int Q[3];
+	};
+
+	Mode6Endpoint QuantizeMode6(const float e[4])
+	{
+		Mode6Endpoint best = {};
+		float bestError = FLT_MAX;
+
+		for(int p = 0; p < 2; ++p)
+		{
+			Mode6Endpoint q;
+			q.P = p;
+
+			float error = 0.0f;
+			for(int c = 0; c < 4; ++c)
+			{
+				q.Q[c] = std::min<int>(std::max<int>((int)floorf((e[c] - p) / 2.0f + 0.5f), 0), 127);
+
+				const float d = (float)((q.Q[c] << 1) | p) - e[c];
+				error += d*d;
+			}
+
+			if(error < bestError)
+			{
+				bestError = error;
+				best = q;
+			}
+		}
+
+		return best;
+	}
+
+	Mode5Endpoint QuantizeMode5(const float e[4])
+	{
+		Mode5Endpoint q;
+		for(int c = 0; c < 3; ++c)
+			q.Q[c] = std::min<int>(std::max<int>((int)(e[c]*127.0f/255.0f + 0.5f), 0), 127);
+
+		return q;
+	}
+
+	int Interpolate(int v0, int v1, int weight)
+	{
+		return ((64 - weight)*v0 + weight*v1 + 32) >> 6;
+	}
+
+	void BuildMode6Palette(const Mode6Endpoint& e0, const Mode6Endpoint& e1, XMFLOAT4 palette[16])
+	{
+		int v0[4], v1[4];
+		for(int c = 0; c < 4; ++c)
+		{
+			v0[c] = (e0.Q[c] << 1) | e0.P;
+			v1[c] = (e1.Q[c] << 1) | e1.P;
+		}
+
+		for(int k = 0; k < 16; ++k)
+		{
+			const int w = Mode6Weights[k];
+			palette[k] = XMFLOAT4((float)Interpolate(v0[0], v1[0], w), (float)Interpolate(v0[1], v1[1], w),
+				(float)Interpolate(v0[2], v1[2], w), (float)Interpolate(v0[3], v1[3], w));
+		}
+	}
+
+	void BuildMode5Palette(const Mode5Endpoint& e0, const Mode5Endpoint& e1, XMFLOAT4 palette[4])
+	{
+		// Seven bit channels expand by repeating their top bit.
+		int v0[3], v1[3];
+		for(int c = 0; c < 3; ++c)
+		{
+			v0[c] = (e0.Q[c] << 1) | (e0.Q[c] >> 6);
+			v1[c] = (e1.Q[c] << 1) | (e1.Q[c] >> 6);
+		}
+
+		for(int k = 0; k < 4; ++k)
+		{
+			const int w = Mode5Weights[k];
+			palette[k] = XMFLOAT4((float)Interpolate(v0[0], v1[0], w), (float)Interpolate(v0[1], v1[1], w),
+				(float)Interpolate(v0[2], v1[2], w), 0.0f);
+		}
+	}
+
+	// Appends fields to a zeroed block, least significant bit first.
+	struct BitWriter
+	{
+		std::uint8_t* Out;
+		int Position;
+
+		void Write(std::uint32_t value, int bitCount)
+		{
+			for(int i = 0; i < bitCount; ++i, ++Position)
+			{
+				if((value >> i) & 1)
+					Out[Position >> 3] |= (std::uint8_t)(1 << (Position & 7));
+			}
+		}
+	};
+
+	// The top bit of the first index of a pair is implied zero.  Swapping the endpoints
+	// mirrors the indices.
+	template<typename Endpoint>
+	void FixAnchor(Endpoint& e0, Endpoint& e1, std::uint8_t indices[16], int indexBits)
+	{
+		const int top = (1 << indexBits) - 1;
+		if(indices[0] & (1 << (indexBits - 1)))
+		{
+			std::swap(e0, e1);
+			for(int i = 0; i < 16; ++i)
+				indices[i] = (std::uint8_t)(top - indices[i]);
+		}
+	}
+
+	void WriteIndices(BitWriter& writer, const std::uint8_t indices[16], int indexBits)
+	{
+		writer.Write(indices[0], indexBits - 1);
+		for(int i = 1; i < 16; ++i)
+			writer.Write(indices[i], indexBits);
+	}
+
+	float EncodeMode6(const std::uint8_t* texels, std::uint8_t block[16])
+	{
+		float weights[16];
+		for(int k = 0; k < 16; ++k)
+			weights[k] = Mode6Weights[k] / 64.0f;
+
+		Mode6Endpoint e0 = {}, e1 = {};
+		std::uint8_t indices[16];
+		const float error = FitBlock(texels, 4, weights, 16, QuantizeMode6, BuildMode6Palette, e0, e1, indices);
+		FixAnchor(e0, e1, indices, 4);
+
+		std::memset(block, 0, 16);
+		BitWriter writer = { block, 0 };
+
+		writer.Write(1 << 6, 7);
+		for(int c = 0; c < 4; ++c)
+		{
+			writer.Write(e0.Q[c], 7);
+			writer.Write(e1.Q[c], 7);
+		}
+
+		writer.Write(e0.P, 1);
+		writer.Write(e1.P, 1);
+		WriteIndices(writer, indices, 4);
+
+		return error;
+	}
+
+	float EncodeMode5(const std::uint8_t* texels, std::uint8_t block[16])
+	{
+		float weights[4];
+		for(int k = 0; k < 4; ++k)
+			weights[k] = Mode5Weights[k] / 64.0f;
+
+		Mode5Endpoint e0 = {}, e1 = {};
+		std::uint8_t colorIndices[16];
+		float error = FitBlock(texels, 3, weights, 4, QuantizeMode5, BuildMode5Palette, e0, e1, colorIndices);
+		FixAnchor(e0, e1, colorIndices, 2);
+
+		// Alpha spans the range of the block.
+		int a0 = 255;
+		int a1 = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			a0 = std::min<int>(a0, texels[4*i + 3]);
+			a1 = std::max<int>(a1, texels[4*i + 3]);
+		}
+
+		std::uint8_t alphaIndices[16];
+		for(int i = 0; i < 16; ++i)
+		{
+			const int a = texels[4*i + 3];
+
+			int best = 0;
+			int bestError = 256;
+			for(int k = 0; k < 4; ++k)
+			{
+				const int d = abs(Interpolate(a0, a1, Mode5Weights[k]) - a);
+				if(d < bestError)
+				{
+					bestError = d;
+					best = k;
+				}
+			}
+
+			alphaIndices[i] = (std::uint8_t)best;
+			error += (float)(bestError*bestError);
+		}
+
+		FixAnchor(a0, a1, alphaIndices, 2);
+
+		std::memset(block, 0, 16);
+		BitWriter writer = { block, 0 };
+
+		writer.Write(1 << 5, 6);
+		writer.Write(0, 2);
+		for(int c = 0; c < 3; ++c)
+		{
+			writer.Write(e0.Q[c], 7);
+			writer.Write(e1.Q[c], 7);
+		}
+
+		writer.Write(a0, 8);
+		writer.Write(a1, 8);
+		WriteIndices(writer, colorIndices, 2);
+		WriteIndices(writer, alphaIndices, 2);
+
+		return error;
+	}
+
+	typedef void (*BlockEncoder)(const std::uint8_t* texels, std::uint8_t* block);
+
+	bool GetBlockEncoder(DXGI_FORMAT format, BlockEncoder& encoder)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			encoder = &BCEncoder::EncodeBC1;
+			return true;
+
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			encoder = &BCEncoder::EncodeBC3;
+			return true;
+
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			encoder = &BCEncoder::EncodeBC7;
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	bool IsBGRA(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	}
+
+	// Reads the 4x4 block at (x, y) as RGBA, repeating the last row and column past the edges.
+	void GatherBlock(const DDSSubresource& sub, std::size_t x, std::size_t y, bool bgra, std::uint8_t texels[64])
+	{
+		for(std::size_t j = 0; j < 4; ++j)
+		{
+			const std::uint8_t* row = sub.Data + std::min<std::size_t>(y + j, sub.Height - 1)*sub.RowPitch;
+			for(std::size_t i = 0; i < 4; ++i)
+			{
+				const std::uint8_t* p = row + 4*std::min<std::size_t>(x + i, sub.Width - 1);
+				std::uint8_t* t = texels + 16*j + 4*i;
+
+				t[0] = bgra ? p[2] : p[0];
+				t[1] = p[1];
+				t[2] = bgra ? p[0] : p[2];
+				t[3] = p[3];
+			}
+		}
+	}
+}
+
+bool BCEncoder::IsSupported(DXGI_FORMAT format)
+{
+	BlockEncoder encoder;
+	return GetBlockEncoder(format, encoder);
+}
+
+bool BCEncoder::IsSupportedSource(DXGI_FORMAT format)
+{
+	switch(format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void BCEncoder::EncodeBC1(const std::uint8_t texels[64], std::uint8_t block[8])
+{
+	EncodeColorBlock(texels, block);
+}
+
+void BCEncoder::EncodeBC3(const std::uint8_t texels[64], std::uint8_t block[16])
+{
+	EncodeAlphaBlock(texels, block);
+	EncodeColorBlock(texels, block + 8);
+}
+
+void BCEncoder::EncodeBC7(const std::uint8_t texels[64], std::uint8_t block[16])
+{
+	const float error = EncodeMode6(texels, block);
+
+	bool opaque = true;
+	for(int i = 0; i < 16; ++i)
+		opaque = opaque && texels[4*i + 3] == 255;
+
+	// Mode 5 only pays off when the alpha varies independently of the color.
+	if(!opaque)
+	{
+		std::uint8_t mode5[16];
+		if(EncodeMode5(texels, mode5) < error)
+			std::memcpy(block, mode5, 16);
+	}
+}
+
+bool BCEncoder::Compress(const DDSImage& source, DXGI_FORMAT format, DDSImage& result, TaskPool& pool)
+{
+	BlockEncoder encoder;
+	if(!GetBlockEncoder(format, encoder) || !IsSupportedSource(source.Format))
+		return false;
+
+	if(source.Dimension != DDS_DIMENSION_TEXTURE2D || source.Depth > 1 ||
+		source.Subresources.size() != source.MipCount*source.ArraySize || source.Subresources.empty())
+	{
+		return false;
+	}
+
+	const bool bgra = IsBGRA(source.Format);
+	const std::size_t blockSize = DDSParser::BitsPerPixel(format) * 2;
+
+	DDSImage image;
+	image.Dimension = source.Dimension;
+	image.Format = format;
+	image.Width = source.Width;
+	image.Height = source.Height;
+	image.Depth = 1;
+	image.MipCount = source.MipCount;
+	image.ArraySize = source.ArraySize;
+	image.IsCubeMap = source.IsCubeMap;
+
+	std::vector<std::size_t> offsets;
+	std::size_t byteSize = 0;
+	for(const auto& src : source.Subresources)
+	{
+		DDSSubresource sub;
+		sub.Width = src.Width;
+		sub.Height = src.Height;
+		sub.Depth = 1;
+		DDSParser::GetSurfaceInfo(sub.Width, sub.Height, format, &sub.SlicePitch, &sub.RowPitch, &sub.NumRows);
+
+		offsets.push_back(byteSize);
+		byteSize += sub.SlicePitch;
+
+		image.Subresources.push_back(sub);
+	}
+
+	auto memory = std::make_shared<std::vector<std::uint8_t>>(byteSize);
+	for(std::size_t k = 0; k < image.Subresources.size(); ++k)
+		image.Subresources[k].Data = memory->data() + offsets[k];
+
+	// Every row of blocks of every subresource is one job.
+	std::vector<std::pair<std::size_t, std::size_t>> rows;
+	for(std::size_t k = 0; k < image.Subresources.size(); ++k)
+	{
+		for(std::size_t y = 0; y < image.Subresources[k].NumRows; ++y)
+			rows.push_back(std::make_pair(k, y));
+	}
+
+	pool.ParallelFor(rows.size(), 1, [&](std::size_t begin, std::size_t end)
+	{
+		std::uint8_t texels[64];
+		for(std::size_t r = begin; r < end; ++r)
+		{
+			const DDSSubresource& src = source.Subresources[rows[r].first];
+			const DDSSubresource& dst = image.Subresources[rows[r].first];
+			std::uint8_t* out = memory->data() + offsets[rows[r].first] + rows[r].second*dst.RowPitch;
+
+			for(std::size_t x = 0; x*blockSize < dst.RowPitch; ++x)
+			{
+				GatherBlock(src, 4*x, 4*rows[r].second, bgra, texels);
+				encoder(texels, out + x*blockSize);
+			}
+		}
+	});
+
+	image.BitData = memory->data();
+	image.BitSize = byteSize;
+	image.Memory = memory;
+
+	// Only now, since result may be source.
+	result = std::move(image);
+
+	return true;
+}
+
+bool BCEncoder::IsOpaque(const DDSImage& image)
+{
+	if(!IsSupportedSource(image.Format) || image.Subresources.size() != image.MipCount*image.ArraySize)
+		return false;
+
+	for(std::size_t j = 0; j < image.ArraySize; ++j)
+	{
+		const DDSSubresource& top = image.Subresources[j*image.MipCount];
+		for(std::size_t y = 0; y < top.Height; ++y)
+		{
+			const std::uint8_t* row = top.Data + y*top.RowPitch;
+			for(std::size_t x = 0; x < top.Width; ++x)
+			{
+				if(row[4*x + 3] != 255)
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
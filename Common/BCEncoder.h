@@ -0,0 +1,46 @@
+//***************************************************************************************
+// BCEncoder.h
+//
+// CPU block compression of RGBA8/BGRA8 images to BC1, BC3 and BC7, for the offline
+// texture cooker.  Endpoints are fitted along the principal axis of each block's colors
+// and refined by least squares; the per-texel work runs on four texels at a time in
+// DirectXMath vectors.  BC7 is written in mode 6 (one RGBA subset, 4-bit indices).
+//
+// Compress() splits the rows of blocks of every subresource over a TaskPool.  Like
+// DDSParser, nothing here touches Direct3D.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+#include "TaskPool.h"
+
+class BCEncoder
+{
+public:
+	// True for BC1, BC3 and BC7, UNORM or SRGB.
+	static bool IsSupported(DXGI_FORMAT format);
+
+	// True for the formats Compress() reads: RGBA8 and BGRA8, UNORM or SRGB.
+	static bool IsSupportedSource(DXGI_FORMAT format);
+
+	///<summary>
+	/// Compresses one block of 4x4 RGBA texels, stored row by row.  BC1 ignores alpha.
+	///</summary>
+	static void EncodeBC1(const std::uint8_t texels[64], std::uint8_t block[8]);
+	static void EncodeBC3(const std::uint8_t texels[64], std::uint8_t block[16]);
+	static void EncodeBC7(const std::uint8_t texels[64], std::uint8_t block[16]);
+
+	///<summary>
+	/// Compresses every mip of every slice of a 2D texture, array or cube to format.
+	/// Colors are encoded as stored, so pick an _SRGB format for sRGB data.  Edge blocks
+	/// of sizes that are not a multiple of four repeat the last row and column.
+	/// Returns false if a format or the dimension is not supported.  result owns its
+	/// blocks and may be source itself.
+	///</summary>
+	static bool Compress(const DDSImage& source, DXGI_FORMAT format, DDSImage& result,
+		TaskPool& pool = TaskPool::Default());
+
+	// True if every texel of the top mips has an alpha of 255, so BC1 loses nothing.
+	static bool IsOpaque(const DDSImage& image);
+};
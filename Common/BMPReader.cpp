@@ -0,0 +1,139 @@
+//***************************************************************************************
+// BMPReader.cpp
+//***************************************************************************************
+
+#include "BMPReader.h"
+#include <cstring>
+
+namespace
+{
+	#pragma pack(push,1)
+
+	struct BitmapFileHeader
+	{
+		std::uint16_t Type;
+		std::uint32_t Size;
+		std::uint16_t Reserved1;
+		std::uint16_t Reserved2;
+		std::uint32_t OffBits;
+	};
+
+	struct BitmapInfoHeader
+	{
+		std::uint32_t Size;
+		std::int32_t Width;
+		std::int32_t Height;
+		std::uint16_t Planes;
+		std::uint16_t BitCount;
+		std::uint32_t Compression;
+		std::uint32_t SizeImage;
+		std::int32_t XPelsPerMeter;
+		std::int32_t YPelsPerMeter;
+		std::uint32_t ClrUsed;
+		std::uint32_t ClrImportant;
+	};
+
+	#pragma pack(pop)
+
+	const std::uint16_t BitmapMagic = 0x4d42; // "BM"
+	const std::uint32_t BitmapRGB = 0;        // BI_RGB
+	const std::uint32_t BitmapBitFields = 3;  // BI_BITFIELDS
+}
+
+DDSParser::Result BMPReader::ParseMemory(const std::uint8_t* data, std::size_t byteSize, DDSImage& image)
+{
+	image = DDSImage();
+
+	if(byteSize < sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader))
+		return DDSParser::Result::InvalidData;
+
+	BitmapFileHeader fileHeader;
+	BitmapInfoHeader info;
+	std::memcpy(&fileHeader, data, sizeof(fileHeader));
+	std::memcpy(&info, data + sizeof(fileHeader), sizeof(info));
+
+	if(fileHeader.Type != BitmapMagic || info.Size < sizeof(BitmapInfoHeader) || info.Width <= 0 || info.Height == 0)
+		return DDSParser::Result::InvalidData;
+
+	// BI_BITFIELDS is accepted for 32 bit files with the usual BGRA masks, which is what
+	// most tools write.
+	const std::uint8_t* masks = data + sizeof(fileHeader) + sizeof(info);
+	const std::uint32_t standardMasks[3] = { 0x00ff0000, 0x0000ff00, 0x000000ff };
+	const bool bitFields = info.Compression == BitmapBitFields && info.BitCount == 32 &&
+		(std::size_t)(masks - data) + sizeof(standardMasks) <= byteSize &&
+		std::memcmp(masks, standardMasks, sizeof(standardMasks)) == 0;
+
+	if((info.BitCount != 24 && info.BitCount != 32) || (info.Compression != BitmapRGB && !bitFields))
+		return DDSParser::Result::NotSupported;
+
+	// Positive heights are stored bottom row first.
+	const bool bottomUp = info.Height > 0;
+	const std::size_t width = (std::size_t)info.Width;
+	const std::size_t height = bottomUp ? (std::size_t)info.Height : (std::size_t)(-(std::int64_t)info.Height);
+	const std::size_t texelSize = info.BitCount / 8;
+	const std::size_t srcPitch = (width*texelSize + 3) & ~(std::size_t)3;
+
+	if(fileHeader.OffBits > byteSize || srcPitch*height > byteSize - fileHeader.OffBits)
+		return DDSParser::Result::EndOfFile;
+
+	DDSSubresource sub;
+	sub.Width = width;
+	sub.Height = height;
+	sub.Depth = 1;
+	sub.RowPitch = width*4;
+	sub.SlicePitch = sub.RowPitch*height;
+	sub.NumRows = height;
+
+	auto memory = std::make_shared<std::vector<std::uint8_t>>(sub.SlicePitch);
+
+	bool anyAlpha = false;
+	for(std::size_t y = 0; y < height; ++y)
+	{
+		const std::uint8_t* src = data + fileHeader.OffBits + (bottomUp ? height - 1 - y : y)*srcPitch;
+		std::uint8_t* dst = memory->data() + y*sub.RowPitch;
+
+		for(std::size_t x = 0; x < width; ++x)
+		{
+			dst[4*x + 0] = src[texelSize*x + 0];
+			dst[4*x + 1] = src[texelSize*x + 1];
+			dst[4*x + 2] = src[texelSize*x + 2];
+			dst[4*x + 3] = texelSize == 4 ? src[4*x + 3] : 255;
+
+			anyAlpha = anyAlpha || dst[4*x + 3] != 0;
+		}
+	}
+
+	// The fourth byte of BI_RGB files is often left zero rather than meaning transparent.
+	if(!anyAlpha)
+	{
+		for(std::size_t i = 3; i < memory->size(); i += 4)
+			(*memory)[i] = 255;
+	}
+
+	sub.Data = memory->data();
+
+	image.Dimension = DDS_DIMENSION_TEXTURE2D;
+	image.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+	image.Width = width;
+	image.Height = height;
+	image.Depth = 1;
+	image.MipCount = 1;
+	image.ArraySize = 1;
+	image.BitData = memory->data();
+	image.BitSize = memory->size();
+	image.Subresources.push_back(sub);
+	image.Memory = memory;
+
+	return DDSParser::Result::Ok;
+}
+
+DDSParser::Result BMPReader::ParseFile(const std::wstring& filename, DDSImage& image)
+{
+	image = DDSImage();
+
+	auto file = MappedFile::Open(filename);
+	if(file == nullptr)
+		return DDSParser::Result::FileNotFound;
+
+	return ParseMemory(file->Data(), (std::size_t)file->Size(), image);
+}
@@ -0,0 +1,23 @@
+//***************************************************************************************
+// BMPReader.h
+//
+// Reads uncompressed 24 and 32 bit Windows bitmaps into a single mip B8G8R8A8_UNORM
+// DDSImage, so the texture tools can treat them like DDS files.  Like DDSParser, it
+// does not depend on Direct3D.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+
+class BMPReader
+{
+public:
+	///<summary>
+	/// Decodes a BMP file held in memory.  The image owns a copy of the texels, stored
+	/// top row first.  32 bit files whose alpha bytes are all zero are read as opaque.
+	///</summary>
+	static DDSParser::Result ParseMemory(const std::uint8_t* data, std::size_t byteSize, DDSImage& image);
+
+	static DDSParser::Result ParseFile(const std::wstring& filename, DDSImage& image);
+};
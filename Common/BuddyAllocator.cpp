@@ -0,0 +1,120 @@
+//***************************************************************************************
+// BuddyAllocator.cpp
+//***************************************************************************************
+
+#include "BuddyAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+const std::uint64_t BuddyAllocator::InvalidOffset;
+
+BuddyAllocator::BuddyAllocator(std::uint64_t capacity, std::uint64_t minBlockSize)
+	: mCapacity(capacity), mMinBlockSize(minBlockSize)
+{
+	assert(minBlockSize > 0 && (minBlockSize & (minBlockSize - 1)) == 0);
+	assert(capacity >= minBlockSize && (capacity & (capacity - 1)) == 0);
+
+	while(GetBlockSize(mMaxOrder) < capacity)
+		++mMaxOrder;
+
+	mFreeBlocks.resize(mMaxOrder + 1);
+	mFreeBlocks[mMaxOrder].insert(0);
+}
+
+std::uint64_t BuddyAllocator::Allocate(std::uint64_t byteSize, std::uint64_t alignment)
+{
+	const std::uint64_t needed = std::max<std::uint64_t>(std::max<std::uint64_t>(byteSize, alignment), 1);
+	if(needed > mCapacity)
+		return InvalidOffset;
+
+	std::uint32_t order = 0;
+	while(GetBlockSize(order) < needed)
+		++order;
+
+	// Smallest free block that fits, split down to the order asked for.
+	std::uint32_t source = order;
+	while(source <= mMaxOrder && mFreeBlocks[source].empty())
+		++source;
+	if(source > mMaxOrder)
+		return InvalidOffset;
+
+	const std::uint64_t offset = *mFreeBlocks[source].begin();
+	mFreeBlocks[source].erase(mFreeBlocks[source].begin());
+
+	while(source > order)
+	{
+		--source;
+		mFreeBlocks[source].insert(offset + GetBlockSize(source));
+	}
+
+	Block block;
+	block.Order = order;
+	block.RequestedBytes = byteSize;
+	mAllocated[offset] = block;
+
+	mRequestedBytes += byteSize;
+	mAllocatedBytes += GetBlockSize(order);
+	return offset;
+}
+
+void BuddyAllocator::Free(std::uint64_t offset)
+{
+	auto it = mAllocated.find(offset);
+	assert(it != mAllocated.end());
+	if(it == mAllocated.end())
+		return;
+
+	std::uint32_t order = it->second.Order;
+	mRequestedBytes -= it->second.RequestedBytes;
+	mAllocatedBytes -= GetBlockSize(order);
+	mAllocated.erase(it);
+
+	while(order < mMaxOrder)
+	{
+		const std::uint64_t buddy = offset ^ GetBlockSize(order);
+		auto found = mFreeBlocks[order].find(buddy);
+		if(found == mFreeBlocks[order].end())
+			break;
+
+		mFreeBlocks[order].erase(found);
+		offset = std::min<std::uint64_t>(offset, buddy);
+		++order;
+	}
+
+	mFreeBlocks[order].insert(offset);
+}
+
+BuddyAllocator::Stats BuddyAllocator::GetStats()const
+{
+	Stats stats;
+	stats.Capacity = mCapacity;
+	stats.RequestedBytes = mRequestedBytes;
+	stats.AllocatedBytes = mAllocatedBytes;
+	stats.AllocationCount = mAllocated.size();
+
+	for(std::uint32_t order = 0; order <= mMaxOrder; ++order)
+	{
+		const std::uint64_t count = mFreeBlocks[order].size();
+		stats.FreeBlockCount += count;
+		stats.FreeBytes += count * GetBlockSize(order);
+		if(count > 0)
+			stats.LargestFreeBlock = GetBlockSize(order);
+	}
+
+	return stats;
+}
+
+std::uint64_t BuddyAllocator::GetCapacity()const
+{
+	return mCapacity;
+}
+
+bool BuddyAllocator::IsEmpty()const
+{
+	return mAllocated.empty();
+}
+
+std::uint64_t BuddyAllocator::GetBlockSize(std::uint32_t order)const
+{
+	return mMinBlockSize << order;
+}
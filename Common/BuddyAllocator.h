@@ -0,0 +1,81 @@
+//***************************************************************************************
+// BuddyAllocator.h
+//
+// Buddy allocator over an abstract range of offsets [0, capacity), used by GeometryHeap
+// to pack buffers into placed resources.  Blocks are powers of two from minBlockSize up
+// to the capacity, so every block is aligned to its own size, and a freed block merges
+// with its buddy as soon as both halves are free.  Nothing here touches Direct3D.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class BuddyAllocator
+{
+public:
+	static const std::uint64_t InvalidOffset = ~0ull;
+
+	struct Stats
+	{
+		std::uint64_t Capacity = 0;
+
+		// Bytes asked for, and bytes of the blocks handed out for them; the difference is
+		// lost to rounding up to powers of two.
+		std::uint64_t RequestedBytes = 0;
+		std::uint64_t AllocatedBytes = 0;
+		std::uint64_t AllocationCount = 0;
+
+		std::uint64_t FreeBytes = 0;
+		std::uint64_t FreeBlockCount = 0;
+		std::uint64_t LargestFreeBlock = 0;
+
+		// 0 when all free memory is one block, approaching 1 as it splinters.
+		float GetFragmentation()const
+		{
+			return FreeBytes > 0 ? 1.0f - (float)LargestFreeBlock / (float)FreeBytes : 0.0f;
+		}
+	};
+
+	// capacity and minBlockSize are powers of two, minBlockSize <= capacity.
+	BuddyAllocator(std::uint64_t capacity, std::uint64_t minBlockSize);
+
+	///<summary>
+	/// Returns the offset of a block of at least byteSize bytes aligned to alignment (a
+	/// power of two), or InvalidOffset if no free block is large enough.  The lowest
+	/// free block of the right size is used, which keeps allocations packed.
+	///</summary>
+	std::uint64_t Allocate(std::uint64_t byteSize, std::uint64_t alignment = 1);
+
+	// Frees the block that Allocate() returned at offset.
+	void Free(std::uint64_t offset);
+
+	Stats GetStats()const;
+
+	std::uint64_t GetCapacity()const;
+	bool IsEmpty()const;
+
+private:
+	std::uint64_t GetBlockSize(std::uint32_t order)const;
+
+private:
+	std::uint64_t mCapacity = 0;
+	std::uint64_t mMinBlockSize = 0;
+	std::uint32_t mMaxOrder = 0;
+
+	// Offsets of the free blocks of each order; order 0 holds blocks of minBlockSize.
+	std::vector<std::set<std::uint64_t>> mFreeBlocks;
+
+	struct Block
+	{
+		std::uint32_t Order = 0;
+		std::uint64_t RequestedBytes = 0;
+	};
+
+	std::unordered_map<std::uint64_t, Block> mAllocated;
+	std::uint64_t mRequestedBytes = 0;
+	std::uint64_t mAllocatedBytes = 0;
+};
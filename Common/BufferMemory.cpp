@@ -0,0 +1,71 @@
+//***************************************************************************************
+// BufferMemory.cpp
+//***************************************************************************************
+
+#include "BufferMemory.h"
+#include <algorithm>
+#include <cstring>
+
+const std::uint64_t BufferAllocation::Alignment;
+
+bool HostBufferMemory::CreateUploadBuffer(std::uint64_t byteSize, BufferAllocation& buffer)
+{
+	const std::uint64_t alignment = BufferAllocation::Alignment;
+
+	HostBuffer host;
+	host.Memory.reset(new std::uint8_t[(std::size_t)(byteSize + alignment)]);
+
+	const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(host.Memory.get());
+	host.Buffer.CPU = host.Memory.get() + ((alignment - base % alignment) % alignment);
+	host.Buffer.GPU = mNextGPU;
+	host.Buffer.Size = byteSize;
+
+	// Leave a gap after each buffer, as a device would, so addresses never run into
+	// the next one.
+	mNextGPU += (byteSize + alignment - 1) / alignment * alignment + alignment;
+
+	mLiveBytes += byteSize;
+	mPeakBytes = std::max<std::uint64_t>(mPeakBytes, mLiveBytes);
+
+	buffer = host.Buffer;
+	mBuffers.push_back(std::move(host));
+	return true;
+}
+
+bool HostBufferMemory::CreateDefaultBuffer(const void* initData, std::uint64_t byteSize, BufferAllocation& buffer)
+{
+	if(!CreateUploadBuffer(byteSize, buffer))
+		return false;
+
+	if(initData != nullptr && byteSize > 0)
+		std::memcpy(buffer.CPU, initData, (std::size_t)byteSize);
+	return true;
+}
+
+void HostBufferMemory::ReleaseBuffer(const BufferAllocation& buffer)
+{
+	for(auto it = mBuffers.begin(); it != mBuffers.end(); ++it)
+	{
+		if(it->Buffer.CPU == buffer.CPU)
+		{
+			mLiveBytes -= it->Buffer.Size;
+			mBuffers.erase(it);
+			return;
+		}
+	}
+}
+
+std::size_t HostBufferMemory::GetBufferCount()const
+{
+	return mBuffers.size();
+}
+
+std::uint64_t HostBufferMemory::GetLiveBytes()const
+{
+	return mLiveBytes;
+}
+
+std::uint64_t HostBufferMemory::GetPeakBytes()const
+{
+	return mPeakBytes;
+}
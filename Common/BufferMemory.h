@@ -0,0 +1,75 @@
+//***************************************************************************************
+// BufferMemory.h
+//
+// Where UploadBuffer, UploadRing and d3dUtil::CreateDefaultBuffer get their buffers
+// from.  BufferMemoryD3D12 creates committed resources; HostBufferMemory hands out plain
+// memory with made-up GPU addresses, so the code that fills constant and vertex buffers
+// every frame can run, and be profiled, without a device.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A buffer created by a BufferMemoryBackend.  CPU is the persistent mapping of an upload
+// buffer, and null for a default buffer unless the backend keeps it in host memory.  GPU
+// is the address views and root descriptors use; both are aligned to Alignment.
+// Resource is the ID3D12Resource of a BufferMemoryD3D12 buffer, owned by the backend
+// until ReleaseBuffer(), and null for host memory.
+struct BufferAllocation
+{
+	// D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT.
+	static const std::uint64_t Alignment = 64*1024;
+
+	std::uint8_t* CPU = nullptr;
+	std::uint64_t GPU = 0;
+	std::uint64_t Size = 0;
+	void* Resource = nullptr;
+};
+
+class BufferMemoryBackend
+{
+public:
+	virtual ~BufferMemoryBackend() = default;
+
+	// Creates a CPU-writable buffer, mapped until it is released.  Returns false if it
+	// could not.
+	virtual bool CreateUploadBuffer(std::uint64_t byteSize, BufferAllocation& buffer) = 0;
+
+	///<summary>
+	/// Creates a buffer only the GPU reads, holding the byteSize bytes at initData once
+	/// the work the backend records for it has run.  Returns false if it could not.
+	///</summary>
+	virtual bool CreateDefaultBuffer(const void* initData, std::uint64_t byteSize, BufferAllocation& buffer) = 0;
+
+	virtual void ReleaseBuffer(const BufferAllocation& buffer) = 0;
+};
+
+// Buffers of ordinary memory.  Default buffers are kept in host memory too and keep their
+// CPU pointer, so what would have been uploaded can be inspected.
+class HostBufferMemory : public BufferMemoryBackend
+{
+public:
+	virtual bool CreateUploadBuffer(std::uint64_t byteSize, BufferAllocation& buffer)override;
+	virtual bool CreateDefaultBuffer(const void* initData, std::uint64_t byteSize, BufferAllocation& buffer)override;
+	virtual void ReleaseBuffer(const BufferAllocation& buffer)override;
+
+	std::size_t GetBufferCount()const;
+	std::uint64_t GetLiveBytes()const;
+	std::uint64_t GetPeakBytes()const;
+
+private:
+	struct HostBuffer
+	{
+		std::unique_ptr<std::uint8_t[]> Memory;
+		BufferAllocation Buffer;
+	};
+
+	std::vector<HostBuffer> mBuffers;
+	std::uint64_t mNextGPU = BufferAllocation::Alignment;
+	std::uint64_t mLiveBytes = 0;
+	std::uint64_t mPeakBytes = 0;
+};
@@ -0,0 +1,87 @@
+//***************************************************************************************
+// BufferMemoryD3D12.cpp
+//***************************************************************************************
+
+#include "BufferMemoryD3D12.h"
+
+using Microsoft::WRL::ComPtr;
+
+BufferMemoryD3D12::BufferMemoryD3D12(ID3D12Device* device)
+	: md3dDevice(device)
+{
+}
+
+void BufferMemoryD3D12::SetCommandList(ID3D12GraphicsCommandList* cmdList)
+{
+	mCommandList = cmdList;
+}
+
+void BufferMemoryD3D12::ReleaseUploaders()
+{
+	mUploaders.clear();
+}
+
+bool BufferMemoryD3D12::CreateUploadBuffer(std::uint64_t byteSize, BufferAllocation& buffer)
+{
+	// Failures are returned, not thrown, so UploadRing can report a block it could not
+	// grow to as a null allocation.
+	OwnedBuffer owned;
+	if(FAILED(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&owned.Resource))))
+	{
+		return false;
+	}
+
+	// The CPU never reads the buffer back.
+	const CD3DX12_RANGE readRange(0, 0);
+	std::uint8_t* mappedData = nullptr;
+	if(FAILED(owned.Resource->Map(0, &readRange, reinterpret_cast<void**>(&mappedData))))
+		return false;
+	owned.Mapped = true;
+
+	buffer.CPU = mappedData;
+	buffer.GPU = owned.Resource->GetGPUVirtualAddress();
+	buffer.Size = byteSize;
+	buffer.Resource = owned.Resource.Get();
+
+	mBuffers.push_back(owned);
+	return true;
+}
+
+bool BufferMemoryD3D12::CreateDefaultBuffer(const void* initData, std::uint64_t byteSize, BufferAllocation& buffer)
+{
+	if(mCommandList == nullptr)
+		return false;
+
+	OwnedBuffer owned;
+	ComPtr<ID3D12Resource> uploader;
+	owned.Resource = d3dUtil::CreateDefaultBuffer(md3dDevice, mCommandList, initData, byteSize, uploader);
+
+	buffer.CPU = nullptr;
+	buffer.GPU = owned.Resource->GetGPUVirtualAddress();
+	buffer.Size = byteSize;
+	buffer.Resource = owned.Resource.Get();
+
+	mBuffers.push_back(owned);
+	mUploaders.push_back(uploader);
+	return true;
+}
+
+void BufferMemoryD3D12::ReleaseBuffer(const BufferAllocation& buffer)
+{
+	for(auto it = mBuffers.begin(); it != mBuffers.end(); ++it)
+	{
+		if(it->Resource.Get() == buffer.Resource)
+		{
+			if(it->Mapped)
+				it->Resource->Unmap(0, nullptr);
+			mBuffers.erase(it);
+			return;
+		}
+	}
+}
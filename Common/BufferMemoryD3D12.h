@@ -0,0 +1,44 @@
+//***************************************************************************************
+// BufferMemoryD3D12.h
+//
+// BufferMemoryBackend whose buffers are committed resources.  Upload buffers are mapped
+// once when they are created and unmapped when they are released.  Default buffers are
+// filled through d3dUtil::CreateDefaultBuffer on the command list given to
+// SetCommandList(); the backend keeps their upload heaps until ReleaseUploaders().
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "BufferMemory.h"
+
+class BufferMemoryD3D12 : public BufferMemoryBackend
+{
+public:
+	explicit BufferMemoryD3D12(ID3D12Device* device);
+	BufferMemoryD3D12(const BufferMemoryD3D12& rhs) = delete;
+	BufferMemoryD3D12& operator=(const BufferMemoryD3D12& rhs) = delete;
+
+	// Command list the copies into default buffers are recorded on.
+	void SetCommandList(ID3D12GraphicsCommandList* cmdList);
+
+	// Call once the GPU has executed the copies recorded so far.
+	void ReleaseUploaders();
+
+	virtual bool CreateUploadBuffer(std::uint64_t byteSize, BufferAllocation& buffer)override;
+	virtual bool CreateDefaultBuffer(const void* initData, std::uint64_t byteSize, BufferAllocation& buffer)override;
+	virtual void ReleaseBuffer(const BufferAllocation& buffer)override;
+
+private:
+	struct OwnedBuffer
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		bool Mapped = false;
+	};
+
+	ID3D12Device* md3dDevice = nullptr;
+	ID3D12GraphicsCommandList* mCommandList = nullptr;
+
+	std::vector<OwnedBuffer> mBuffers;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mUploaders;
+};
@@ -0,0 +1,761 @@
+//***************************************************************************************
+// DDSParser.cpp
+//***************************************************************************************
+
+#include "DDSParser.h"
+#include <algorithm>
+
+//--------------------------------------------------------------------------------------
+// Format table
+//
+// What the layout code needs to know about each DXGI format used to come from switch
+// statements run for every mip of every slice.  The same switches now run once per
+// format in the compiler, filling a table indexed by DXGI_FORMAT.
+//--------------------------------------------------------------------------------------
+namespace
+{
+    constexpr uint8_t FormatBitsPerPixel( DXGI_FORMAT fmt )
+    {
+        switch( fmt )
+        {
+        case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32B32A32_UINT:
+        case DXGI_FORMAT_R32G32B32A32_SINT:
+            return 128;
+
+        case DXGI_FORMAT_R32G32B32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+        case DXGI_FORMAT_R32G32B32_UINT:
+        case DXGI_FORMAT_R32G32B32_SINT:
+            return 96;
+
+        case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_R16G16B16A16_UINT:
+        case DXGI_FORMAT_R16G16B16A16_SNORM:
+        case DXGI_FORMAT_R16G16B16A16_SINT:
+        case DXGI_FORMAT_R32G32_TYPELESS:
+        case DXGI_FORMAT_R32G32_FLOAT:
+        case DXGI_FORMAT_R32G32_UINT:
+        case DXGI_FORMAT_R32G32_SINT:
+        case DXGI_FORMAT_R32G8X24_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+        case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+        case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+        case DXGI_FORMAT_Y416:
+        case DXGI_FORMAT_Y210:
+        case DXGI_FORMAT_Y216:
+            return 64;
+
+        case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+        case DXGI_FORMAT_R10G10B10A2_UINT:
+        case DXGI_FORMAT_R11G11B10_FLOAT:
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_R8G8B8A8_UINT:
+        case DXGI_FORMAT_R8G8B8A8_SNORM:
+        case DXGI_FORMAT_R8G8B8A8_SINT:
+        case DXGI_FORMAT_R16G16_TYPELESS:
+        case DXGI_FORMAT_R16G16_FLOAT:
+        case DXGI_FORMAT_R16G16_UNORM:
+        case DXGI_FORMAT_R16G16_UINT:
+        case DXGI_FORMAT_R16G16_SNORM:
+        case DXGI_FORMAT_R16G16_SINT:
+        case DXGI_FORMAT_R32_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT:
+        case DXGI_FORMAT_R32_FLOAT:
+        case DXGI_FORMAT_R32_UINT:
+        case DXGI_FORMAT_R32_SINT:
+        case DXGI_FORMAT_R24G8_TYPELESS:
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:
+        case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+        case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+        case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+        case DXGI_FORMAT_R8G8_B8G8_UNORM:
+        case DXGI_FORMAT_G8R8_G8B8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        case DXGI_FORMAT_AYUV:
+        case DXGI_FORMAT_Y410:
+        case DXGI_FORMAT_YUY2:
+            return 32;
+
+        case DXGI_FORMAT_P010:
+        case DXGI_FORMAT_P016:
+            return 24;
+
+        case DXGI_FORMAT_R8G8_TYPELESS:
+        case DXGI_FORMAT_R8G8_UNORM:
+        case DXGI_FORMAT_R8G8_UINT:
+        case DXGI_FORMAT_R8G8_SNORM:
+        case DXGI_FORMAT_R8G8_SINT:
+        case DXGI_FORMAT_R16_TYPELESS:
+        case DXGI_FORMAT_R16_FLOAT:
+        case DXGI_FORMAT_D16_UNORM:
+        case DXGI_FORMAT_R16_UNORM:
+        case DXGI_FORMAT_R16_UINT:
+        case DXGI_FORMAT_R16_SNORM:
+        case DXGI_FORMAT_R16_SINT:
+        case DXGI_FORMAT_B5G6R5_UNORM:
+        case DXGI_FORMAT_B5G5R5A1_UNORM:
+        case DXGI_FORMAT_A8P8:
+        case DXGI_FORMAT_B4G4R4A4_UNORM:
+            return 16;
+
+        case DXGI_FORMAT_NV12:
+        case DXGI_FORMAT_420_OPAQUE:
+        case DXGI_FORMAT_NV11:
+            return 12;
+
+        case DXGI_FORMAT_R8_TYPELESS:
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_R8_UINT:
+        case DXGI_FORMAT_R8_SNORM:
+        case DXGI_FORMAT_R8_SINT:
+        case DXGI_FORMAT_A8_UNORM:
+        case DXGI_FORMAT_AI44:
+        case DXGI_FORMAT_IA44:
+        case DXGI_FORMAT_P8:
+            return 8;
+
+        case DXGI_FORMAT_R1_UNORM:
+            return 1;
+
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            return 4;
+
+        case DXGI_FORMAT_BC2_TYPELESS:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_TYPELESS:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_TYPELESS:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        case DXGI_FORMAT_BC6H_TYPELESS:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+        case DXGI_FORMAT_BC7_TYPELESS:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return 8;
+
+        default:
+            return 0;
+        }
+    }
+
+    constexpr DXGI_FORMAT FormatSRGB( DXGI_FORMAT fmt )
+    {
+        switch( fmt )
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        case DXGI_FORMAT_BC1_UNORM:      return DXGI_FORMAT_BC1_UNORM_SRGB;
+        case DXGI_FORMAT_BC2_UNORM:      return DXGI_FORMAT_BC2_UNORM_SRGB;
+        case DXGI_FORMAT_BC3_UNORM:      return DXGI_FORMAT_BC3_UNORM_SRGB;
+        case DXGI_FORMAT_B8G8R8A8_UNORM: return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+        case DXGI_FORMAT_B8G8R8X8_UNORM: return DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+        case DXGI_FORMAT_BC7_UNORM:      return DXGI_FORMAT_BC7_UNORM_SRGB;
+        default:                         return fmt;
+        }
+    }
+
+    constexpr DXGIFormatInfo DescribeFormat( DXGI_FORMAT fmt )
+    {
+        DXGIFormatInfo info = { DXGIFormatLayout::Linear, FormatBitsPerPixel( fmt ), 0, FormatSRGB( fmt ) };
+
+        switch( fmt )
+        {
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            info.Layout = DXGIFormatLayout::Block;
+            info.ElementBytes = 8;
+            break;
+
+        case DXGI_FORMAT_BC2_TYPELESS:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_TYPELESS:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_TYPELESS:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        case DXGI_FORMAT_BC6H_TYPELESS:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+        case DXGI_FORMAT_BC7_TYPELESS:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            info.Layout = DXGIFormatLayout::Block;
+            info.ElementBytes = 16;
+            break;
+
+        case DXGI_FORMAT_R8G8_B8G8_UNORM:
+        case DXGI_FORMAT_G8R8_G8B8_UNORM:
+        case DXGI_FORMAT_YUY2:
+            info.Layout = DXGIFormatLayout::Packed;
+            info.ElementBytes = 4;
+            break;
+
+        case DXGI_FORMAT_Y210:
+        case DXGI_FORMAT_Y216:
+            info.Layout = DXGIFormatLayout::Packed;
+            info.ElementBytes = 8;
+            break;
+
+        case DXGI_FORMAT_NV12:
+        case DXGI_FORMAT_420_OPAQUE:
+            info.Layout = DXGIFormatLayout::Planar;
+            info.ElementBytes = 2;
+            break;
+
+        case DXGI_FORMAT_P010:
+        case DXGI_FORMAT_P016:
+            info.Layout = DXGIFormatLayout::Planar;
+            info.ElementBytes = 4;
+            break;
+
+        case DXGI_FORMAT_NV11:
+            info.Layout = DXGIFormatLayout::NV11;
+            info.ElementBytes = 4;
+            break;
+
+        default:
+            if( info.BitsPerPixel == 0 )
+                info.Layout = DXGIFormatLayout::Unknown;
+            break;
+        }
+
+        return info;
+    }
+
+    // DXGI_FORMAT_V408 is the last format DDS files can describe.
+    const size_t FormatCount = DXGI_FORMAT_V408 + 1;
+
+    struct FormatTableData
+    {
+        DXGIFormatInfo Formats[FormatCount];
+    };
+
+    constexpr FormatTableData BuildFormatTable()
+    {
+        FormatTableData table = {};
+        for( size_t i = 0; i < FormatCount; ++i )
+            table.Formats[i] = DescribeFormat( static_cast<DXGI_FORMAT>( i ) );
+        return table;
+    }
+
+    constexpr FormatTableData FormatTable = BuildFormatTable();
+
+    static_assert( FormatTable.Formats[DXGI_FORMAT_R8G8B8A8_UNORM].BitsPerPixel == 32, "format table" );
+    static_assert( FormatTable.Formats[DXGI_FORMAT_BC1_UNORM].ElementBytes == 8, "format table" );
+    static_assert( FormatTable.Formats[DXGI_FORMAT_BC7_UNORM].SRGBFormat == DXGI_FORMAT_BC7_UNORM_SRGB, "format table" );
+    static_assert( FormatTable.Formats[DXGI_FORMAT_UNKNOWN].Layout == DXGIFormatLayout::Unknown, "format table" );
+
+    // The layout rules from DirectXTex's ComputePitch, driven by the table entry.
+    inline void ComputeSurface( const DXGIFormatInfo& info, size_t width, size_t height,
+                                size_t& numBytes, size_t& rowBytes, size_t& numRows )
+    {
+        switch( info.Layout )
+        {
+        case DXGIFormatLayout::Block:
+        {
+            const size_t numBlocksWide = width > 0 ? std::max<size_t>( 1, (width + 3) / 4 ) : 0;
+            const size_t numBlocksHigh = height > 0 ? std::max<size_t>( 1, (height + 3) / 4 ) : 0;
+            rowBytes = numBlocksWide * info.ElementBytes;
+            numRows = numBlocksHigh;
+            numBytes = rowBytes * numBlocksHigh;
+            break;
+        }
+
+        case DXGIFormatLayout::Packed:
+            rowBytes = ( ( width + 1 ) >> 1 ) * info.ElementBytes;
+            numRows = height;
+            numBytes = rowBytes * height;
+            break;
+
+        case DXGIFormatLayout::NV11:
+            rowBytes = ( ( width + 3 ) >> 2 ) * 4;
+            numRows = height * 2; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
+            numBytes = rowBytes * numRows;
+            break;
+
+        case DXGIFormatLayout::Planar:
+            rowBytes = ( ( width + 1 ) >> 1 ) * info.ElementBytes;
+            numBytes = ( rowBytes * height ) + ( ( rowBytes * height + 1 ) >> 1 );
+            numRows = height + ( ( height + 1 ) >> 1 );
+            break;
+
+        default:
+            rowBytes = ( width * info.BitsPerPixel + 7 ) / 8; // round up to nearest byte
+            numRows = height;
+            numBytes = rowBytes * height;
+            break;
+        }
+    }
+
+    // A pixel format of the legacy header and the DXGI format it is loaded as.  Kind is
+    // DDS_RGB, DDS_LUMINANCE, DDS_ALPHA or DDS_FOURCC; alpha formats match on the bit
+    // count alone and FourCC formats on the code alone.
+    struct LegacyFormat
+    {
+        uint32_t Kind;
+        uint32_t BitCountOrFourCC;
+        uint32_t RBitMask;
+        uint32_t GBitMask;
+        uint32_t BBitMask;
+        uint32_t ABitMask;
+        DXGI_FORMAT Format;
+    };
+
+    const LegacyFormat LegacyFormats[] =
+    {
+        // Note that sRGB formats are written using the "DX10" extended header
+
+        { DDS_RGB, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000, DXGI_FORMAT_R8G8B8A8_UNORM },
+        { DDS_RGB, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000, DXGI_FORMAT_B8G8R8A8_UNORM },
+        { DDS_RGB, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000, DXGI_FORMAT_B8G8R8X8_UNORM },
+
+        // No DXGI format maps to (0x000000ff,0x0000ff00,0x00ff0000,0x00000000) aka D3DFMT_X8B8G8R8
+
+        // Note that many common DDS reader/writers (including D3DX) swap the
+        // the RED/BLUE masks for 10:10:10:2 formats. We assume
+        // below that the 'backwards' header mask is being used since it is most
+        // likely written by D3DX. The more robust solution is to use the 'DX10'
+        // header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
+
+        // For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
+        { DDS_RGB, 32, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000, DXGI_FORMAT_R10G10B10A2_UNORM },
+
+        // No DXGI format maps to (0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
+
+        { DDS_RGB, 32, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000, DXGI_FORMAT_R16G16_UNORM },
+
+        // Only 32-bit color channel format in D3D9 was R32F
+        { DDS_RGB, 32, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, DXGI_FORMAT_R32_FLOAT }, // D3DX writes this out as a FourCC of 114
+
+        // No 24bpp DXGI formats aka D3DFMT_R8G8B8
+
+        { DDS_RGB, 16, 0x7c00, 0x03e0, 0x001f, 0x8000, DXGI_FORMAT_B5G5R5A1_UNORM },
+        { DDS_RGB, 16, 0xf800, 0x07e0, 0x001f, 0x0000, DXGI_FORMAT_B5G6R5_UNORM },
+
+        // No DXGI format maps to (0x7c00,0x03e0,0x001f,0x0000) aka D3DFMT_X1R5G5B5
+
+        { DDS_RGB, 16, 0x0f00, 0x00f0, 0x000f, 0xf000, DXGI_FORMAT_B4G4R4A4_UNORM },
+
+        // No DXGI format maps to (0x0f00,0x00f0,0x000f,0x0000) aka D3DFMT_X4R4G4B4
+
+        // No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
+
+        { DDS_LUMINANCE, 8, 0x000000ff, 0x00000000, 0x00000000, 0x00000000, DXGI_FORMAT_R8_UNORM }, // D3DX10/11 writes this out as DX10 extension
+
+        // No DXGI format maps to (0x0f,0x00,0x00,0xf0) aka D3DFMT_A4L4
+
+        { DDS_LUMINANCE, 16, 0x0000ffff, 0x00000000, 0x00000000, 0x00000000, DXGI_FORMAT_R16_UNORM }, // D3DX10/11 writes this out as DX10 extension
+        { DDS_LUMINANCE, 16, 0x000000ff, 0x00000000, 0x00000000, 0x0000ff00, DXGI_FORMAT_R8G8_UNORM }, // D3DX10/11 writes this out as DX10 extension
+
+        { DDS_ALPHA, 8, 0, 0, 0, 0, DXGI_FORMAT_A8_UNORM },
+
+        { DDS_FOURCC, MAKEFOURCC( 'D', 'X', 'T', '1' ), 0, 0, 0, 0, DXGI_FORMAT_BC1_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'D', 'X', 'T', '3' ), 0, 0, 0, 0, DXGI_FORMAT_BC2_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'D', 'X', 'T', '5' ), 0, 0, 0, 0, DXGI_FORMAT_BC3_UNORM },
+
+        // While pre-multiplied alpha isn't directly supported by the DXGI formats,
+        // they are basically the same as these BC formats so they can be mapped
+        { DDS_FOURCC, MAKEFOURCC( 'D', 'X', 'T', '2' ), 0, 0, 0, 0, DXGI_FORMAT_BC2_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'D', 'X', 'T', '4' ), 0, 0, 0, 0, DXGI_FORMAT_BC3_UNORM },
+
+        { DDS_FOURCC, MAKEFOURCC( 'A', 'T', 'I', '1' ), 0, 0, 0, 0, DXGI_FORMAT_BC4_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'B', 'C', '4', 'U' ), 0, 0, 0, 0, DXGI_FORMAT_BC4_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'B', 'C', '4', 'S' ), 0, 0, 0, 0, DXGI_FORMAT_BC4_SNORM },
+
+        { DDS_FOURCC, MAKEFOURCC( 'A', 'T', 'I', '2' ), 0, 0, 0, 0, DXGI_FORMAT_BC5_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'B', 'C', '5', 'U' ), 0, 0, 0, 0, DXGI_FORMAT_BC5_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'B', 'C', '5', 'S' ), 0, 0, 0, 0, DXGI_FORMAT_BC5_SNORM },
+
+        // BC6H and BC7 are written using the "DX10" extended header
+
+        { DDS_FOURCC, MAKEFOURCC( 'R', 'G', 'B', 'G' ), 0, 0, 0, 0, DXGI_FORMAT_R8G8_B8G8_UNORM },
+        { DDS_FOURCC, MAKEFOURCC( 'G', 'R', 'G', 'B' ), 0, 0, 0, 0, DXGI_FORMAT_G8R8_G8B8_UNORM },
+
+        { DDS_FOURCC, MAKEFOURCC( 'Y', 'U', 'Y', '2' ), 0, 0, 0, 0, DXGI_FORMAT_YUY2 },
+
+        // D3DFORMAT enums stored as the FourCC
+        { DDS_FOURCC, 36,  0, 0, 0, 0, DXGI_FORMAT_R16G16B16A16_UNORM }, // D3DFMT_A16B16G16R16
+        { DDS_FOURCC, 110, 0, 0, 0, 0, DXGI_FORMAT_R16G16B16A16_SNORM }, // D3DFMT_Q16W16V16U16
+        { DDS_FOURCC, 111, 0, 0, 0, 0, DXGI_FORMAT_R16_FLOAT },          // D3DFMT_R16F
+        { DDS_FOURCC, 112, 0, 0, 0, 0, DXGI_FORMAT_R16G16_FLOAT },       // D3DFMT_G16R16F
+        { DDS_FOURCC, 113, 0, 0, 0, 0, DXGI_FORMAT_R16G16B16A16_FLOAT }, // D3DFMT_A16B16G16R16F
+        { DDS_FOURCC, 114, 0, 0, 0, 0, DXGI_FORMAT_R32_FLOAT },          // D3DFMT_R32F
+        { DDS_FOURCC, 115, 0, 0, 0, 0, DXGI_FORMAT_R32G32_FLOAT },       // D3DFMT_G32R32F
+        { DDS_FOURCC, 116, 0, 0, 0, 0, DXGI_FORMAT_R32G32B32A32_FLOAT }, // D3DFMT_A32B32G32R32F
+    };
+}
+
+namespace
+{
+	using Result = DDSParser::Result;
+
+	// The D3D12_REQ_* resource limits; d3d12.h is not available on every platform the
+	// parser builds on.
+	const std::size_t MaxTexture1DSize = 16384;
+	const std::size_t MaxTexture1DArraySize = 2048;
+	const std::size_t MaxTexture2DSize = 16384;
+	const std::size_t MaxTexture2DArraySize = 2048;
+	const std::size_t MaxTextureCubeSize = 16384;
+	const std::size_t MaxTexture3DSize = 2048;
+
+	// Fills in everything except the subresources from the headers.
+	Result ReadHeader(const DDS_HEADER* header, std::size_t byteSize, DDSImage& image)
+	{
+		const bool dxt10 = (header->ddspf.flags & DDS_FOURCC) &&
+			(MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC);
+
+		// Must be long enough for both headers and the magic value.
+		if(dxt10 && byteSize < sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10))
+			return Result::InvalidData;
+
+		image.Width = header->width;
+		image.Height = header->height;
+		image.Depth = header->depth;
+		image.MipCount = std::max<std::size_t>(header->mipMapCount, 1);
+		image.ArraySize = 1;
+		image.IsCubeMap = false;
+
+		if(dxt10)
+		{
+			auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>((const char*)header + sizeof(DDS_HEADER));
+
+			image.ArraySize = d3d10ext->arraySize;
+			if(image.ArraySize == 0)
+				return Result::InvalidData;
+
+			switch(d3d10ext->dxgiFormat)
+			{
+			case DXGI_FORMAT_AI44:
+			case DXGI_FORMAT_IA44:
+			case DXGI_FORMAT_P8:
+			case DXGI_FORMAT_A8P8:
+				return Result::NotSupported;
+
+			default:
+				if(DDSParser::BitsPerPixel(d3d10ext->dxgiFormat) == 0)
+					return Result::NotSupported;
+			}
+
+			image.Format = d3d10ext->dxgiFormat;
+
+			switch(d3d10ext->resourceDimension)
+			{
+			case DDS_DIMENSION_TEXTURE1D:
+				if((header->flags & DDS_HEIGHT) && image.Height != 1)
+					return Result::InvalidData;
+				image.Height = image.Depth = 1;
+				break;
+
+			case DDS_DIMENSION_TEXTURE2D:
+				if(d3d10ext->miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+				{
+					// Checked before multiplying so a huge count cannot wrap around.
+					if(image.ArraySize > MaxTexture2DArraySize)
+						return Result::NotSupported;
+					image.ArraySize *= 6;
+					image.IsCubeMap = true;
+				}
+				image.Depth = 1;
+				break;
+
+			case DDS_DIMENSION_TEXTURE3D:
+				if(!(header->flags & DDS_HEADER_FLAGS_VOLUME))
+					return Result::InvalidData;
+				if(image.ArraySize > 1)
+					return Result::NotSupported;
+				break;
+
+			default:
+				return Result::NotSupported;
+			}
+
+			image.Dimension = static_cast<DDS_RESOURCE_DIMENSION>(d3d10ext->resourceDimension);
+		}
+		else
+		{
+			image.Format = DDSParser::GetDXGIFormat(header->ddspf);
+			if(image.Format == DXGI_FORMAT_UNKNOWN)
+				return Result::NotSupported;
+
+			if(header->flags & DDS_HEADER_FLAGS_VOLUME)
+			{
+				image.Dimension = DDS_DIMENSION_TEXTURE3D;
+			}
+			else
+			{
+				if(header->caps2 & DDS_CUBEMAP)
+				{
+					// Partial cube maps are not supported.
+					if((header->caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+						return Result::NotSupported;
+					image.ArraySize = 6;
+					image.IsCubeMap = true;
+				}
+
+				image.Depth = 1;
+				image.Dimension = DDS_DIMENSION_TEXTURE2D;
+			}
+		}
+
+		const std::size_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER) + (dxt10 ? sizeof(DDS_HEADER_DXT10) : 0);
+		image.BitData = reinterpret_cast<const std::uint8_t*>(header) - sizeof(uint32_t) + offset;
+		image.BitSize = byteSize - offset;
+
+		return Result::Ok;
+	}
+
+	// Walks the texel data the way D3D orders subresources: every mip of slice 0,
+	// then every mip of slice 1, and so on.
+	Result ComputeSubresources(DDSImage& image)
+	{
+		// More mips than a 1x1 level can come from would be a corrupt header.
+		if(image.MipCount > 32 || image.Width == 0 || image.Height == 0 || image.Depth == 0)
+			return Result::InvalidData;
+
+		image.Subresources.resize(image.MipCount*image.ArraySize);
+
+		// Every subresource shares the format, so its table entry is looked up once.
+		const DXGIFormatInfo& format = DDSParser::GetFormatInfo(image.Format);
+
+		const std::uint8_t* srcBits = image.BitData;
+		const std::uint8_t* endBits = image.BitData + image.BitSize;
+
+		std::size_t index = 0;
+		for(std::size_t j = 0; j < image.ArraySize; ++j)
+		{
+			std::size_t w = image.Width;
+			std::size_t h = image.Height;
+			std::size_t d = image.Depth;
+			for(std::size_t i = 0; i < image.MipCount; ++i)
+			{
+				DDSSubresource& sub = image.Subresources[index++];
+				ComputeSurface(format, w, h, sub.SlicePitch, sub.RowPitch, sub.NumRows);
+				sub.Data = srcBits;
+				sub.Width = w;
+				sub.Height = h;
+				sub.Depth = d;
+
+				if(sub.SlicePitch*d > (std::size_t)(endBits - srcBits))
+				{
+					image.Subresources.clear();
+					return Result::EndOfFile;
+				}
+
+				srcBits += sub.SlicePitch*d;
+
+				w = std::max<std::size_t>(w >> 1, 1);
+				h = std::max<std::size_t>(h >> 1, 1);
+				d = std::max<std::size_t>(d >> 1, 1);
+			}
+		}
+
+		return Result::Ok;
+	}
+}
+
+DDSParser::Result DDSParser::ParseMemory(const std::uint8_t* data, std::size_t byteSize, DDSImage& image)
+{
+	image = DDSImage();
+
+	// Need at least enough data to fill the header and magic number to be a valid DDS.
+	if(data == nullptr || byteSize < sizeof(uint32_t) + sizeof(DDS_HEADER))
+		return Result::InvalidData;
+
+	// DDS files always start with the same magic number ("DDS ").
+	if(*reinterpret_cast<const uint32_t*>(data) != DDS_MAGIC)
+		return Result::InvalidData;
+
+	auto header = reinterpret_cast<const DDS_HEADER*>(data + sizeof(uint32_t));
+	if(header->size != sizeof(DDS_HEADER) || header->ddspf.size != sizeof(DDS_PIXELFORMAT))
+		return Result::InvalidData;
+
+	image.Header = header;
+
+	Result result = ReadHeader(header, byteSize, image);
+	if(result != Result::Ok)
+		return result;
+
+	// The subresource table is sized from the header, so bound it first.
+	result = CheckLimits(image);
+	if(result != Result::Ok)
+		return result;
+
+	return ComputeSubresources(image);
+}
+
+DDSParser::Result DDSParser::ParseFile(const std::wstring& filename, DDSImage& image)
+{
+	auto file = MappedFile::Open(filename);
+	if(file == nullptr)
+		return Result::FileNotFound;
+
+	if(file->Size() > SIZE_MAX)
+		return Result::NotSupported;
+
+	Result result = ParseMemory(file->Data(), (std::size_t)file->Size(), image);
+	if(result == Result::Ok)
+		image.File = file;
+
+	return result;
+}
+
+//--------------------------------------------------------------------------------------
+// Return the BPP for a particular format
+//--------------------------------------------------------------------------------------
+size_t DDSParser::BitsPerPixel( DXGI_FORMAT fmt )
+{
+    return GetFormatInfo( fmt ).BitsPerPixel;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Get surface information for a particular format
+//--------------------------------------------------------------------------------------
+void DDSParser::GetSurfaceInfo( size_t width,
+                                size_t height,
+                                DXGI_FORMAT fmt,
+                                size_t* outNumBytes,
+                                size_t* outRowBytes,
+                                size_t* outNumRows )
+{
+    size_t numBytes = 0;
+    size_t rowBytes = 0;
+    size_t numRows = 0;
+
+    ComputeSurface( GetFormatInfo( fmt ), width, height, numBytes, rowBytes, numRows );
+
+    if (outNumBytes)
+    {
+        *outNumBytes = numBytes;
+    }
+    if (outRowBytes)
+    {
+        *outRowBytes = rowBytes;
+    }
+    if (outNumRows)
+    {
+        *outNumRows = numRows;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+DXGI_FORMAT DDSParser::GetDXGIFormat( const DDS_PIXELFORMAT& ddpf )
+{
+    // The flags are checked in this order; only the first one set counts.
+    uint32_t kind = 0;
+    if (ddpf.flags & DDS_RGB)
+    {
+        kind = DDS_RGB;
+    }
+    else if (ddpf.flags & DDS_LUMINANCE)
+    {
+        kind = DDS_LUMINANCE;
+    }
+    else if (ddpf.flags & DDS_ALPHA)
+    {
+        kind = DDS_ALPHA;
+    }
+    else if (ddpf.flags & DDS_FOURCC)
+    {
+        kind = DDS_FOURCC;
+    }
+
+    for (const LegacyFormat& legacy : LegacyFormats)
+    {
+        if (legacy.Kind != kind)
+        {
+            continue;
+        }
+
+        const bool match = kind == DDS_FOURCC ?
+            legacy.BitCountOrFourCC == ddpf.fourCC :
+            legacy.BitCountOrFourCC == ddpf.RGBBitCount &&
+                (kind == DDS_ALPHA || (legacy.RBitMask == ddpf.RBitMask && legacy.GBitMask == ddpf.GBitMask &&
+                                       legacy.BBitMask == ddpf.BBitMask && legacy.ABitMask == ddpf.ABitMask));
+        if (match)
+        {
+            return legacy.Format;
+        }
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+
+//--------------------------------------------------------------------------------------
+DDSParser::Result DDSParser::CheckLimits(const DDSImage& image)
+{
+	switch(image.Dimension)
+	{
+	case DDS_DIMENSION_TEXTURE1D:
+		if(image.ArraySize > MaxTexture1DArraySize || image.Width > MaxTexture1DSize)
+			return Result::NotSupported;
+		break;
+
+	case DDS_DIMENSION_TEXTURE2D:
+		if(image.IsCubeMap)
+		{
+			// ArraySize counts faces; the limit is on the faces too.
+			if(image.ArraySize > MaxTexture2DArraySize ||
+				image.Width > MaxTextureCubeSize || image.Height > MaxTextureCubeSize)
+				return Result::NotSupported;
+		}
+		else if(image.ArraySize > MaxTexture2DArraySize ||
+			image.Width > MaxTexture2DSize || image.Height > MaxTexture2DSize)
+		{
+			return Result::NotSupported;
+		}
+		break;
+
+	case DDS_DIMENSION_TEXTURE3D:
+		if(image.ArraySize > 1 || image.Width > MaxTexture3DSize ||
+			image.Height > MaxTexture3DSize || image.Depth > MaxTexture3DSize)
+			return Result::NotSupported;
+		break;
+
+	default:
+		return Result::NotSupported;
+	}
+
+	return Result::Ok;
+}
+
+DXGI_FORMAT DDSParser::MakeSRGB( DXGI_FORMAT format )
+{
+    return static_cast<size_t>( format ) < FormatCount ? FormatTable.Formats[format].SRGBFormat : format;
+}
+
+
+//--------------------------------------------------------------------------------------
+const DXGIFormatInfo& DDSParser::GetFormatInfo( DXGI_FORMAT format )
+{
+    return static_cast<size_t>( format ) < FormatCount ? FormatTable.Formats[format] : FormatTable.Formats[DXGI_FORMAT_UNKNOWN];
+}
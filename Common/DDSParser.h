@@ -0,0 +1,245 @@
+//***************************************************************************************
+// DDSParser.h
+//
+// Device independent DDS parsing.  Validates the DDS headers and computes the layout of
+// every subresource, returning pointers straight into the file data, so texels can go
+// from a memory-mapped file to an upload buffer without an intermediate copy.  Nothing
+// here touches Direct3D, so it also builds and runs on non-Windows systems.
+//
+// The file structure definitions and the format helpers were moved here from
+// DDSTextureLoader.cpp, which now creates its D3D12 resources from a DDSImage.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <dxgiformat.h>
+#else
+#include <directx/dxgiformat.h>
+#endif
+
+#include "MappedFile.h"
+
+//--------------------------------------------------------------------------------------
+// Macros
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+enum DDS_MISC_FLAGS2
+{
+    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+struct DDS_HEADER
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        miscFlags2;
+};
+
+#pragma pack(pop)
+
+// Values of DDS_HEADER_DXT10::resourceDimension.  They match the D3D11 and D3D12
+// resource dimension enums.
+enum DDS_RESOURCE_DIMENSION
+{
+    DDS_DIMENSION_TEXTURE1D = 2,
+    DDS_DIMENSION_TEXTURE2D = 3,
+    DDS_DIMENSION_TEXTURE3D = 4,
+};
+
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4L
+
+// One mip level of one array slice.
+struct DDSSubresource
+{
+	const std::uint8_t* Data = nullptr;
+	std::size_t RowPitch = 0;
+	std::size_t SlicePitch = 0;
+	std::size_t NumRows = 0;
+
+	std::size_t Width = 0;
+	std::size_t Height = 0;
+	std::size_t Depth = 0;
+};
+
+struct DDSImage
+{
+	const DDS_HEADER* Header = nullptr;
+
+	DDS_RESOURCE_DIMENSION Dimension = DDS_DIMENSION_TEXTURE2D;
+	DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+	std::size_t Width = 0;
+	std::size_t Height = 0;
+	std::size_t Depth = 0;
+	std::size_t MipCount = 0;
+
+	// Number of 2D slices; six per cube for cube maps.
+	std::size_t ArraySize = 0;
+	bool IsCubeMap = false;
+
+	// Texel data following the headers.
+	const std::uint8_t* BitData = nullptr;
+	std::size_t BitSize = 0;
+
+	// Ordered like D3D subresource indices: Subresources[slice*MipCount + mip].
+	std::vector<DDSSubresource> Subresources;
+
+	// Keeps the views above valid when the image was parsed from a file.
+	std::shared_ptr<MappedFile> File;
+
+	// Owns the texels of images built in memory, such as MipGenerator's mip chains.
+	// Header is null for those.
+	std::shared_ptr<const std::vector<std::uint8_t>> Memory;
+};
+
+// How the texels of a DXGI format are laid out in memory.
+enum class DXGIFormatLayout : std::uint8_t
+{
+	// Not a format a DDS file can hold.
+	Unknown,
+
+	// BitsPerPixel per texel, rows rounded up to whole bytes.
+	Linear,
+
+	// 4x4 texel blocks of ElementBytes each (BC1-BC7).
+	Block,
+
+	// Pairs of texels sharing ElementBytes (YUY2, Y210, RGBG).
+	Packed,
+
+	// A plane of ElementBytes per texel pair followed by a half height chroma plane (NV12, P010).
+	Planar,
+
+	// NV11, laid out the way Direct3D assumes.
+	NV11,
+};
+
+// Properties of one DXGI format.  DDSParser keeps them in a table built at compile time.
+struct DXGIFormatInfo
+{
+	DXGIFormatLayout Layout;
+	std::uint8_t BitsPerPixel;
+	std::uint8_t ElementBytes;
+
+	// The sRGB twin of the format, or the format itself if it has none.
+	DXGI_FORMAT SRGBFormat;
+};
+
+class DDSParser
+{
+public:
+	enum class Result
+	{
+		Ok,
+		FileNotFound,
+		InvalidData,
+		NotSupported,
+		EndOfFile,
+	};
+
+	///<summary>
+	/// Parses a DDS file held in memory.  The image points into data, which must outlive it.
+	///</summary>
+	static Result ParseMemory(const std::uint8_t* data, std::size_t byteSize, DDSImage& image);
+
+	///<summary>
+	/// Maps the file and parses it.  The image holds on to the mapping.
+	///</summary>
+	static Result ParseFile(const std::wstring& filename, DDSImage& image);
+
+	static std::size_t BitsPerPixel(DXGI_FORMAT fmt);
+
+	static void GetSurfaceInfo(std::size_t width, std::size_t height, DXGI_FORMAT fmt,
+		std::size_t* outNumBytes, std::size_t* outRowBytes, std::size_t* outNumRows);
+
+	static DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf);
+
+	static DXGI_FORMAT MakeSRGB(DXGI_FORMAT format);
+
+	///<summary>
+	/// Returns NotSupported if the image's size or array size is beyond what Direct3D 12
+	/// can create.  The parsers call it before sizing the subresource table from a header.
+	///</summary>
+	static Result CheckLimits(const DDSImage& image);
+
+	///<summary>
+	/// Table entry of format; unknown formats get an entry with the Unknown layout.
+	/// Code that lays out many subresources of one format can look it up once.
+	///</summary>
+	static const DXGIFormatInfo& GetFormatInfo(DXGI_FORMAT format);
+};
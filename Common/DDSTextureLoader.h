@@ -44,6 +44,8 @@
 #define _Use_decl_annotations_
 #endif
 
+struct DDSImage;
+
 namespace DirectX
 {
     enum DDS_ALPHA_MODE
@@ -92,6 +94,16 @@ namespace DirectX
 		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 		                               );
 
+	// Creates the texture from an image already parsed by DDSParser.  Mips larger than
+	// maxsize are left out, which is how TextureStreamer creates partially resident textures.
+	HRESULT CreateDDSTextureFromImage12(_In_ ID3D12Device* device,
+		                                _In_ ID3D12GraphicsCommandList* cmdList,
+		                                _In_ const DDSImage& image,
+		                                _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                                _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap,
+		                                _In_ size_t maxsize = 0
+		                                );
+
     // Standard version with optional auto-gen mipmap support
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_opt_ ID3D11DeviceContext* d3dContext,
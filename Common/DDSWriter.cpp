@@ -0,0 +1,165 @@
+//***************************************************************************************
+// DDSWriter.cpp
+//***************************************************************************************
+
+#include "DDSWriter.h"
+#include "FileUtil.h"
+#include <cstring>
+
+#define DDS_ALPHAPIXELS 0x00000001  // DDPF_ALPHAPIXELS
+
+#define DDS_HEADER_FLAGS_TEXTURE    0x00001007  // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+#define DDS_HEADER_FLAGS_MIPMAP     0x00020000  // DDSD_MIPMAPCOUNT
+#define DDS_HEADER_FLAGS_PITCH      0x00000008  // DDSD_PITCH
+#define DDS_HEADER_FLAGS_LINEARSIZE 0x00080000  // DDSD_LINEARSIZE
+
+#define DDS_SURFACE_FLAGS_TEXTURE 0x00001000 // DDSCAPS_TEXTURE
+#define DDS_SURFACE_FLAGS_MIPMAP  0x00400008 // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+#define DDS_SURFACE_FLAGS_CUBEMAP 0x00000008 // DDSCAPS_COMPLEX
+
+namespace
+{
+	// Fills in the legacy pixel format of the formats that have one.
+	bool GetLegacyPixelFormat(DXGI_FORMAT format, DDS_PIXELFORMAT& ddpf)
+	{
+		std::memset(&ddpf, 0, sizeof(ddpf));
+		ddpf.size = sizeof(DDS_PIXELFORMAT);
+
+		switch(format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+			ddpf.flags = DDS_FOURCC;
+			ddpf.fourCC = MAKEFOURCC('D', 'X', 'T', '1');
+			return true;
+
+		case DXGI_FORMAT_BC2_UNORM:
+			ddpf.flags = DDS_FOURCC;
+			ddpf.fourCC = MAKEFOURCC('D', 'X', 'T', '3');
+			return true;
+
+		case DXGI_FORMAT_BC3_UNORM:
+			ddpf.flags = DDS_FOURCC;
+			ddpf.fourCC = MAKEFOURCC('D', 'X', 'T', '5');
+			return true;
+
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+			ddpf.flags = DDS_RGB | DDS_ALPHAPIXELS;
+			ddpf.RGBBitCount = 32;
+			ddpf.RBitMask = 0x000000ff;
+			ddpf.GBitMask = 0x0000ff00;
+			ddpf.BBitMask = 0x00ff0000;
+			ddpf.ABitMask = 0xff000000;
+			return true;
+
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			ddpf.flags = DDS_RGB | DDS_ALPHAPIXELS;
+			ddpf.RGBBitCount = 32;
+			ddpf.RBitMask = 0x00ff0000;
+			ddpf.GBitMask = 0x0000ff00;
+			ddpf.BBitMask = 0x000000ff;
+			ddpf.ABitMask = 0xff000000;
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	bool IsCompressed(DXGI_FORMAT format)
+	{
+		return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+			(format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	}
+}
+
+bool DDSWriter::SaveToMemory(const DDSImage& image, std::vector<std::uint8_t>& data)
+{
+	if(image.Dimension != DDS_DIMENSION_TEXTURE2D || image.Depth > 1 ||
+		image.Subresources.size() != image.MipCount*image.ArraySize || image.Subresources.empty())
+	{
+		return false;
+	}
+
+	const std::size_t faces = image.IsCubeMap ? 6 : 1;
+	const DDSSubresource& top = image.Subresources[0];
+
+	DDS_HEADER header;
+	std::memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE;
+	header.height = (std::uint32_t)image.Height;
+	header.width = (std::uint32_t)image.Width;
+	header.mipMapCount = (std::uint32_t)image.MipCount;
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+	if(IsCompressed(image.Format))
+	{
+		header.flags |= DDS_HEADER_FLAGS_LINEARSIZE;
+		header.pitchOrLinearSize = (std::uint32_t)top.SlicePitch;
+	}
+	else
+	{
+		header.flags |= DDS_HEADER_FLAGS_PITCH;
+		header.pitchOrLinearSize = (std::uint32_t)top.RowPitch;
+	}
+
+	if(image.MipCount > 1)
+	{
+		header.flags |= DDS_HEADER_FLAGS_MIPMAP;
+		header.caps |= DDS_SURFACE_FLAGS_MIPMAP;
+	}
+
+	if(image.IsCubeMap)
+	{
+		header.caps |= DDS_SURFACE_FLAGS_CUBEMAP;
+		header.caps2 = DDS_CUBEMAP_ALLFACES;
+	}
+
+	// Arrays other than a single cube need the DX10 header.
+	const bool legacy = image.ArraySize == faces && GetLegacyPixelFormat(image.Format, header.ddspf);
+
+	DDS_HEADER_DXT10 dx10;
+	std::memset(&dx10, 0, sizeof(dx10));
+	if(!legacy)
+	{
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		dx10.dxgiFormat = image.Format;
+		dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+		dx10.miscFlag = image.IsCubeMap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+		dx10.arraySize = (std::uint32_t)(image.ArraySize / faces);
+	}
+
+	std::size_t byteSize = sizeof(std::uint32_t) + sizeof(DDS_HEADER) + (legacy ? 0 : sizeof(DDS_HEADER_DXT10));
+	const std::size_t headerSize = byteSize;
+	for(const auto& sub : image.Subresources)
+		byteSize += sub.SlicePitch;
+
+	data.resize(byteSize);
+	std::uint8_t* p = data.data();
+
+	std::memcpy(p, &DDS_MAGIC, sizeof(std::uint32_t));
+	std::memcpy(p + sizeof(std::uint32_t), &header, sizeof(header));
+	if(!legacy)
+		std::memcpy(p + sizeof(std::uint32_t) + sizeof(header), &dx10, sizeof(dx10));
+
+	p += headerSize;
+	for(const auto& sub : image.Subresources)
+	{
+		std::memcpy(p, sub.Data, sub.SlicePitch);
+		p += sub.SlicePitch;
+	}
+
+	return true;
+}
+
+bool DDSWriter::SaveToFile(const std::wstring& filename, const DDSImage& image)
+{
+	std::vector<std::uint8_t> data;
+	if(!SaveToMemory(image, data))
+		return false;
+
+	return FileUtil::WriteFile(filename, data.data(), data.size());
+}
@@ -0,0 +1,24 @@
+//***************************************************************************************
+// DDSWriter.h
+//
+// Serializes a DDSImage (2D texture, array or cube) back into a DDS file, so images
+// produced by the texture tools can be loaded by DDSParser and DDSTextureLoader.  Formats
+// the legacy header can describe are written without the DX10 extension header, so
+// older viewers open them too.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+
+class DDSWriter
+{
+public:
+	///<summary>
+	/// Writes the headers followed by every subresource in DDS order.  Returns false for
+	/// 1D and 3D textures.
+	///</summary>
+	static bool SaveToMemory(const DDSImage& image, std::vector<std::uint8_t>& data);
+
+	static bool SaveToFile(const std::wstring& filename, const DDSImage& image);
+};
@@ -0,0 +1,82 @@
+//***************************************************************************************
+// FileUtil.cpp
+//***************************************************************************************
+
+#include "FileUtil.h"
+#include <cstdint>
+
+#ifdef _WIN32
+
+std::FILE* FileUtil::Open(const std::wstring& filename, const char* mode)
+{
+	const std::wstring wideMode(mode, mode + std::char_traits<char>::length(mode));
+
+	std::FILE* file = nullptr;
+	return _wfopen_s(&file, filename.c_str(), wideMode.c_str()) == 0 ? file : nullptr;
+}
+
+#else
+
+std::FILE* FileUtil::Open(const std::wstring& filename, const char* mode)
+{
+	// wchar_t holds UTF-32 here; encode the name as UTF-8.
+	std::string narrow;
+	for(wchar_t wc : filename)
+	{
+		const std::uint32_t c = (std::uint32_t)wc;
+		if(c < 0x80)
+		{
+			narrow += (char)c;
+		}
+		else if(c < 0x800)
+		{
+			narrow += (char)(0xc0 | (c >> 6));
+			narrow += (char)(0x80 | (c & 0x3f));
+		}
+		else if(c < 0x10000)
+		{
+			narrow += (char)(0xe0 | (c >> 12));
+			narrow += (char)(0x80 | ((c >> 6) & 0x3f));
+			narrow += (char)(0x80 | (c & 0x3f));
+		}
+		else
+		{
+			narrow += (char)(0xf0 | (c >> 18));
+			narrow += (char)(0x80 | ((c >> 12) & 0x3f));
+			narrow += (char)(0x80 | ((c >> 6) & 0x3f));
+			narrow += (char)(0x80 | (c & 0x3f));
+		}
+	}
+
+	return std::fopen(narrow.c_str(), mode);
+}
+
+#endif
+
+bool FileUtil::WriteFile(const std::wstring& filename, const void* data, std::size_t byteSize)
+{
+	std::FILE* file = Open(filename, "wb");
+	if(file == nullptr)
+		return false;
+
+	const bool written = std::fwrite(data, 1, byteSize, file) == byteSize;
+	return std::fclose(file) == 0 && written;
+}
+
+bool FileUtil::ReadFile(const std::wstring& filename, std::string& contents)
+{
+	std::FILE* file = Open(filename, "rb");
+	if(file == nullptr)
+		return false;
+
+	contents.clear();
+
+	char buffer[4096];
+	std::size_t count = 0;
+	while((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, count);
+
+	const bool read = std::ferror(file) == 0;
+	std::fclose(file);
+	return read;
+}
@@ -0,0 +1,27 @@
+//***************************************************************************************
+// FileUtil.h
+//
+// Whole-file reads and writes for the helpers that must also build without Windows.
+// File names are wide strings throughout Common; the std::fstream constructors that
+// take one are an MSVC extension, so files are opened with _wfopen_s on Windows and
+// with fopen on a UTF-8 encoded name elsewhere.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+class FileUtil
+{
+public:
+	// mode is as for fopen, such as "wb".  Returns nullptr if the file cannot be opened.
+	static std::FILE* Open(const std::wstring& filename, const char* mode);
+
+	// Creates or truncates filename and writes byteSize bytes to it.
+	static bool WriteFile(const std::wstring& filename, const void* data, std::size_t byteSize);
+
+	// Reads the whole of filename into contents.
+	static bool ReadFile(const std::wstring& filename, std::string& contents);
+};
@@ -0,0 +1,79 @@
+//***************************************************************************************
+// FrameArena.cpp
+//***************************************************************************************
+
+#include "FrameArena.h"
+#include <algorithm>
+#include <cassert>
+
+FrameArena::FrameArena(std::size_t initialSize)
+{
+	AddChunk(initialSize);
+}
+
+void* FrameArena::Allocate(std::size_t byteSize, std::size_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	// Chunks come from new[], so aligning the offset only works up to its alignment;
+	// align the address instead.
+	Chunk* chunk = &mChunks.back();
+	std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk->Memory.get());
+	std::size_t offset = ((base + mOffset + alignment - 1) & ~(std::uintptr_t)(alignment - 1)) - base;
+
+	if(offset + byteSize > chunk->Size)
+	{
+		AddChunk(byteSize + alignment);
+
+		chunk = &mChunks.back();
+		base = reinterpret_cast<std::uintptr_t>(chunk->Memory.get());
+		offset = ((base + alignment - 1) & ~(std::uintptr_t)(alignment - 1)) - base;
+	}
+
+	mStats.UsedBytes += offset - mOffset + byteSize;
+	mStats.PeakBytes = std::max<std::size_t>(mStats.PeakBytes, mStats.UsedBytes);
+	mOffset = offset + byteSize;
+
+	return chunk->Memory.get() + offset;
+}
+
+void FrameArena::Reset()
+{
+	if(mChunks.size() > 1)
+	{
+		// The last frame did not fit; make one chunk that would have held it.
+		const std::size_t capacity = mStats.Capacity;
+		mChunks.clear();
+		mStats.Capacity = 0;
+		mStats.ChunkCount = 0;
+		AddChunk(capacity);
+	}
+
+	mOffset = 0;
+	mStats.UsedBytes = 0;
+}
+
+FrameArena::Stats FrameArena::GetStats()const
+{
+	return mStats;
+}
+
+void FrameArena::AddChunk(std::size_t minSize)
+{
+	// At least double the arena, so a frame that keeps growing adds few chunks.
+	std::size_t size = std::max<std::size_t>(minSize, mStats.Capacity);
+	size = std::max<std::size_t>(size, 256);
+
+	if(!mChunks.empty())
+		mStats.UsedBytes += mChunks.back().Size - mOffset;
+
+	Chunk chunk;
+	chunk.Memory.reset(new std::uint8_t[size]);
+	chunk.Size = size;
+	mChunks.push_back(std::move(chunk));
+	mOffset = 0;
+
+	mStats.Capacity += size;
+	mStats.ChunkCount++;
+	mStats.HeapAllocationCount++;
+}
@@ -0,0 +1,132 @@
+//***************************************************************************************
+// FrameArena.h
+//
+// Monotonic allocator for data that lives for one frame: draw lists, scratch arrays and
+// the like.  Allocating bumps an offset; nothing is freed until Reset(), which gives all
+// of it back at once.  Each FrameResource owns one and resets it when the GPU passes the
+// frame's fence, so memory handed out while building a frame stays valid as long as the
+// frame is in flight.
+//
+// The arena grows by adding chunks.  Reset() replaces several chunks by one big enough
+// for all of them, so once a frame of a given size has been seen, later frames of that
+// size allocate nothing from the heap.
+//
+// FrameAllocator<T> adapts an arena for the standard containers; FrameVector<T> is a
+// std::vector that allocates from one.  Their deallocate() does nothing, so a vector
+// that grows leaves its old storage in the arena until Reset() (reserve() avoids that).
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class FrameArena
+{
+public:
+	struct Stats
+	{
+		// Handed out since the last Reset().
+		std::size_t UsedBytes = 0;
+
+		// Highest UsedBytes seen.
+		std::size_t PeakBytes = 0;
+
+		// Bytes of the chunks held.
+		std::size_t Capacity = 0;
+		std::size_t ChunkCount = 0;
+
+		// Chunks allocated from the heap since the arena was created; it stops changing
+		// once the arena has reached the size of the largest frame.
+		std::size_t HeapAllocationCount = 0;
+	};
+
+	explicit FrameArena(std::size_t initialSize = 64*1024);
+	FrameArena(const FrameArena& rhs) = delete;
+	FrameArena& operator=(const FrameArena& rhs) = delete;
+
+	// alignment is a power of two.  Never returns null; throws std::bad_alloc like new.
+	void* Allocate(std::size_t byteSize, std::size_t alignment = alignof(std::max_align_t));
+
+	// Uninitialized storage for count objects of type T.
+	template<typename T>
+	T* AllocateArray(std::size_t count)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	///<summary>
+	/// Gives back everything allocated since the last call.  Only call it once nothing
+	/// uses that memory any more: for a frame's arena, when the frame's fence has passed.
+	///</summary>
+	void Reset();
+
+	Stats GetStats()const;
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<std::uint8_t[]> Memory;
+		std::size_t Size = 0;
+	};
+
+	void AddChunk(std::size_t minSize);
+
+private:
+	std::vector<Chunk> mChunks;
+
+	// Allocations come from the last chunk; earlier ones are full.
+	std::size_t mOffset = 0;
+
+	Stats mStats;
+};
+
+template<typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	explicit FrameAllocator(FrameArena& arena) noexcept : mArena(&arena)
+	{
+	}
+
+	template<typename U>
+	FrameAllocator(const FrameAllocator<U>& rhs) noexcept : mArena(rhs.GetArena())
+	{
+	}
+
+	T* allocate(std::size_t count)
+	{
+		return mArena->AllocateArray<T>(count);
+	}
+
+	void deallocate(T*, std::size_t) noexcept
+	{
+	}
+
+	FrameArena* GetArena()const noexcept
+	{
+		return mArena;
+	}
+
+private:
+	FrameArena* mArena = nullptr;
+};
+
+template<typename T, typename U>
+bool operator==(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) noexcept
+{
+	return lhs.GetArena() == rhs.GetArena();
+}
+
+template<typename T, typename U>
+bool operator!=(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,152 @@
+//***************************************************************************************
+// FramePacer.cpp
+//***************************************************************************************
+
+#include "FramePacer.h"
+#include <algorithm>
+
+const int FramePacer::MinDepth;
+const int FramePacer::MaxDepth;
+
+FramePacer::FramePacer(int depth)
+	: mDepth(std::min<int>(std::max<int>(depth, MinDepth), MaxDepth))
+{
+}
+
+void FramePacer::SetDepth(int depth)
+{
+	mAdaptive = false;
+	ChangeDepth(std::min<int>(std::max<int>(depth, MinDepth), MaxDepth));
+}
+
+int FramePacer::GetDepth()const
+{
+	return mDepth;
+}
+
+void FramePacer::SetAdaptive(bool adaptive)
+{
+	mAdaptive = adaptive;
+	mWindowFrames = 0;
+	mWindowWaitMs = 0.0f;
+	mWindowFrameMs = 0.0f;
+	mHoldFrames = 0;
+
+	if(mAdaptive)
+	{
+		const int minDepth = std::max<int>(mSettings.MinAdaptiveDepth, MinDepth);
+		const int maxDepth = std::min<int>(mSettings.MaxAdaptiveDepth, MaxDepth);
+		ChangeDepth(std::min<int>(std::max<int>(mDepth, minDepth), maxDepth));
+	}
+}
+
+bool FramePacer::IsAdaptive()const
+{
+	return mAdaptive;
+}
+
+void FramePacer::SetSettings(const Settings& settings)
+{
+	mSettings = settings;
+}
+
+const FramePacer::Settings& FramePacer::GetSettings()const
+{
+	return mSettings;
+}
+
+int FramePacer::BeginFrame()
+{
+	mFrameStart = Clock::now();
+	mWait = Clock::duration::zero();
+
+	mFrameIndex = (mFrameIndex + 1) % mDepth;
+	return mFrameIndex;
+}
+
+void FramePacer::BeginFenceWait()
+{
+	mWaitStart = Clock::now();
+}
+
+void FramePacer::EndFenceWait()
+{
+	mWait += Clock::now() - mWaitStart;
+}
+
+bool FramePacer::EndFrame()
+{
+	const float frameMs = ToMs(Clock::now() - mFrameStart);
+	const float waitMs = ToMs(mWait);
+	const float cpuMs = std::max<float>(frameMs - waitMs, 0.0f);
+
+	// A spike is judged against the average of the frames before it.
+	const float averageCpuMs = mStats.AverageCpuMs;
+	mStats.AverageCpuMs = averageCpuMs == 0.0f ? cpuMs : averageCpuMs + 0.05f*(cpuMs - averageCpuMs);
+	mStats.FenceWaitMs = waitMs;
+	mStats.CpuMs = cpuMs;
+
+	if(!mAdaptive)
+		return false;
+
+	const int minDepth = std::max<int>(mSettings.MinAdaptiveDepth, MinDepth);
+	const int maxDepth = std::min<int>(mSettings.MaxAdaptiveDepth, MaxDepth);
+
+	if(mHoldFrames > 0)
+		--mHoldFrames;
+
+	const bool spike = averageCpuMs > 0.0f &&
+		cpuMs > mSettings.SpikeFactor*averageCpuMs && cpuMs - averageCpuMs > mSettings.MinSpikeMs;
+	if(spike && mDepth < maxDepth)
+	{
+		ChangeDepth(mDepth + 1);
+		return true;
+	}
+
+	mWindowFrames++;
+	mWindowWaitMs += waitMs;
+	mWindowFrameMs += frameMs;
+	if(mWindowFrames < mSettings.WindowFrames)
+		return false;
+
+	const bool cpuAhead = mWindowWaitMs > mSettings.LowerWaitFraction*mWindowFrameMs;
+	mWindowFrames = 0;
+	mWindowWaitMs = 0.0f;
+	mWindowFrameMs = 0.0f;
+
+	if(cpuAhead && mHoldFrames == 0 && mDepth > minDepth)
+	{
+		ChangeDepth(mDepth - 1);
+		return true;
+	}
+
+	return false;
+}
+
+FramePacer::Stats FramePacer::GetStats()const
+{
+	return mStats;
+}
+
+float FramePacer::ToMs(Clock::duration duration)
+{
+	return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+void FramePacer::ChangeDepth(int depth)
+{
+	if(depth == mDepth)
+		return;
+
+	mDepth = depth;
+	mStats.DepthChangeCount++;
+
+	// Indices beyond the new depth are no longer used; start over from the first one.
+	if(mFrameIndex >= mDepth)
+		mFrameIndex = mDepth - 1;
+
+	mHoldFrames = mSettings.HoldFrames;
+	mWindowFrames = 0;
+	mWindowWaitMs = 0.0f;
+	mWindowFrameMs = 0.0f;
+}
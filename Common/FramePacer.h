@@ -0,0 +1,121 @@
+//***************************************************************************************
+// FramePacer.h
+//
+// Decides how many frames the CPU may build ahead of the GPU: the number of
+// FrameResources cycled through.  An app allocates MaxDepth frame resources and asks the
+// pacer which one to use each frame; the depth can then change between 1 and MaxDepth
+// at run time without recreating anything.
+//
+// In adaptive mode the pacer times the wait for the frame resource's fence and the CPU
+// work of each frame:
+//
+//  - When the CPU keeps waiting on the fence, it is ahead of the GPU and the frames
+//    queued in between only add input latency, so the depth goes down by one.
+//  - When a frame's CPU time spikes well above the average, the GPU would run dry if
+//    the queue were short, so the depth goes up by one at once.
+//
+// After every change the pacer holds the depth for a while before lowering it again.
+// Nothing here touches Direct3D; the caller does the waiting.
+//***************************************************************************************
+
+#pragma once
+
+#include <chrono>
+
+class FramePacer
+{
+public:
+	static const int MinDepth = 1;
+	static const int MaxDepth = 4;
+
+	struct Settings
+	{
+		// Range of depths the adaptive mode moves in.  A depth of 1 serializes CPU and
+		// GPU, so the adaptive mode stops at 2 unless told otherwise.
+		int MinAdaptiveDepth = 2;
+		int MaxAdaptiveDepth = MaxDepth;
+
+		// Frames averaged before deciding to lower the depth.
+		int WindowFrames = 60;
+
+		// Lower the depth when the fence waits take this fraction of the frame time.
+		float LowerWaitFraction = 0.15f;
+
+		// Raise the depth when a frame's CPU time exceeds the average by this factor.
+		float SpikeFactor = 1.5f;
+
+		// ... and by at least this many milliseconds, so that timer jitter on short
+		// frames does not count as a spike.
+		float MinSpikeMs = 2.0f;
+
+		// Frames after a change during which the depth is not lowered.
+		int HoldFrames = 120;
+	};
+
+	struct Stats
+	{
+		// Of the last frame, in milliseconds.
+		float FenceWaitMs = 0.0f;
+		float CpuMs = 0.0f;
+
+		// Moving average of the CPU time of a frame, in milliseconds.
+		float AverageCpuMs = 0.0f;
+
+		int DepthChangeCount = 0;
+	};
+
+	explicit FramePacer(int depth = 3);
+
+	// Fixed depth, clamped to [MinDepth, MaxDepth].  Turns adaptive mode off.
+	void SetDepth(int depth);
+	int GetDepth()const;
+
+	void SetAdaptive(bool adaptive);
+	bool IsAdaptive()const;
+
+	void SetSettings(const Settings& settings);
+	const Settings& GetSettings()const;
+
+	///<summary>
+	/// Starts timing a frame and returns the index, in [0, GetDepth()), of the frame
+	/// resource to build it in.
+	///</summary>
+	int BeginFrame();
+
+	// Bracket the wait for the frame resource's fence, whether or not it blocks.
+	void BeginFenceWait();
+	void EndFenceWait();
+
+	///<summary>
+	/// Ends the frame's timing; in adaptive mode this may change the depth for the next
+	/// frame.  Returns true if the depth changed.
+	///</summary>
+	bool EndFrame();
+
+	Stats GetStats()const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static float ToMs(Clock::duration duration);
+	void ChangeDepth(int depth);
+
+private:
+	int mDepth = 3;
+	int mFrameIndex = -1;
+	bool mAdaptive = false;
+	Settings mSettings;
+
+	Clock::time_point mFrameStart;
+	Clock::time_point mWaitStart;
+	Clock::duration mWait = Clock::duration::zero();
+
+	// Sums over the current window.
+	int mWindowFrames = 0;
+	float mWindowWaitMs = 0.0f;
+	float mWindowFrameMs = 0.0f;
+
+	int mHoldFrames = 0;
+
+	Stats mStats;
+};
@@ -0,0 +1,163 @@
+//***************************************************************************************
+// GeometryHeap.cpp
+//***************************************************************************************
+
+#include "GeometryHeap.h"
+#include "SubresourceCopy.h"
+
+using Microsoft::WRL::ComPtr;
+
+const UINT64 GeometryHeap::MinBlockSize;
+
+namespace
+{
+	UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+GeometryHeap::GeometryHeap(ID3D12Device* device, UINT64 pageSize)
+	: md3dDevice(device), mPageSize(pageSize)
+{
+}
+
+GeometryBuffer GeometryHeap::Allocate(UINT64 byteSize)
+{
+	GeometryBuffer buffer;
+	buffer.Size = byteSize;
+
+	UINT64 offset = BuddyAllocator::InvalidOffset;
+	for(UINT i = 0; i < (UINT)mPages.size() && offset == BuddyAllocator::InvalidOffset; ++i)
+	{
+		if(mPages[i].Blocks == nullptr)
+			continue;
+
+		offset = mPages[i].Blocks->Allocate(byteSize);
+		buffer.Page = i;
+	}
+
+	if(offset == BuddyAllocator::InvalidOffset)
+	{
+		buffer.Page = CreatePage(byteSize);
+		offset = mPages[buffer.Page].Blocks->Allocate(byteSize);
+	}
+
+	buffer.Resource = mPages[buffer.Page].Buffer;
+	buffer.Offset = offset;
+
+	mCommittedBytes += AlignUp(byteSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	return buffer;
+}
+
+GeometryBuffer GeometryHeap::CreateBuffer(ID3D12GraphicsCommandList* cmdList, const void* initData, UINT64 byteSize,
+	ComPtr<ID3D12Resource>& uploadBuffer)
+{
+	GeometryBuffer buffer = Allocate(byteSize);
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
+	d3dUtil::TrackResource(uploadBuffer.Get(), MemoryTag::Upload);
+
+	const CD3DX12_RANGE readRange(0, 0);
+	void* mappedData = nullptr;
+	ThrowIfFailed(uploadBuffer->Map(0, &readRange, &mappedData));
+	SubresourceCopy::CopyBytes(mappedData, initData, (size_t)byteSize, SubresourceCopy::Destination::WriteCombined);
+	uploadBuffer->Unmap(0, nullptr);
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(buffer.Resource.Get(),
+		D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST));
+	cmdList->CopyBufferRegion(buffer.Resource.Get(), buffer.Offset, uploadBuffer.Get(), 0, byteSize);
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(buffer.Resource.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+
+	return buffer;
+}
+
+GeometryBuffer GeometryHeap::CreateBuffer(StagingManager& staging, const void* initData, UINT64 byteSize)
+{
+	GeometryBuffer buffer = Allocate(byteSize);
+	staging.QueueBufferCopy(buffer.Resource.Get(), buffer.Offset, initData, byteSize,
+		D3D12_RESOURCE_STATE_GENERIC_READ);
+	return buffer;
+}
+
+void GeometryHeap::Free(const GeometryBuffer& buffer)
+{
+	Page& page = mPages[buffer.Page];
+	page.Blocks->Free(buffer.Offset);
+	mCommittedBytes -= AlignUp(buffer.Size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+	if(page.Blocks->IsEmpty())
+		page = Page();
+}
+
+GeometryHeap::Stats GeometryHeap::GetStats()const
+{
+	Stats stats;
+	stats.CommittedBytes = mCommittedBytes;
+
+	for(const Page& page : mPages)
+	{
+		if(page.Blocks == nullptr)
+			continue;
+
+		const BuddyAllocator::Stats blocks = page.Blocks->GetStats();
+		stats.PageCount++;
+		stats.HeapBytes += blocks.Capacity;
+		stats.Blocks.Capacity += blocks.Capacity;
+		stats.Blocks.RequestedBytes += blocks.RequestedBytes;
+		stats.Blocks.AllocatedBytes += blocks.AllocatedBytes;
+		stats.Blocks.AllocationCount += blocks.AllocationCount;
+		stats.Blocks.FreeBytes += blocks.FreeBytes;
+		stats.Blocks.FreeBlockCount += blocks.FreeBlockCount;
+		stats.Blocks.LargestFreeBlock = std::max<UINT64>(stats.Blocks.LargestFreeBlock, blocks.LargestFreeBlock);
+	}
+
+	return stats;
+}
+
+UINT GeometryHeap::CreatePage(UINT64 byteSize)
+{
+	UINT64 size = mPageSize;
+	while(size < byteSize)
+		size *= 2;
+
+	Page page;
+
+	D3D12_HEAP_DESC heapDesc = {};
+	heapDesc.SizeInBytes = size;
+	heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+	ThrowIfFailed(md3dDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&page.Heap)));
+	d3dUtil::TrackObject(page.Heap.Get(), MemoryTag::Geometry, size);
+
+	ThrowIfFailed(md3dDevice->CreatePlacedResource(
+		page.Heap.Get(),
+		0,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&page.Buffer)));
+
+	page.Blocks = std::make_unique<BuddyAllocator>(size, MinBlockSize);
+
+	// Reuse the slot of a released page.
+	for(UINT i = 0; i < (UINT)mPages.size(); ++i)
+	{
+		if(mPages[i].Blocks == nullptr)
+		{
+			mPages[i] = std::move(page);
+			return i;
+		}
+	}
+
+	mPages.push_back(std::move(page));
+	return (UINT)mPages.size() - 1;
+}
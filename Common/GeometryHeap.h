@@ -0,0 +1,87 @@
+//***************************************************************************************
+// GeometryHeap.h
+//
+// Packs vertex and index buffers into a few large buffers placed in default heaps,
+// instead of one committed resource (each rounded to 64 KB) per buffer.  Every page is
+// an ID3D12Heap holding a single placed buffer that BuddyAllocator hands out ranges of;
+// a buffer is then the page's resource plus an offset, which MeshGeometry's views add.
+// Buffers larger than a page get a page of their own.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "BuddyAllocator.h"
+#include "StagingManager.h"
+
+struct GeometryBuffer
+{
+	// The page's buffer; shared by every GeometryBuffer of the page.
+	Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
+	UINT64 Offset = 0;
+	UINT64 Size = 0;
+	UINT Page = 0;
+};
+
+class GeometryHeap
+{
+public:
+	struct Stats
+	{
+		UINT PageCount = 0;
+
+		// Bytes of the heaps created.
+		UINT64 HeapBytes = 0;
+
+		// What the live buffers would take as committed resources.
+		UINT64 CommittedBytes = 0;
+
+		// Summed over all pages.
+		BuddyAllocator::Stats Blocks;
+	};
+
+	// pageSize is a power of two and a multiple of 64 KB.
+	GeometryHeap(ID3D12Device* device, UINT64 pageSize = 16*1024*1024);
+	GeometryHeap(const GeometryHeap& rhs) = delete;
+	GeometryHeap& operator=(const GeometryHeap& rhs) = delete;
+
+	// Reserves byteSize bytes; the buffer is in D3D12_RESOURCE_STATE_GENERIC_READ.
+	GeometryBuffer Allocate(UINT64 byteSize);
+
+	///<summary>
+	/// Does what d3dUtil::CreateDefaultBuffer does for a range of a page: initData is
+	/// copied through uploadBuffer, which must be kept until cmdList has executed.
+	///</summary>
+	GeometryBuffer CreateBuffer(ID3D12GraphicsCommandList* cmdList, const void* initData, UINT64 byteSize,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
+
+	// Queues the copy of initData on staging instead.
+	GeometryBuffer CreateBuffer(StagingManager& staging, const void* initData, UINT64 byteSize);
+
+	// The GPU must be done with the buffer.  Pages that become empty are released.
+	void Free(const GeometryBuffer& buffer);
+
+	Stats GetStats()const;
+
+	// Buffers are packed at this granularity, which suits vertex and index buffer views.
+	static const UINT64 MinBlockSize = 256;
+
+private:
+	struct Page
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> Heap;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		std::unique_ptr<BuddyAllocator> Blocks;
+	};
+
+	UINT CreatePage(UINT64 byteSize);
+
+private:
+	ID3D12Device* md3dDevice = nullptr;
+	UINT64 mPageSize = 0;
+
+	// Released pages leave an empty slot so page indices stay valid.
+	std::vector<Page> mPages;
+
+	UINT64 mCommittedBytes = 0;
+};
@@ -0,0 +1,334 @@
+//***************************************************************************************
+// KTXParser.cpp
+//***************************************************************************************
+
+#include "KTXParser.h"
+#include "Zlib.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+	struct VkFormatMapping
+	{
+		std::uint32_t VkFormat;
+		DXGI_FORMAT Format;
+	};
+
+	// GetVkFormat() takes the first entry of a DXGI format, so BC1 is written as RGBA.
+	const VkFormatMapping VkFormats[] =
+	{
+		{   4, DXGI_FORMAT_B5G6R5_UNORM },         // VK_FORMAT_R5G6B5_UNORM_PACK16
+		{   8, DXGI_FORMAT_B5G5R5A1_UNORM },       // VK_FORMAT_A1R5G5B5_UNORM_PACK16
+		{   9, DXGI_FORMAT_R8_UNORM },
+		{  10, DXGI_FORMAT_R8_SNORM },
+		{  13, DXGI_FORMAT_R8_UINT },
+		{  14, DXGI_FORMAT_R8_SINT },
+		{  16, DXGI_FORMAT_R8G8_UNORM },
+		{  17, DXGI_FORMAT_R8G8_SNORM },
+		{  20, DXGI_FORMAT_R8G8_UINT },
+		{  21, DXGI_FORMAT_R8G8_SINT },
+		{  37, DXGI_FORMAT_R8G8B8A8_UNORM },
+		{  38, DXGI_FORMAT_R8G8B8A8_SNORM },
+		{  41, DXGI_FORMAT_R8G8B8A8_UINT },
+		{  42, DXGI_FORMAT_R8G8B8A8_SINT },
+		{  43, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB },
+		{  44, DXGI_FORMAT_B8G8R8A8_UNORM },
+		{  50, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB },
+		{  64, DXGI_FORMAT_R10G10B10A2_UNORM },    // VK_FORMAT_A2B10G10R10_UNORM_PACK32
+		{  68, DXGI_FORMAT_R10G10B10A2_UINT },
+		{  70, DXGI_FORMAT_R16_UNORM },
+		{  71, DXGI_FORMAT_R16_SNORM },
+		{  74, DXGI_FORMAT_R16_UINT },
+		{  75, DXGI_FORMAT_R16_SINT },
+		{  76, DXGI_FORMAT_R16_FLOAT },
+		{  77, DXGI_FORMAT_R16G16_UNORM },
+		{  78, DXGI_FORMAT_R16G16_SNORM },
+		{  81, DXGI_FORMAT_R16G16_UINT },
+		{  82, DXGI_FORMAT_R16G16_SINT },
+		{  83, DXGI_FORMAT_R16G16_FLOAT },
+		{  91, DXGI_FORMAT_R16G16B16A16_UNORM },
+		{  92, DXGI_FORMAT_R16G16B16A16_SNORM },
+		{  95, DXGI_FORMAT_R16G16B16A16_UINT },
+		{  96, DXGI_FORMAT_R16G16B16A16_SINT },
+		{  97, DXGI_FORMAT_R16G16B16A16_FLOAT },
+		{  98, DXGI_FORMAT_R32_UINT },
+		{  99, DXGI_FORMAT_R32_SINT },
+		{ 100, DXGI_FORMAT_R32_FLOAT },
+		{ 101, DXGI_FORMAT_R32G32_UINT },
+		{ 102, DXGI_FORMAT_R32G32_SINT },
+		{ 103, DXGI_FORMAT_R32G32_FLOAT },
+		{ 104, DXGI_FORMAT_R32G32B32_UINT },
+		{ 105, DXGI_FORMAT_R32G32B32_SINT },
+		{ 106, DXGI_FORMAT_R32G32B32_FLOAT },
+		{ 107, DXGI_FORMAT_R32G32B32A32_UINT },
+		{ 108, DXGI_FORMAT_R32G32B32A32_SINT },
+		{ 109, DXGI_FORMAT_R32G32B32A32_FLOAT },
+		{ 122, DXGI_FORMAT_R11G11B10_FLOAT },      // VK_FORMAT_B10G11R11_UFLOAT_PACK32
+		{ 123, DXGI_FORMAT_R9G9B9E5_SHAREDEXP },   // VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+		{ 133, DXGI_FORMAT_BC1_UNORM },            // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+		{ 134, DXGI_FORMAT_BC1_UNORM_SRGB },
+		{ 131, DXGI_FORMAT_BC1_UNORM },            // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		{ 132, DXGI_FORMAT_BC1_UNORM_SRGB },
+		{ 135, DXGI_FORMAT_BC2_UNORM },
+		{ 136, DXGI_FORMAT_BC2_UNORM_SRGB },
+		{ 137, DXGI_FORMAT_BC3_UNORM },
+		{ 138, DXGI_FORMAT_BC3_UNORM_SRGB },
+		{ 139, DXGI_FORMAT_BC4_UNORM },
+		{ 140, DXGI_FORMAT_BC4_SNORM },
+		{ 141, DXGI_FORMAT_BC5_UNORM },
+		{ 142, DXGI_FORMAT_BC5_SNORM },
+		{ 143, DXGI_FORMAT_BC6H_UF16 },
+		{ 144, DXGI_FORMAT_BC6H_SF16 },
+		{ 145, DXGI_FORMAT_BC7_UNORM },
+		{ 146, DXGI_FORMAT_BC7_UNORM_SRGB },
+	};
+
+	bool InRange(std::uint64_t offset, std::uint64_t length, std::size_t byteSize)
+	{
+		return offset <= byteSize && length <= byteSize - offset;
+	}
+
+	DDSParser::Result ReadHeader(const KTX2_HEADER& header, DDSImage& image)
+	{
+		if(header.pixelWidth == 0 || (header.pixelHeight == 0 && header.pixelDepth != 0))
+			return DDSParser::Result::InvalidData;
+
+		if(header.faceCount != 1 && header.faceCount != 6)
+			return DDSParser::Result::InvalidData;
+
+		// Undefined formats carry Basis Universal data that needs transcoding.
+		image.Format = KTXParser::GetDXGIFormat(header.vkFormat);
+		if(image.Format == DXGI_FORMAT_UNKNOWN)
+			return DDSParser::Result::NotSupported;
+
+		image.Width = header.pixelWidth;
+		image.Height = std::max<std::uint32_t>(header.pixelHeight, 1);
+		image.Depth = std::max<std::uint32_t>(header.pixelDepth, 1);
+		image.MipCount = std::max<std::uint32_t>(header.levelCount, 1);
+		const std::uint64_t arraySize = (std::uint64_t)std::max<std::uint32_t>(header.layerCount, 1)*header.faceCount;
+		if(arraySize > SIZE_MAX)
+			return DDSParser::Result::NotSupported;
+		image.ArraySize = (std::size_t)arraySize;
+		image.IsCubeMap = header.faceCount == 6;
+
+		if(header.pixelDepth != 0)
+			image.Dimension = DDS_DIMENSION_TEXTURE3D;
+		else if(header.pixelHeight != 0)
+			image.Dimension = DDS_DIMENSION_TEXTURE2D;
+		else
+			image.Dimension = DDS_DIMENSION_TEXTURE1D;
+
+		if(image.IsCubeMap && (image.Dimension != DDS_DIMENSION_TEXTURE2D || image.Width != image.Height))
+			return DDSParser::Result::InvalidData;
+
+		// Direct3D has no 3D texture arrays.
+		if(image.Dimension == DDS_DIMENSION_TEXTURE3D && image.ArraySize > 1)
+			return DDSParser::Result::NotSupported;
+
+		// More mips than a 1x1 level can come from would be a corrupt header.
+		const std::size_t largest = std::max<std::size_t>(image.Width, std::max<std::size_t>(image.Height, image.Depth));
+		if(image.MipCount > 32 || (largest >> (image.MipCount - 1)) == 0)
+			return DDSParser::Result::InvalidData;
+
+		// The subresource table is sized from the header.
+		return DDSParser::CheckLimits(image);
+	}
+
+	// Lays out the subresources of one level, starting at levelData.  KTX2 stores the
+	// slices of a level one after the other: every face of layer 0, then layer 1, ...
+	void ComputeLevel(DDSImage& image, std::size_t mip, const std::uint8_t* levelData)
+	{
+		const std::size_t w = std::max<std::size_t>(image.Width >> mip, 1);
+		const std::size_t h = std::max<std::size_t>(image.Height >> mip, 1);
+		const std::size_t d = std::max<std::size_t>(image.Depth >> mip, 1);
+
+		for(std::size_t slice = 0; slice < image.ArraySize; ++slice)
+		{
+			DDSSubresource& sub = image.Subresources[slice*image.MipCount + mip];
+			DDSParser::GetSurfaceInfo(w, h, image.Format, &sub.SlicePitch, &sub.RowPitch, &sub.NumRows);
+			sub.Width = w;
+			sub.Height = h;
+			sub.Depth = d;
+			sub.Data = levelData + slice*sub.SlicePitch*d;
+		}
+	}
+
+	// Bytes of one level with every slice, which is what the level index must hold.
+	std::uint64_t GetLevelSize(const DDSImage& image, std::size_t mip)
+	{
+		std::size_t slicePitch = 0;
+		DDSParser::GetSurfaceInfo(std::max<std::size_t>(image.Width >> mip, 1),
+			std::max<std::size_t>(image.Height >> mip, 1), image.Format, &slicePitch, nullptr, nullptr);
+
+		return (std::uint64_t)slicePitch*std::max<std::size_t>(image.Depth >> mip, 1)*image.ArraySize;
+	}
+}
+
+DDSParser::Result KTXParser::ParseMemory(const std::uint8_t* data, std::size_t byteSize, DDSImage& image, TaskPool& pool)
+{
+	image = DDSImage();
+
+	if(!IsKTX2(data, byteSize) || byteSize < sizeof(KTX2_HEADER))
+		return DDSParser::Result::InvalidData;
+
+	KTX2_HEADER header;
+	std::memcpy(&header, data, sizeof(header));
+
+	DDSParser::Result result = ReadHeader(header, image);
+	if(result != DDSParser::Result::Ok)
+		return result;
+
+	const std::uint32_t scheme = header.supercompressionScheme;
+	if(scheme != KTX2_SUPERCOMPRESSION_NONE && scheme != KTX2_SUPERCOMPRESSION_ZLIB)
+		return DDSParser::Result::NotSupported;
+
+	if(!InRange(sizeof(KTX2_HEADER), image.MipCount*sizeof(KTX2_LEVEL_INDEX), byteSize) ||
+		!InRange(header.dfdByteOffset, header.dfdByteLength, byteSize))
+	{
+		return DDSParser::Result::EndOfFile;
+	}
+
+	std::vector<KTX2_LEVEL_INDEX> levels(image.MipCount);
+	std::memcpy(levels.data(), data + sizeof(KTX2_HEADER), levels.size()*sizeof(KTX2_LEVEL_INDEX));
+
+	// BitData spans every level.  Stored levels are read in place, so it covers the
+	// alignment padding between them; inflated levels are packed largest first.
+	std::uint64_t first = byteSize;
+	std::uint64_t last = 0;
+	std::uint64_t unpackedSize = 0;
+	std::vector<std::uint64_t> unpackedOffsets(image.MipCount);
+
+	for(std::size_t mip = 0; mip < image.MipCount; ++mip)
+	{
+		const KTX2_LEVEL_INDEX& level = levels[mip];
+		if(!InRange(level.byteOffset, level.byteLength, byteSize))
+			return DDSParser::Result::EndOfFile;
+
+		const std::uint64_t levelSize = GetLevelSize(image, mip);
+		if(level.uncompressedByteLength != levelSize ||
+			(scheme == KTX2_SUPERCOMPRESSION_NONE && level.byteLength != levelSize))
+		{
+			return DDSParser::Result::InvalidData;
+		}
+
+		first = std::min<std::uint64_t>(first, level.byteOffset);
+		last = std::max<std::uint64_t>(last, level.byteOffset + level.byteLength);
+		unpackedOffsets[mip] = unpackedSize;
+		unpackedSize += levelSize;
+	}
+
+	if(unpackedSize > SIZE_MAX)
+		return DDSParser::Result::NotSupported;
+
+	image.Subresources.resize(image.MipCount*image.ArraySize);
+
+	if(scheme == KTX2_SUPERCOMPRESSION_NONE)
+	{
+		image.BitData = data + first;
+		image.BitSize = (std::size_t)(last - first);
+
+		for(std::size_t mip = 0; mip < image.MipCount; ++mip)
+			ComputeLevel(image, mip, data + levels[mip].byteOffset);
+
+		return DDSParser::Result::Ok;
+	}
+
+	auto memory = std::make_shared<std::vector<std::uint8_t>>((std::size_t)unpackedSize);
+
+	// Each level is its own zlib stream.  The largest level is most of the work, so it
+	// is handed out first.
+	std::atomic<bool> failed(false);
+	pool.ParallelFor(image.MipCount, 1, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t mip = begin; mip < end; ++mip)
+		{
+			std::uint8_t* dst = memory->data() + unpackedOffsets[mip];
+			if(!Zlib::Decompress(data + levels[mip].byteOffset, (std::size_t)levels[mip].byteLength,
+				dst, (std::size_t)levels[mip].uncompressedByteLength))
+			{
+				failed = true;
+			}
+		}
+	});
+
+	if(failed)
+	{
+		image.Subresources.clear();
+		return DDSParser::Result::InvalidData;
+	}
+
+	for(std::size_t mip = 0; mip < image.MipCount; ++mip)
+		ComputeLevel(image, mip, memory->data() + unpackedOffsets[mip]);
+
+	image.BitData = memory->data();
+	image.BitSize = memory->size();
+	image.Memory = memory;
+
+	return DDSParser::Result::Ok;
+}
+
+DDSParser::Result KTXParser::ParseFile(const std::wstring& filename, DDSImage& image)
+{
+	auto file = MappedFile::Open(filename);
+	if(file == nullptr)
+		return DDSParser::Result::FileNotFound;
+
+	if(file->Size() > SIZE_MAX)
+		return DDSParser::Result::NotSupported;
+
+	DDSParser::Result result = ParseMemory(file->Data(), (std::size_t)file->Size(), image);
+	if(result == DDSParser::Result::Ok)
+		image.File = file;
+
+	return result;
+}
+
+DDSParser::Result KTXParser::ParseTextureFile(const std::wstring& filename, DDSImage& image)
+{
+	auto file = MappedFile::Open(filename);
+	if(file == nullptr)
+		return DDSParser::Result::FileNotFound;
+
+	if(file->Size() > SIZE_MAX)
+		return DDSParser::Result::NotSupported;
+
+	const std::size_t byteSize = (std::size_t)file->Size();
+	DDSParser::Result result = IsKTX2(file->Data(), byteSize) ?
+		ParseMemory(file->Data(), byteSize, image) :
+		DDSParser::ParseMemory(file->Data(), byteSize, image);
+
+	if(result == DDSParser::Result::Ok)
+		image.File = file;
+
+	return result;
+}
+
+bool KTXParser::IsKTX2(const std::uint8_t* data, std::size_t byteSize)
+{
+	return data != nullptr && byteSize >= sizeof(KTX2_IDENTIFIER) &&
+		std::memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
+
+DXGI_FORMAT KTXParser::GetDXGIFormat(std::uint32_t vkFormat)
+{
+	for(const VkFormatMapping& mapping : VkFormats)
+	{
+		if(mapping.VkFormat == vkFormat)
+			return mapping.Format;
+	}
+
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+std::uint32_t KTXParser::GetVkFormat(DXGI_FORMAT format)
+{
+	for(const VkFormatMapping& mapping : VkFormats)
+	{
+		if(mapping.Format == format)
+			return mapping.VkFormat;
+	}
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+//***************************************************************************************
+// KTXParser.h
+//
+// Device independent KTX2 parsing into the same DDSImage the DDS code produces, so the
+// loaders take either container.  Mip levels stored as they are point straight into the
+// file like DDSParser's subresources.  Levels with zlib supercompression are inflated
+// in parallel on a TaskPool into one buffer laid out for the upload, which is what keeps
+// block compressed textures small on disk without changing their GPU format.
+//
+// Only the formats with a DXGI equivalent are read.  Zstandard and BasisLZ
+// supercompression are reported as NotSupported, since they need external libraries.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+#include "TaskPool.h"
+
+//--------------------------------------------------------------------------------------
+// KTX2 file structure definitions
+//
+// See the KTX File Format Specification, version 2.0
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct KTX2_HEADER
+{
+    uint8_t     identifier[12];
+    uint32_t    vkFormat;
+    uint32_t    typeSize;
+    uint32_t    pixelWidth;
+    uint32_t    pixelHeight; // 0 for 1D textures
+    uint32_t    pixelDepth;  // 0 for everything but 3D textures
+    uint32_t    layerCount;  // 0 if not an array
+    uint32_t    faceCount;   // 6 for cube maps, 1 otherwise
+    uint32_t    levelCount;  // 0 asks the loader to generate the mips
+    uint32_t    supercompressionScheme;
+    uint32_t    dfdByteOffset;
+    uint32_t    dfdByteLength;
+    uint32_t    kvdByteOffset;
+    uint32_t    kvdByteLength;
+    uint64_t    sgdByteOffset;
+    uint64_t    sgdByteLength;
+};
+
+// Follows the header, one per mip level starting with the largest.
+struct KTX2_LEVEL_INDEX
+{
+    uint64_t    byteOffset;
+    uint64_t    byteLength;
+    uint64_t    uncompressedByteLength;
+};
+
+#pragma pack(pop)
+
+enum KTX2_SUPERCOMPRESSION
+{
+    KTX2_SUPERCOMPRESSION_NONE = 0,
+    KTX2_SUPERCOMPRESSION_BASISLZ = 1,
+    KTX2_SUPERCOMPRESSION_ZSTD = 2,
+    KTX2_SUPERCOMPRESSION_ZLIB = 3,
+};
+
+class KTXParser
+{
+public:
+	///<summary>
+	/// Parses a KTX2 file held in memory.  Levels stored as they are point into data,
+	/// which must outlive the image; supercompressed levels are inflated into
+	/// image.Memory, splitting the levels over pool.
+	///</summary>
+	static DDSParser::Result ParseMemory(const std::uint8_t* data, std::size_t byteSize, DDSImage& image,
+		TaskPool& pool = TaskPool::Default());
+
+	///<summary>
+	/// Maps the file and parses it.  The image holds on to the mapping.
+	///</summary>
+	static DDSParser::Result ParseFile(const std::wstring& filename, DDSImage& image);
+
+	///<summary>
+	/// Maps the file and parses it as KTX2 if it starts with the KTX2 identifier, as DDS
+	/// otherwise.  The loaders use it so either container can back a texture.
+	///</summary>
+	static DDSParser::Result ParseTextureFile(const std::wstring& filename, DDSImage& image);
+
+	static bool IsKTX2(const std::uint8_t* data, std::size_t byteSize);
+
+	// DXGI_FORMAT_UNKNOWN and 0 (VK_FORMAT_UNDEFINED) for formats without an equivalent.
+	static DXGI_FORMAT GetDXGIFormat(std::uint32_t vkFormat);
+	static std::uint32_t GetVkFormat(DXGI_FORMAT format);
+};
@@ -0,0 +1,259 @@
+//***************************************************************************************
+// KTXWriter.cpp
+//***************************************************************************************
+
+#include "KTXWriter.h"
+#include "FileUtil.h"
+#include "Zlib.h"
+#include <algorithm>
+#include <cstring>
+
+// Khronos data format descriptor values (see the Khronos Data Format Specification).
+#define KHR_DF_MODEL_RGBSDA     1
+#define KHR_DF_MODEL_BC1A       128
+#define KHR_DF_MODEL_BC2        129
+#define KHR_DF_MODEL_BC3        130
+#define KHR_DF_MODEL_BC4        131
+#define KHR_DF_MODEL_BC5        132
+#define KHR_DF_MODEL_BC7        134
+
+#define KHR_DF_PRIMARIES_BT709  1
+#define KHR_DF_TRANSFER_LINEAR  1
+#define KHR_DF_TRANSFER_SRGB    2
+
+#define KHR_DF_CHANNEL_COLOR    0
+#define KHR_DF_CHANNEL_RED      0
+#define KHR_DF_CHANNEL_GREEN    1
+#define KHR_DF_CHANNEL_BLUE     2
+#define KHR_DF_CHANNEL_ALPHA    15
+#define KHR_DF_CHANNEL_BC1A_ALPHAPRESENT 1
+
+#define KHR_DF_SAMPLE_DATATYPE_LINEAR 0x10
+#define KHR_DF_SAMPLE_DATATYPE_SIGNED 0x40
+
+namespace
+{
+	struct DFDSample
+	{
+		std::uint16_t BitOffset;
+		std::uint8_t BitLength;
+		std::uint8_t Channel;
+	};
+
+	// What the descriptor of a format says, apart from what DDSParser's table knows.
+	struct DFDFormat
+	{
+		std::uint8_t ColorModel;
+		bool SRGB;
+		bool Signed;
+		std::size_t SampleCount;
+		DFDSample Samples[4];
+	};
+
+	const DFDSample RGBA8Samples[4] = { { 0, 8, KHR_DF_CHANNEL_RED }, { 8, 8, KHR_DF_CHANNEL_GREEN }, { 16, 8, KHR_DF_CHANNEL_BLUE }, { 24, 8, KHR_DF_CHANNEL_ALPHA } };
+	const DFDSample BGRA8Samples[4] = { { 0, 8, KHR_DF_CHANNEL_BLUE }, { 8, 8, KHR_DF_CHANNEL_GREEN }, { 16, 8, KHR_DF_CHANNEL_RED }, { 24, 8, KHR_DF_CHANNEL_ALPHA } };
+	const DFDSample BC1Samples[1] = { { 0, 64, KHR_DF_CHANNEL_BC1A_ALPHAPRESENT } };
+	const DFDSample BC2Samples[2] = { { 0, 64, KHR_DF_CHANNEL_ALPHA }, { 64, 64, KHR_DF_CHANNEL_COLOR } };
+	const DFDSample BC4Samples[1] = { { 0, 64, KHR_DF_CHANNEL_RED } };
+	const DFDSample BC5Samples[2] = { { 0, 64, KHR_DF_CHANNEL_RED }, { 64, 64, KHR_DF_CHANNEL_GREEN } };
+	const DFDSample BC7Samples[1] = { { 0, 128, KHR_DF_CHANNEL_COLOR } };
+
+	template<std::size_t N>
+	DFDFormat MakeDFDFormat(std::uint8_t colorModel, bool srgb, bool isSigned, const DFDSample (&samples)[N])
+	{
+		DFDFormat dfd = { colorModel, srgb, isSigned, N, {} };
+		std::copy(samples, samples + N, dfd.Samples);
+		return dfd;
+	}
+
+	bool GetDFDFormat(DXGI_FORMAT format, DFDFormat& dfd)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:      dfd = MakeDFDFormat(KHR_DF_MODEL_RGBSDA, false, false, RGBA8Samples); return true;
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: dfd = MakeDFDFormat(KHR_DF_MODEL_RGBSDA, true, false, RGBA8Samples); return true;
+		case DXGI_FORMAT_B8G8R8A8_UNORM:      dfd = MakeDFDFormat(KHR_DF_MODEL_RGBSDA, false, false, BGRA8Samples); return true;
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB: dfd = MakeDFDFormat(KHR_DF_MODEL_RGBSDA, true, false, BGRA8Samples); return true;
+		case DXGI_FORMAT_BC1_UNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC1A, false, false, BC1Samples); return true;
+		case DXGI_FORMAT_BC1_UNORM_SRGB:      dfd = MakeDFDFormat(KHR_DF_MODEL_BC1A, true, false, BC1Samples); return true;
+		case DXGI_FORMAT_BC2_UNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC2, false, false, BC2Samples); return true;
+		case DXGI_FORMAT_BC2_UNORM_SRGB:      dfd = MakeDFDFormat(KHR_DF_MODEL_BC2, true, false, BC2Samples); return true;
+		case DXGI_FORMAT_BC3_UNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC3, false, false, BC2Samples); return true;
+		case DXGI_FORMAT_BC3_UNORM_SRGB:      dfd = MakeDFDFormat(KHR_DF_MODEL_BC3, true, false, BC2Samples); return true;
+		case DXGI_FORMAT_BC4_UNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC4, false, false, BC4Samples); return true;
+		case DXGI_FORMAT_BC4_SNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC4, false, true, BC4Samples); return true;
+		case DXGI_FORMAT_BC5_UNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC5, false, false, BC5Samples); return true;
+		case DXGI_FORMAT_BC5_SNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC5, false, true, BC5Samples); return true;
+		case DXGI_FORMAT_BC7_UNORM:           dfd = MakeDFDFormat(KHR_DF_MODEL_BC7, false, false, BC7Samples); return true;
+		case DXGI_FORMAT_BC7_UNORM_SRGB:      dfd = MakeDFDFormat(KHR_DF_MODEL_BC7, true, false, BC7Samples); return true;
+		default:                              return false;
+		}
+	}
+
+	template<typename T>
+	void AppendValue(std::vector<std::uint8_t>& data, T value)
+	{
+		const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&value);
+		data.insert(data.end(), p, p + sizeof(value));
+	}
+
+	// The descriptor, preceded by its total size as the file stores it.  Block formats
+	// describe one 4x4 block; the others one texel.
+	void AppendDFD(std::vector<std::uint8_t>& data, const DXGIFormatInfo& info, const DFDFormat& dfd)
+	{
+		const bool block = info.Layout == DXGIFormatLayout::Block;
+		const std::uint16_t blockSize = (std::uint16_t)(24 + 16*dfd.SampleCount);
+
+		AppendValue<std::uint32_t>(data, sizeof(std::uint32_t) + blockSize);
+		AppendValue<std::uint32_t>(data, 0);          // vendorId and descriptorType: Khronos basic
+		AppendValue<std::uint16_t>(data, 2);          // versionNumber
+		AppendValue<std::uint16_t>(data, blockSize);
+		AppendValue<std::uint8_t>(data, dfd.ColorModel);
+		AppendValue<std::uint8_t>(data, KHR_DF_PRIMARIES_BT709);
+		AppendValue<std::uint8_t>(data, dfd.SRGB ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR);
+		AppendValue<std::uint8_t>(data, 0);           // flags: straight alpha
+
+		// texelBlockDimension, each one less than the size.
+		AppendValue<std::uint8_t>(data, block ? 3 : 0);
+		AppendValue<std::uint8_t>(data, block ? 3 : 0);
+		AppendValue<std::uint16_t>(data, 0);
+
+		// bytesPlane0 holds the whole block; planes 1-7 are unused.
+		AppendValue<std::uint8_t>(data, block ? info.ElementBytes : (std::uint8_t)(info.BitsPerPixel / 8));
+		for(int i = 1; i < 8; ++i)
+			AppendValue<std::uint8_t>(data, 0);
+
+		for(std::size_t i = 0; i < dfd.SampleCount; ++i)
+		{
+			const DFDSample& sample = dfd.Samples[i];
+
+			// Alpha is never sRGB encoded.
+			std::uint8_t channel = sample.Channel;
+			if(dfd.SRGB && !block && sample.Channel == KHR_DF_CHANNEL_ALPHA)
+				channel |= KHR_DF_SAMPLE_DATATYPE_LINEAR;
+			if(dfd.Signed)
+				channel |= KHR_DF_SAMPLE_DATATYPE_SIGNED;
+
+			AppendValue<std::uint16_t>(data, sample.BitOffset);
+			AppendValue<std::uint8_t>(data, (std::uint8_t)(sample.BitLength - 1));
+			AppendValue<std::uint8_t>(data, channel);
+			AppendValue<std::uint32_t>(data, 0);      // samplePosition
+
+			// Block formats map the full range of the decoded value; texels their bit count.
+			const std::uint32_t upper = block ? 0xffffffffu : (1u << sample.BitLength) - 1;
+			AppendValue<std::uint32_t>(data, dfd.Signed ? 0x80000000u : 0);
+			AppendValue<std::uint32_t>(data, dfd.Signed ? 0x7fffffffu : upper);
+		}
+	}
+
+	std::size_t AlignUp(std::size_t value, std::size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+bool KTXWriter::IsSupported(DXGI_FORMAT format)
+{
+	DFDFormat dfd;
+	return GetDFDFormat(format, dfd);
+}
+
+bool KTXWriter::SaveToMemory(const DDSImage& image, const Options& options, std::vector<std::uint8_t>& data,
+	TaskPool& pool)
+{
+	DFDFormat dfd;
+	if(!GetDFDFormat(image.Format, dfd) || image.Subresources.empty() ||
+		image.Subresources.size() != image.MipCount*image.ArraySize ||
+		(image.Dimension == DDS_DIMENSION_TEXTURE3D && image.ArraySize > 1))
+	{
+		return false;
+	}
+
+	const bool supercompress = options.Supercompression == KTX2_SUPERCOMPRESSION_ZLIB;
+	const DXGIFormatInfo& info = DDSParser::GetFormatInfo(image.Format);
+	const std::size_t faces = image.IsCubeMap ? 6 : 1;
+	const std::size_t layers = image.ArraySize / faces;
+
+	// Gathers the slices of every level into one run, the way the file stores them, and
+	// compresses the levels concurrently.
+	std::vector<std::vector<std::uint8_t>> levels(image.MipCount);
+	std::vector<std::uint64_t> levelSizes(image.MipCount);
+	pool.ParallelFor(image.MipCount, 1, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t mip = begin; mip < end; ++mip)
+		{
+			std::vector<std::uint8_t> level;
+			for(std::size_t slice = 0; slice < image.ArraySize; ++slice)
+			{
+				const DDSSubresource& sub = image.Subresources[slice*image.MipCount + mip];
+				level.insert(level.end(), sub.Data, sub.Data + sub.SlicePitch*sub.Depth);
+			}
+
+			levelSizes[mip] = level.size();
+			if(supercompress)
+				Zlib::Compress(level.data(), level.size(), levels[mip], options.Effort);
+			else
+				levels[mip].swap(level);
+		}
+	});
+
+	KTX2_HEADER header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+	header.vkFormat = KTXParser::GetVkFormat(image.Format);
+	header.typeSize = 1;
+	header.pixelWidth = (std::uint32_t)image.Width;
+	header.pixelHeight = image.Dimension == DDS_DIMENSION_TEXTURE1D ? 0 : (std::uint32_t)image.Height;
+	header.pixelDepth = image.Dimension == DDS_DIMENSION_TEXTURE3D ? (std::uint32_t)image.Depth : 0;
+	header.layerCount = layers > 1 ? (std::uint32_t)layers : 0;
+	header.faceCount = (std::uint32_t)faces;
+	header.levelCount = (std::uint32_t)image.MipCount;
+	header.supercompressionScheme = supercompress ? KTX2_SUPERCOMPRESSION_ZLIB : KTX2_SUPERCOMPRESSION_NONE;
+
+	data.clear();
+	data.resize(sizeof(KTX2_HEADER) + image.MipCount*sizeof(KTX2_LEVEL_INDEX));
+
+	header.dfdByteOffset = (std::uint32_t)data.size();
+	AppendDFD(data, info, dfd);
+	header.dfdByteLength = (std::uint32_t)(data.size() - header.dfdByteOffset);
+
+	// Stored levels start on multiples of both the block (or texel) size and 4, which for
+	// the formats written here is the block size.
+	std::size_t alignment = 1;
+	if(!supercompress)
+		alignment = info.Layout == DXGIFormatLayout::Block ? info.ElementBytes : info.BitsPerPixel / 8;
+
+	std::vector<KTX2_LEVEL_INDEX> index(image.MipCount);
+	for(std::size_t mip = image.MipCount; mip-- > 0;)
+	{
+		data.resize(AlignUp(data.size(), alignment));
+		index[mip].byteOffset = data.size();
+		index[mip].byteLength = levels[mip].size();
+		index[mip].uncompressedByteLength = levelSizes[mip];
+		data.insert(data.end(), levels[mip].begin(), levels[mip].end());
+	}
+
+	std::memcpy(data.data(), &header, sizeof(header));
+	std::memcpy(data.data() + sizeof(header), index.data(), index.size()*sizeof(KTX2_LEVEL_INDEX));
+
+	return true;
+}
+
+bool KTXWriter::SaveToMemory(const DDSImage& image, std::vector<std::uint8_t>& data)
+{
+	return SaveToMemory(image, Options(), data);
+}
+
+bool KTXWriter::SaveToFile(const std::wstring& filename, const DDSImage& image, const Options& options)
+{
+	std::vector<std::uint8_t> data;
+	if(!SaveToMemory(image, options, data))
+		return false;
+
+	return FileUtil::WriteFile(filename, data.data(), data.size());
+}
+
+bool KTXWriter::SaveToFile(const std::wstring& filename, const DDSImage& image)
+{
+	return SaveToFile(filename, image, Options());
+}
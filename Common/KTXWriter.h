@@ -0,0 +1,40 @@
+//***************************************************************************************
+// KTXWriter.h
+//
+// Serializes a DDSImage into a KTX2 file, optionally with every mip level compressed
+// as its own zlib stream so KTXParser can inflate the levels in parallel.  Only the
+// formats the texture tools produce are written, since each needs a data format
+// descriptor: RGBA8, BGRA8 and BC1-BC5 and BC7, UNORM or SRGB.
+//***************************************************************************************
+
+#pragma once
+
+#include "KTXParser.h"
+
+class KTXWriter
+{
+public:
+	struct Options
+	{
+		// KTX2_SUPERCOMPRESSION_NONE or KTX2_SUPERCOMPRESSION_ZLIB.
+		KTX2_SUPERCOMPRESSION Supercompression = KTX2_SUPERCOMPRESSION_ZLIB;
+
+		// Zlib::Compress effort, 1 to 9.
+		int Effort = 9;
+	};
+
+	// True for the formats SaveToMemory() can describe.
+	static bool IsSupported(DXGI_FORMAT format);
+
+	///<summary>
+	/// Writes the header, the level index, the data format descriptor and the mip levels,
+	/// smallest first as the format asks.  Levels are compressed concurrently on pool.
+	/// Returns false for unsupported formats and 3D texture arrays.
+	///</summary>
+	static bool SaveToMemory(const DDSImage& image, const Options& options, std::vector<std::uint8_t>& data,
+		TaskPool& pool = TaskPool::Default());
+	static bool SaveToMemory(const DDSImage& image, std::vector<std::uint8_t>& data);
+
+	static bool SaveToFile(const std::wstring& filename, const DDSImage& image, const Options& options);
+	static bool SaveToFile(const std::wstring& filename, const DDSImage& image);
+};
@@ -0,0 +1,102 @@
+//***************************************************************************************
+// MappedFile.cpp
+//***************************************************************************************
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::wstring& filename)
+{
+	std::shared_ptr<MappedFile> file(new MappedFile());
+
+	file->mFile = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file->mFile == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize = {};
+	if(!GetFileSizeEx(file->mFile, &fileSize) || fileSize.QuadPart == 0)
+		return nullptr;
+
+	file->mMapping = CreateFileMappingW(file->mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(file->mMapping == nullptr)
+		return nullptr;
+
+	file->mView = static_cast<const std::uint8_t*>(MapViewOfFile(file->mMapping, FILE_MAP_READ, 0, 0, 0));
+	if(file->mView == nullptr)
+		return nullptr;
+
+	file->mSize = static_cast<std::uint64_t>(fileSize.QuadPart);
+
+	return file;
+}
+
+MappedFile::~MappedFile()
+{
+	if(mView != nullptr)
+		UnmapViewOfFile(mView);
+
+	if(mMapping != nullptr)
+		CloseHandle(mMapping);
+
+	if(mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <vector>
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::wstring& filename)
+{
+	// POSIX paths are bytes; convert using the current locale.
+	std::vector<char> path(filename.size()*MB_CUR_MAX + 1);
+	if(std::wcstombs(path.data(), filename.c_str(), path.size()) == (size_t)-1)
+		return nullptr;
+
+	std::shared_ptr<MappedFile> file(new MappedFile());
+
+	file->mFile = open(path.data(), O_RDONLY);
+	if(file->mFile == -1)
+		return nullptr;
+
+	struct stat info;
+	if(fstat(file->mFile, &info) != 0 || info.st_size == 0)
+		return nullptr;
+
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file->mFile, 0);
+	if(view == MAP_FAILED)
+		return nullptr;
+
+	file->mView = static_cast<const std::uint8_t*>(view);
+	file->mSize = static_cast<std::uint64_t>(info.st_size);
+
+	return file;
+}
+
+MappedFile::~MappedFile()
+{
+	if(mView != nullptr)
+		munmap(const_cast<std::uint8_t*>(mView), (size_t)mSize);
+
+	if(mFile != -1)
+		close(mFile);
+}
+
+#endif
+
+const std::uint8_t* MappedFile::Data()const
+{
+	return mView;
+}
+
+std::uint64_t MappedFile::Size()const
+{
+	return mSize;
+}
@@ -0,0 +1,43 @@
+//***************************************************************************************
+// MappedFile.h
+//
+// Read-only memory-mapped view of a whole file.  Instances are handed out through
+// std::shared_ptr so that anything pointing into the view (for example a blob that
+// wraps part of a cooked mesh) can keep the mapping alive.  Besides Win32 it builds
+// on POSIX systems, so the parsers on top of it can be run and tested without Windows.
+//***************************************************************************************
+
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class MappedFile
+{
+public:
+	// Returns nullptr if the file does not exist, is empty or cannot be mapped.
+	static std::shared_ptr<MappedFile> Open(const std::wstring& filename);
+
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+	~MappedFile();
+
+	const std::uint8_t* Data()const;
+	std::uint64_t Size()const;
+
+private:
+	MappedFile() = default;
+
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+	const std::uint8_t* mView = nullptr;
+	std::uint64_t mSize = 0;
+};
@@ -0,0 +1,151 @@
+//***************************************************************************************
+// MemoryTracker.cpp
+//***************************************************************************************
+
+#include "MemoryTracker.h"
+#include "FileUtil.h"
+#include <atomic>
+
+namespace
+{
+	const int TagCount = (int)MemoryTag::Count;
+
+	struct Counters
+	{
+		std::atomic<std::uint64_t> LiveBytes{ 0 };
+		std::atomic<std::uint64_t> PeakBytes{ 0 };
+		std::atomic<std::uint64_t> LiveCount{ 0 };
+		std::atomic<std::uint64_t> TotalCount{ 0 };
+		std::atomic<std::uint64_t> BudgetBytes{ 0 };
+	};
+
+	// Zero-initialized before any constructor runs, so static objects may report too.
+	Counters gTags[TagCount];
+	Counters gTotal;
+
+	const char* const gTagNames[TagCount] =
+	{
+		"textures",
+		"geometry",
+		"geometry_cpu",
+		"upload",
+		"constant_buffers",
+		"waves",
+	};
+
+	void RaisePeak(std::atomic<std::uint64_t>& peak, std::uint64_t live)
+	{
+		std::uint64_t current = peak.load(std::memory_order_relaxed);
+		while(live > current && !peak.compare_exchange_weak(current, live, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void AppendField(std::string& json, const char* name, std::uint64_t value, bool last = false)
+	{
+		json += "\"";
+		json += name;
+		json += "\": ";
+		json += std::to_string(value);
+		json += last ? "" : ", ";
+	}
+}
+
+void MemoryTracker::Allocate(MemoryTag tag, std::uint64_t byteSize)
+{
+	Counters& c = gTags[(int)tag];
+	RaisePeak(c.PeakBytes, c.LiveBytes.fetch_add(byteSize, std::memory_order_relaxed) + byteSize);
+	c.LiveCount.fetch_add(1, std::memory_order_relaxed);
+	c.TotalCount.fetch_add(1, std::memory_order_relaxed);
+
+	RaisePeak(gTotal.PeakBytes, gTotal.LiveBytes.fetch_add(byteSize, std::memory_order_relaxed) + byteSize);
+}
+
+void MemoryTracker::Free(MemoryTag tag, std::uint64_t byteSize)
+{
+	Counters& c = gTags[(int)tag];
+	c.LiveBytes.fetch_sub(byteSize, std::memory_order_relaxed);
+	c.LiveCount.fetch_sub(1, std::memory_order_relaxed);
+
+	gTotal.LiveBytes.fetch_sub(byteSize, std::memory_order_relaxed);
+}
+
+MemoryTracker::TagStats MemoryTracker::GetStats(MemoryTag tag)
+{
+	const Counters& c = gTags[(int)tag];
+
+	TagStats stats;
+	stats.LiveBytes = c.LiveBytes.load(std::memory_order_relaxed);
+	stats.PeakBytes = c.PeakBytes.load(std::memory_order_relaxed);
+	stats.LiveCount = c.LiveCount.load(std::memory_order_relaxed);
+	stats.TotalCount = c.TotalCount.load(std::memory_order_relaxed);
+	stats.BudgetBytes = c.BudgetBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+std::uint64_t MemoryTracker::GetTotalLiveBytes()
+{
+	return gTotal.LiveBytes.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MemoryTracker::GetTotalPeakBytes()
+{
+	return gTotal.PeakBytes.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::SetBudget(MemoryTag tag, std::uint64_t byteSize)
+{
+	gTags[(int)tag].BudgetBytes.store(byteSize, std::memory_order_relaxed);
+}
+
+bool MemoryTracker::IsOverBudget(MemoryTag tag)
+{
+	const TagStats stats = GetStats(tag);
+	return stats.BudgetBytes != 0 && stats.LiveBytes > stats.BudgetBytes;
+}
+
+void MemoryTracker::ResetPeaks()
+{
+	for(Counters& c : gTags)
+		c.PeakBytes.store(c.LiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	gTotal.PeakBytes.store(gTotal.LiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+	return gTagNames[(int)tag];
+}
+
+std::string MemoryTracker::ToJson()
+{
+	std::string json = "{\n  \"tags\": {\n";
+	for(int i = 0; i < TagCount; ++i)
+	{
+		const TagStats stats = GetStats((MemoryTag)i);
+
+		json += "    \"";
+		json += gTagNames[i];
+		json += "\": { ";
+		AppendField(json, "live_bytes", stats.LiveBytes);
+		AppendField(json, "peak_bytes", stats.PeakBytes);
+		AppendField(json, "live_count", stats.LiveCount);
+		AppendField(json, "total_count", stats.TotalCount);
+		AppendField(json, "budget_bytes", stats.BudgetBytes);
+		json += "\"over_budget\": ";
+		json += IsOverBudget((MemoryTag)i) ? "true" : "false";
+		json += i + 1 < TagCount ? " },\n" : " }\n";
+	}
+	json += "  },\n  \"total\": { ";
+	AppendField(json, "live_bytes", GetTotalLiveBytes());
+	AppendField(json, "peak_bytes", GetTotalPeakBytes(), true);
+	json += " }\n}\n";
+
+	return json;
+}
+
+bool MemoryTracker::WriteJson(const std::wstring& filename)
+{
+	const std::string json = ToJson();
+	return FileUtil::WriteFile(filename, json.data(), json.size());
+}
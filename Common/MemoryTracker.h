@@ -0,0 +1,135 @@
+//***************************************************************************************
+// MemoryTracker.h
+//
+// Process-wide counters of the memory each subsystem holds, by tag: live bytes, the
+// highest live bytes seen and the number of allocations.  Subsystems report their own
+// allocations and frees; d3dUtil::TrackResource() does it for D3D12 objects, whose
+// release is reported when the object is destroyed.  ToJson() and WriteJson() dump the
+// counters, with any budgets set, so runs can be compared against each other.
+//
+// The counters are atomics; any thread may report.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+enum class MemoryTag : int
+{
+	// Texture resources.
+	Textures = 0,
+
+	// Vertex and index buffers in default heaps.
+	Geometry,
+
+	// System memory copies of vertex and index data (MeshGeometry's CPU blobs).
+	GeometryCpu,
+
+	// Upload heaps: staging buffers, upload rings and dynamic buffers.
+	Upload,
+
+	// Upload buffers holding constant buffers.
+	ConstantBuffers,
+
+	// Wave simulation state.
+	Waves,
+
+	Count
+};
+
+class MemoryTracker
+{
+public:
+	struct TagStats
+	{
+		std::uint64_t LiveBytes = 0;
+		std::uint64_t PeakBytes = 0;
+		std::uint64_t LiveCount = 0;
+		std::uint64_t TotalCount = 0;
+
+		// 0 when no budget is set.
+		std::uint64_t BudgetBytes = 0;
+	};
+
+	static void Allocate(MemoryTag tag, std::uint64_t byteSize);
+	static void Free(MemoryTag tag, std::uint64_t byteSize);
+
+	static TagStats GetStats(MemoryTag tag);
+
+	// Live bytes of all tags together, and the highest they have been.
+	static std::uint64_t GetTotalLiveBytes();
+	static std::uint64_t GetTotalPeakBytes();
+
+	static void SetBudget(MemoryTag tag, std::uint64_t byteSize);
+	static bool IsOverBudget(MemoryTag tag);
+
+	// Starts the peaks over from the current live bytes, for example after loading.
+	static void ResetPeaks();
+
+	// Lower case name used in the JSON report, such as "textures".
+	static const char* GetTagName(MemoryTag tag);
+
+	///<summary>
+	/// Returns the counters as a JSON object:
+	/// { "tags": { "<name>": { "live_bytes", "peak_bytes", "live_count", "total_count",
+	///   "budget_bytes", "over_budget" }, ... }, "total": { "live_bytes", "peak_bytes" } }
+	///</summary>
+	static std::string ToJson();
+
+	// Writes ToJson() to filename.  Returns false if the file could not be written.
+	static bool WriteJson(const std::wstring& filename);
+};
+
+///<summary>
+/// Standard allocator that reports what it allocates under Tag, for containers whose
+/// memory should show up in the tracker.
+///</summary>
+template<typename T, MemoryTag Tag>
+class TrackingAllocator
+{
+public:
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind
+	{
+		typedef TrackingAllocator<U, Tag> other;
+	};
+
+	TrackingAllocator() noexcept
+	{
+	}
+
+	template<typename U>
+	TrackingAllocator(const TrackingAllocator<U, Tag>&) noexcept
+	{
+	}
+
+	T* allocate(std::size_t count)
+	{
+		T* p = std::allocator<T>().allocate(count);
+		MemoryTracker::Allocate(Tag, sizeof(T) * count);
+		return p;
+	}
+
+	void deallocate(T* p, std::size_t count) noexcept
+	{
+		MemoryTracker::Free(Tag, sizeof(T) * count);
+		std::allocator<T>().deallocate(p, count);
+	}
+};
+
+template<typename T, typename U, MemoryTag Tag>
+bool operator==(const TrackingAllocator<T, Tag>&, const TrackingAllocator<U, Tag>&) noexcept
+{
+	return true;
+}
+
+template<typename T, typename U, MemoryTag Tag>
+bool operator!=(const TrackingAllocator<T, Tag>&, const TrackingAllocator<U, Tag>&) noexcept
+{
+	return false;
+}
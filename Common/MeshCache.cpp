@@ -0,0 +1,428 @@
+//***************************************************************************************
+// MeshCache.cpp
+//***************************************************************************************
+
+#include "MeshCache.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace DirectX;
+
+namespace
+{
+	// Interface id only MappedBlob answers to, so a blob can be recognized without RTTI.
+	// {3D9A5E71-C2B4-4A8F-8E16-5B0F27D4C9A3}
+	const GUID MappedBlobGuid =
+		{ 0x3d9a5e71, 0xc2b4, 0x4a8f, { 0x8e, 0x16, 0x5b, 0x0f, 0x27, 0xd4, 0xc9, 0xa3 } };
+
+	// ID3DBlob that points into a memory-mapped file instead of owning its bytes.
+	class MappedBlob : public Microsoft::WRL::RuntimeClass<
+		Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>, ID3DBlob>
+	{
+	public:
+		MappedBlob(const std::shared_ptr<MappedFile>& file, const std::uint8_t* data, SIZE_T byteSize) :
+			mFile(file), mData(data), mByteSize(byteSize)
+		{
+			MemoryTracker::Allocate(MemoryTag::GeometryCpu, mByteSize);
+		}
+
+		~MappedBlob()
+		{
+			MemoryTracker::Free(MemoryTag::GeometryCpu, mByteSize);
+		}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object)override
+		{
+			if(riid == MappedBlobGuid && object != nullptr)
+			{
+				*object = static_cast<ID3DBlob*>(this);
+				AddRef();
+				return S_OK;
+			}
+
+			return RuntimeClass::QueryInterface(riid, object);
+		}
+
+		LPVOID STDMETHODCALLTYPE GetBufferPointer()override
+		{
+			return const_cast<std::uint8_t*>(mData);
+		}
+
+		SIZE_T STDMETHODCALLTYPE GetBufferSize()override
+		{
+			return mByteSize;
+		}
+
+	private:
+		std::shared_ptr<MappedFile> mFile;
+		const std::uint8_t* mData = nullptr;
+		SIZE_T mByteSize = 0;
+	};
+
+	bool IsMappedBlob(ID3DBlob* blob)
+	{
+		ComPtr<ID3DBlob> mapped;
+		return SUCCEEDED(blob->QueryInterface(MappedBlobGuid, reinterpret_cast<void**>(mapped.GetAddressOf())));
+	}
+
+	std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	UINT IndexByteSize(std::uint32_t format)
+	{
+		if(format == DXGI_FORMAT_R16_UINT)
+			return 2;
+		if(format == DXGI_FORMAT_R32_UINT)
+			return 4;
+		return 0;
+	}
+
+	// True if byteSize bytes at offset fit in fileSize.  The offsets come from the file,
+	// so the test is written so that it cannot wrap around.
+	bool InFile(std::uint64_t offset, std::uint64_t byteSize, std::uint64_t fileSize)
+	{
+		return offset <= fileSize && byteSize <= fileSize - offset;
+	}
+
+	// Checks that the streams and submeshes of header lie inside a file of fileSize bytes.
+	bool GetStreamSizes(const MeshFileHeader& header, std::uint64_t fileSize,
+		std::uint64_t& vbByteSize, std::uint64_t& ibByteSize)
+	{
+		const UINT indexByteSize = IndexByteSize(header.IndexFormat);
+		if(indexByteSize == 0)
+			return false;
+
+		vbByteSize = (std::uint64_t)header.VertexCount * header.VertexByteStride;
+		ibByteSize = (std::uint64_t)header.IndexCount * indexByteSize;
+		const std::uint64_t submeshByteSize = (std::uint64_t)header.SubmeshCount * sizeof(MeshFileSubmesh);
+
+		return InFile(header.SubmeshOffset, submeshByteSize, fileSize) &&
+			InFile(header.VertexOffset, vbByteSize, fileSize) &&
+			InFile(header.IndexOffset, ibByteSize, fileSize) &&
+			vbByteSize <= UINT_MAX && ibByteSize <= UINT_MAX;
+	}
+
+	// Checks that every submesh reads indices inside the index stream and that those,
+	// offset by its base vertex, refer to vertices inside the vertex stream.
+	bool ValidateSubmeshes(const MeshFileHeader& header, const std::uint8_t* data)
+	{
+		const UINT indexByteSize = IndexByteSize(header.IndexFormat);
+		auto submeshes = reinterpret_cast<const MeshFileSubmesh*>(data + header.SubmeshOffset);
+
+		for(UINT i = 0; i < header.SubmeshCount; ++i)
+		{
+			const MeshFileSubmesh& s = submeshes[i];
+			if((std::uint64_t)s.StartIndexLocation + s.IndexCount > header.IndexCount)
+				return false;
+
+			const std::uint8_t* indices = data + header.IndexOffset + (std::uint64_t)s.StartIndexLocation*indexByteSize;
+			for(UINT j = 0; j < s.IndexCount; ++j)
+			{
+				const std::uint32_t index = indexByteSize == 2 ?
+					reinterpret_cast<const std::uint16_t*>(indices)[j] :
+					reinterpret_cast<const std::uint32_t*>(indices)[j];
+
+				const std::int64_t vertex = (std::int64_t)index + s.BaseVertexLocation;
+				if(vertex < 0 || vertex >= (std::int64_t)header.VertexCount)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Everything Load() checks before it trusts the contents of a mapped cache file.
+	bool ValidateFile(const MappedFile* file, UINT vertexByteStride,
+		std::uint64_t& vbByteSize, std::uint64_t& ibByteSize)
+	{
+		if(file == nullptr || file->Size() < sizeof(MeshFileHeader))
+			return false;
+
+		const MeshFileHeader& header = *reinterpret_cast<const MeshFileHeader*>(file->Data());
+		if(header.Magic != MeshCache::FileMagic || header.Version != MeshCache::FileVersion ||
+		   header.VertexByteStride != vertexByteStride)
+			return false;
+
+		return GetStreamSizes(header, file->Size(), vbByteSize, ibByteSize) &&
+			ValidateSubmeshes(header, file->Data());
+	}
+
+	void WritePadding(std::ofstream& fout, std::uint64_t alignment)
+	{
+		static const char zeros[16] = {};
+		std::uint64_t pos = static_cast<std::uint64_t>(fout.tellp());
+		fout.write(zeros, AlignUp(pos, alignment) - pos);
+	}
+}
+
+bool MeshCache::Load(const std::wstring& cacheFile, const std::wstring& sourceFile,
+	UINT vertexByteStride, MeshGeometry& geo)
+{
+	// Reject truncated or otherwise corrupt files before handing out any pointers.
+	auto file = MappedFile::Open(cacheFile);
+	std::uint64_t vbByteSize = 0;
+	std::uint64_t ibByteSize = 0;
+	if(!ValidateFile(file.get(), vertexByteStride, vbByteSize, ibByteSize))
+		return false;
+
+	std::uint64_t sourceTimestamp = 0;
+	if(!IsCurrent(*reinterpret_cast<const MeshFileHeader*>(file->Data()), sourceFile, sourceTimestamp))
+		return false;
+
+	if(sourceTimestamp != reinterpret_cast<const MeshFileHeader*>(file->Data())->SourceTimestamp)
+	{
+		// Same content under a new time stamp.  Record it, or every later launch hashes
+		// the source again; the mapping only shares reads, so close it first.
+		file = nullptr;
+		WriteSourceTimestamp(cacheFile, sourceTimestamp);
+
+		file = MappedFile::Open(cacheFile);
+		if(!ValidateFile(file.get(), vertexByteStride, vbByteSize, ibByteSize))
+			return false;
+	}
+
+	const MeshFileHeader& header = *reinterpret_cast<const MeshFileHeader*>(file->Data());
+
+	geo.VertexBufferCPU = CreateBlobView(file, header.VertexOffset, vbByteSize);
+	geo.IndexBufferCPU = CreateBlobView(file, header.IndexOffset, ibByteSize);
+
+	geo.VertexByteStride = header.VertexByteStride;
+	geo.VertexBufferByteSize = (UINT)vbByteSize;
+	geo.IndexFormat = (DXGI_FORMAT)header.IndexFormat;
+	geo.IndexBufferByteSize = (UINT)ibByteSize;
+	geo.CacheFile = cacheFile;
+
+	auto submeshes = reinterpret_cast<const MeshFileSubmesh*>(file->Data() + header.SubmeshOffset);
+
+	geo.DrawArgs.clear();
+	for(UINT i = 0; i < header.SubmeshCount; ++i)
+	{
+		const MeshFileSubmesh& s = submeshes[i];
+
+		SubmeshGeometry submesh;
+		submesh.IndexCount = s.IndexCount;
+		submesh.StartIndexLocation = s.StartIndexLocation;
+		submesh.BaseVertexLocation = s.BaseVertexLocation;
+		submesh.Bounds = BoundingBox(s.BoundsCenter, s.BoundsExtents);
+		submesh.SphereBounds = BoundingSphere(s.SphereCenter, s.SphereRadius);
+
+		geo.DrawArgs[std::string(s.Name, strnlen(s.Name, sizeof(s.Name)))] = submesh;
+	}
+
+	return true;
+}
+
+bool MeshCache::Save(const std::wstring& cacheFile, const std::wstring& sourceFile,
+	const MeshGeometry& geo)
+{
+	assert(geo.VertexBufferCPU != nullptr && geo.IndexBufferCPU != nullptr);
+
+	const UINT indexByteSize = IndexByteSize(geo.IndexFormat);
+	if(indexByteSize == 0 || geo.VertexByteStride == 0)
+		return false;
+
+	SourceStamp stamp;
+	std::uint64_t sourceHash = 0;
+	if(!GetSourceStamp(sourceFile, stamp) || !HashFile(sourceFile, sourceHash))
+		return false;
+
+	MeshFileHeader header = {};
+	header.Magic = FileMagic;
+	header.Version = FileVersion;
+	header.SourceTimestamp = stamp.Timestamp;
+	header.SourceSize = stamp.Size;
+	header.SourceHash = sourceHash;
+	header.VertexByteStride = geo.VertexByteStride;
+	header.VertexCount = geo.VertexBufferByteSize / geo.VertexByteStride;
+	header.IndexFormat = geo.IndexFormat;
+	header.IndexCount = geo.IndexBufferByteSize / indexByteSize;
+	header.SubmeshCount = (std::uint32_t)geo.DrawArgs.size();
+
+	header.SubmeshOffset = AlignUp(sizeof(MeshFileHeader), 16);
+	header.VertexOffset = AlignUp(header.SubmeshOffset + header.SubmeshCount*sizeof(MeshFileSubmesh), 16);
+	header.IndexOffset = AlignUp(header.VertexOffset + geo.VertexBufferByteSize, 16);
+
+	BoundingBox bounds;
+	BoundingBox::CreateFromPoints(bounds, header.VertexCount,
+		reinterpret_cast<const XMFLOAT3*>(geo.VertexBufferCPU->GetBufferPointer()), geo.VertexByteStride);
+	header.BoundsCenter = bounds.Center;
+	header.BoundsExtents = bounds.Extents;
+
+	std::ofstream fout(cacheFile, std::ios::binary | std::ios::trunc);
+	if(!fout)
+		return false;
+
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	WritePadding(fout, 16);
+
+	for(const auto& e : geo.DrawArgs)
+	{
+		MeshFileSubmesh s = {};
+		assert(e.first.size() < sizeof(s.Name));
+		e.first.copy(s.Name, sizeof(s.Name) - 1);
+		s.IndexCount = e.second.IndexCount;
+		s.StartIndexLocation = e.second.StartIndexLocation;
+		s.BaseVertexLocation = e.second.BaseVertexLocation;
+		s.BoundsCenter = e.second.Bounds.Center;
+		s.BoundsExtents = e.second.Bounds.Extents;
+		s.SphereCenter = e.second.SphereBounds.Center;
+		s.SphereRadius = e.second.SphereBounds.Radius;
+
+		fout.write(reinterpret_cast<const char*>(&s), sizeof(s));
+	}
+	WritePadding(fout, 16);
+
+	fout.write(reinterpret_cast<const char*>(geo.VertexBufferCPU->GetBufferPointer()), geo.VertexBufferByteSize);
+	WritePadding(fout, 16);
+
+	fout.write(reinterpret_cast<const char*>(geo.IndexBufferCPU->GetBufferPointer()), geo.IndexBufferByteSize);
+
+	return fout.good();
+}
+
+bool MeshCache::AcquireCpuGeometry(MeshGeometry& geo)
+{
+	if(geo.VertexBufferCPU != nullptr && geo.IndexBufferCPU != nullptr)
+		return true;
+
+	if(geo.CpuPolicy != CpuGeometryPolicy::Remap || geo.CacheFile.empty())
+		return false;
+
+	auto file = MappedFile::Open(geo.CacheFile);
+	if(file == nullptr || file->Size() < sizeof(MeshFileHeader))
+		return false;
+
+	const MeshFileHeader& header = *reinterpret_cast<const MeshFileHeader*>(file->Data());
+	if(header.Magic != FileMagic || header.Version != FileVersion)
+		return false;
+
+	std::uint64_t vbByteSize = 0;
+	std::uint64_t ibByteSize = 0;
+	if(!GetStreamSizes(header, file->Size(), vbByteSize, ibByteSize))
+		return false;
+
+	// The file must still hold the mesh that was uploaded; it may have been cooked
+	// again since.
+	if(header.VertexByteStride != geo.VertexByteStride ||
+	   (DXGI_FORMAT)header.IndexFormat != geo.IndexFormat ||
+	   vbByteSize != geo.VertexBufferByteSize ||
+	   ibByteSize != geo.IndexBufferByteSize)
+		return false;
+
+	geo.VertexBufferCPU = CreateBlobView(file, header.VertexOffset, vbByteSize);
+	geo.IndexBufferCPU = CreateBlobView(file, header.IndexOffset, ibByteSize);
+
+	return true;
+}
+
+MeshCache::CpuGeometryStats MeshCache::GetCpuGeometryStats(
+	const std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries)
+{
+	CpuGeometryStats stats;
+	for(const auto& entry : geometries)
+	{
+		const MeshGeometry& geo = *entry.second;
+
+		stats.MeshCount++;
+		if(geo.GetCpuResidentBytes() != 0)
+			stats.ResidentMeshCount++;
+
+		ID3DBlob* blobs[] = { geo.VertexBufferCPU.Get(), geo.IndexBufferCPU.Get() };
+		for(ID3DBlob* blob : blobs)
+		{
+			if(blob == nullptr)
+				continue;
+
+			if(IsMappedBlob(blob))
+				stats.MappedBytes += blob->GetBufferSize();
+			else
+				stats.OwnedBytes += blob->GetBufferSize();
+		}
+	}
+
+	return stats;
+}
+
+ComPtr<ID3DBlob> MeshCache::CreateBlobView(
+	const std::shared_ptr<MappedFile>& file, std::uint64_t offset, std::uint64_t byteSize)
+{
+	assert(InFile(offset, byteSize, file->Size()));
+
+	return Microsoft::WRL::Make<MappedBlob>(file, file->Data() + offset, (SIZE_T)byteSize);
+}
+
+std::uint64_t MeshCache::HashBytes(const void* data, std::uint64_t byteSize)
+{
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+
+	std::uint64_t hash = 14695981039346656037ull;
+	for(std::uint64_t i = 0; i < byteSize; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+bool MeshCache::GetSourceStamp(const std::wstring& sourceFile, SourceStamp& stamp)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if(!GetFileAttributesExW(sourceFile.c_str(), GetFileExInfoStandard, &attributes))
+		return false;
+
+	stamp.Timestamp = ((std::uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) |
+		attributes.ftLastWriteTime.dwLowDateTime;
+	stamp.Size = ((std::uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+
+	return true;
+}
+
+bool MeshCache::HashFile(const std::wstring& filename, std::uint64_t& hash)
+{
+	auto file = MappedFile::Open(filename);
+	if(file == nullptr)
+		return false;
+
+	hash = HashBytes(file->Data(), file->Size());
+
+	return true;
+}
+
+bool MeshCache::WriteSourceTimestamp(const std::wstring& cacheFile, std::uint64_t sourceTimestamp)
+{
+	std::fstream file(cacheFile, std::ios::in | std::ios::out | std::ios::binary);
+	if(!file)
+		return false;
+
+	file.seekp(offsetof(MeshFileHeader, SourceTimestamp));
+	file.write(reinterpret_cast<const char*>(&sourceTimestamp), sizeof(sourceTimestamp));
+	return file.good();
+}
+
+bool MeshCache::IsCurrent(const MeshFileHeader& header, const std::wstring& sourceFile,
+	std::uint64_t& sourceTimestamp)
+{
+	sourceTimestamp = header.SourceTimestamp;
+
+	// A cooked file shipped without its source is trusted as is.
+	SourceStamp stamp;
+	if(!GetSourceStamp(sourceFile, stamp))
+		return true;
+
+	if(stamp.Size != header.SourceSize)
+		return false;
+
+	if(stamp.Timestamp == header.SourceTimestamp)
+		return true;
+
+	// The time stamp moved (a fresh checkout or copy touches every file), so let the
+	// content decide.
+	std::uint64_t hash = 0;
+	if(!HashFile(sourceFile, hash) || hash != header.SourceHash)
+		return false;
+
+	sourceTimestamp = stamp.Timestamp;
+	return true;
+}
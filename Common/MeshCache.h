@@ -0,0 +1,153 @@
+//***************************************************************************************
+// MeshCache.h
+//
+// Versioned binary ("cooked") mesh format.  The text model loaders write a .mesh file
+// next to the source model the first time it is parsed.  Later launches memory-map the
+// cooked file and point MeshGeometry::VertexBufferCPU/IndexBufferCPU straight into the
+// mapping, so nothing is parsed or copied on the CPU.
+//
+// File layout (every section starts on a 16-byte boundary):
+//
+//   MeshFileHeader
+//   MeshFileSubmesh[SubmeshCount]
+//   vertex stream   VertexCount*VertexByteStride bytes
+//   index stream    IndexCount*(2 or 4) bytes
+//
+// The cache is stale when the version or vertex stride differs, or when the source
+// model changed.  The source check compares the last write time and size first and
+// only hashes the source file when the time stamp moved; if the content still matches,
+// the new time stamp is written back so the next launch does not hash again.  Files
+// whose submeshes reach outside the index or vertex streams are rejected as corrupt.
+//
+// Once a mesh is on the GPU its CPU copy is only needed for picking or collision, so
+// MeshGeometry::CpuPolicy can drop it; under CpuGeometryPolicy::Remap,
+// AcquireCpuGeometry() maps the cooked file again when the copy is wanted.
+//
+// Note: the vertex stream is treated as opaque except for the bounds, which assume
+// that every vertex starts with its float3 position (true for every Vertex in the demos).
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "MappedFile.h"
+
+#pragma pack(push, 4)
+
+struct MeshFileHeader
+{
+	std::uint32_t Magic;
+	std::uint32_t Version;
+
+	// Identity of the source model the file was cooked from.
+	std::uint64_t SourceTimestamp;
+	std::uint64_t SourceSize;
+	std::uint64_t SourceHash;
+
+	std::uint32_t VertexByteStride;
+	std::uint32_t VertexCount;
+	std::uint32_t IndexFormat;
+	std::uint32_t IndexCount;
+	std::uint32_t SubmeshCount;
+	std::uint32_t Reserved;
+
+	std::uint64_t SubmeshOffset;
+	std::uint64_t VertexOffset;
+	std::uint64_t IndexOffset;
+
+	// Bounds of the whole mesh.
+	DirectX::XMFLOAT3 BoundsCenter;
+	DirectX::XMFLOAT3 BoundsExtents;
+};
+
+struct MeshFileSubmesh
+{
+	char Name[48];
+
+	std::uint32_t IndexCount;
+	std::uint32_t StartIndexLocation;
+	std::int32_t BaseVertexLocation;
+
+	DirectX::XMFLOAT3 BoundsCenter;
+	DirectX::XMFLOAT3 BoundsExtents;
+
+	DirectX::XMFLOAT3 SphereCenter;
+	float SphereRadius;
+};
+
+#pragma pack(pop)
+
+class MeshCache
+{
+public:
+	static const std::uint32_t FileMagic = 0x4853454D; // "MESH"
+	static const std::uint32_t FileVersion = 2;
+
+	struct CpuGeometryStats
+	{
+		UINT MeshCount = 0;
+
+		// Meshes that hold a CPU copy.
+		UINT ResidentMeshCount = 0;
+
+		// Copies in memory of their own: meshes that were generated or parsed.
+		UINT64 OwnedBytes = 0;
+
+		// Copies that are views of a cooked file; the OS can page them out and back in.
+		UINT64 MappedBytes = 0;
+	};
+
+	///<summary>
+	/// Maps cacheFile and fills in the CPU side of geo (VertexBufferCPU, IndexBufferCPU,
+	/// stride, sizes, index format and DrawArgs).  The blobs reference the mapping
+	/// directly and are read-only.  Returns false if the cache is missing, corrupt,
+	/// cooked for another vertex layout or older than sourceFile.
+	///</summary>
+	static bool Load(const std::wstring& cacheFile, const std::wstring& sourceFile,
+		UINT vertexByteStride, MeshGeometry& geo);
+
+	///<summary>
+	/// Cooks the CPU side of geo into cacheFile and stamps it with the identity of
+	/// sourceFile.  Returns false if the file could not be written; the cache is an
+	/// optimization only, so callers normally ignore failures.
+	///</summary>
+	static bool Save(const std::wstring& cacheFile, const std::wstring& sourceFile,
+		const MeshGeometry& geo);
+
+	///<summary>
+	/// Makes sure geo has its CPU copy again.  Returns true if it already has one; if it
+	/// was released under CpuGeometryPolicy::Remap, maps geo.CacheFile and points the
+	/// blobs into it.  Returns false if the policy does not allow that or the file no
+	/// longer holds the uploaded mesh.
+	///</summary>
+	static bool AcquireCpuGeometry(MeshGeometry& geo);
+
+	// Sums the CPU copies the geometries hold.
+	static CpuGeometryStats GetCpuGeometryStats(
+		const std::unordered_map<std::string, std::unique_ptr<MeshGeometry>>& geometries);
+
+	///<summary>
+	/// Wraps a range of a mapped file in an ID3DBlob without copying.  The blob holds
+	/// a reference to the mapping so it stays valid after the caller drops theirs.
+	///</summary>
+	static Microsoft::WRL::ComPtr<ID3DBlob> CreateBlobView(
+		const std::shared_ptr<MappedFile>& file, std::uint64_t offset, std::uint64_t byteSize);
+
+	// 64-bit FNV-1a hash of a byte range.
+	static std::uint64_t HashBytes(const void* data, std::uint64_t byteSize);
+
+private:
+	struct SourceStamp
+	{
+		std::uint64_t Timestamp = 0;
+		std::uint64_t Size = 0;
+	};
+
+	static bool GetSourceStamp(const std::wstring& sourceFile, SourceStamp& stamp);
+	static bool HashFile(const std::wstring& filename, std::uint64_t& hash);
+	// sourceTimestamp receives the source's current time stamp when the content matches
+	// under a different one; the caller should record it in the file.
+	static bool IsCurrent(const MeshFileHeader& header, const std::wstring& sourceFile,
+		std::uint64_t& sourceTimestamp);
+	static bool WriteSourceTimestamp(const std::wstring& cacheFile, std::uint64_t sourceTimestamp);
+};
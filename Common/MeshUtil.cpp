@@ -0,0 +1,614 @@
+//***************************************************************************************
+// MeshUtil.cpp
+//***************************************************************************************
+
+#include "MeshUtil.h"
+#include "TaskPool.h"
+#include <atomic>
+
+using namespace DirectX;
+
+namespace
+{
+	using Vertex = GeometryGenerator::Vertex;
+	using uint32 = GeometryGenerator::uint32;
+
+	// Number of elements handed to a worker at a time.
+	const std::size_t GrainSize = 4096;
+
+	// (spatial hash key, vertex index) pairs.  Sorting them orders vertices by cell and
+	// then by index, which is a total order, so the sorted array is the same no matter
+	// how the sort was split across threads.
+	using CellEntry = std::pair<std::uint64_t, uint32>;
+
+	XMINT3 CellOf(const XMFLOAT3& p, float invCellSize)
+	{
+		return XMINT3(
+			(std::int32_t)floorf(p.x*invCellSize),
+			(std::int32_t)floorf(p.y*invCellSize),
+			(std::int32_t)floorf(p.z*invCellSize));
+	}
+
+	// Packs 21 bits per axis.  Far apart cells may share a key; candidates are always
+	// compared by distance, so that only costs a few extra comparisons.
+	std::uint64_t CellKey(std::int32_t x, std::int32_t y, std::int32_t z)
+	{
+		const std::uint64_t mask = (1ull << 21) - 1;
+		return (((std::uint64_t)x & mask) << 42) | (((std::uint64_t)y & mask) << 21) | ((std::uint64_t)z & mask);
+	}
+
+	// True if the indices form whole triangles and none is out of range of the vertices.
+	bool HasValidIndices(TaskPool& pool, const GeometryGenerator::MeshData& meshData)
+	{
+		const std::vector<uint32>& indices = meshData.Indices32;
+		const std::size_t vertexCount = meshData.Vertices.size();
+		if(indices.size() % 3 != 0)
+			return false;
+
+		std::atomic<bool> valid(true);
+		pool.ParallelFor(indices.size(), GrainSize, [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t k = begin; k < end; ++k)
+			{
+				if(indices[k] >= vertexCount)
+				{
+					valid.store(false, std::memory_order_relaxed);
+					return;
+				}
+			}
+		});
+
+		return valid.load(std::memory_order_relaxed);
+	}
+
+	bool AreWeldable(const Vertex& a, const Vertex& b, FXMVECTOR epsilon)
+	{
+		XMVECTOR d = XMVectorSubtract(XMLoadFloat3(&a.Position), XMLoadFloat3(&b.Position));
+		if(XMVector3Greater(XMVector3LengthSq(d), XMVectorMultiply(epsilon, epsilon)))
+			return false;
+
+		return XMVector3NearEqual(XMLoadFloat3(&a.Normal), XMLoadFloat3(&b.Normal), epsilon) &&
+			XMVector3NearEqual(XMLoadFloat3(&a.TangentU), XMLoadFloat3(&b.TangentU), epsilon) &&
+			XMVector2NearEqual(XMLoadFloat2(&a.TexC), XMLoadFloat2(&b.TexC), epsilon);
+	}
+
+	// Open-addressing table from a cell key to the range of that cell in the sorted
+	// entries, so a neighbour lookup is O(1) instead of a binary search.
+	class CellTable
+	{
+	public:
+		explicit CellTable(const std::vector<CellEntry>& sorted)
+		{
+			std::size_t cellCount = 0;
+			for(std::size_t i = 0; i < sorted.size(); ++i)
+			{
+				if(i == 0 || sorted[i].first != sorted[i - 1].first)
+					++cellCount;
+			}
+
+			std::size_t capacity = 16;
+			while(capacity < 2*cellCount)
+				capacity *= 2;
+
+			mMask = capacity - 1;
+			mSlots.assign(capacity, Slot());
+
+			for(std::size_t begin = 0; begin < sorted.size();)
+			{
+				std::size_t end = begin + 1;
+				while(end < sorted.size() && sorted[end].first == sorted[begin].first)
+					++end;
+
+				std::size_t slot = Hash(sorted[begin].first) & mMask;
+				while(mSlots[slot].End != 0)
+					slot = (slot + 1) & mMask;
+
+				mSlots[slot].Key = sorted[begin].first;
+				mSlots[slot].Begin = (uint32)begin;
+				mSlots[slot].End = (uint32)end;
+
+				begin = end;
+			}
+		}
+
+		bool Find(std::uint64_t key, uint32& begin, uint32& end)const
+		{
+			// Occupied slots always have End > 0.
+			for(std::size_t slot = Hash(key) & mMask; mSlots[slot].End != 0; slot = (slot + 1) & mMask)
+			{
+				if(mSlots[slot].Key == key)
+				{
+					begin = mSlots[slot].Begin;
+					end = mSlots[slot].End;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		struct Slot
+		{
+			std::uint64_t Key = 0;
+			uint32 Begin = 0;
+			uint32 End = 0;
+		};
+
+		static std::size_t Hash(std::uint64_t key)
+		{
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdull;
+			key ^= key >> 33;
+			return (std::size_t)key;
+		}
+
+		std::vector<Slot> mSlots;
+		std::size_t mMask = 0;
+	};
+
+	// Positions of four vertices in structure-of-arrays layout.
+	struct PositionBlock
+	{
+		XMVECTOR X;
+		XMVECTOR Y;
+		XMVECTOR Z;
+	};
+
+	// Transposes the positions into blocks of four.  The last block is padded with
+	// copies of the last position so it does not change any min, max or distance.
+	std::vector<PositionBlock> ToPositionBlocks(const void* vertices, UINT vertexCount, UINT vertexByteStride)
+	{
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(vertices);
+		auto position = [&](UINT i) -> const float*
+		{
+			return reinterpret_cast<const float*>(bytes + (size_t)std::min<UINT>(i, vertexCount - 1)*vertexByteStride);
+		};
+
+		std::vector<PositionBlock> blocks((vertexCount + 3) / 4);
+		for(UINT b = 0; b < (UINT)blocks.size(); ++b)
+		{
+			const float* p0 = position(4*b + 0);
+			const float* p1 = position(4*b + 1);
+			const float* p2 = position(4*b + 2);
+			const float* p3 = position(4*b + 3);
+
+			blocks[b].X = XMVectorSet(p0[0], p1[0], p2[0], p3[0]);
+			blocks[b].Y = XMVectorSet(p0[1], p1[1], p2[1], p3[1]);
+			blocks[b].Z = XMVectorSet(p0[2], p1[2], p2[2], p3[2]);
+		}
+
+		return blocks;
+	}
+
+	// Reduces the four lanes of v to their minimum/maximum, replicated in all lanes.
+	XMVECTOR HorizontalMin(FXMVECTOR v)
+	{
+		XMVECTOR m = XMVectorMin(v, XMVectorSwizzle<2, 3, 0, 1>(v));
+		return XMVectorMin(m, XMVectorSwizzle<1, 0, 3, 2>(m));
+	}
+
+	XMVECTOR HorizontalMax(FXMVECTOR v)
+	{
+		XMVECTOR m = XMVectorMax(v, XMVectorSwizzle<2, 3, 0, 1>(v));
+		return XMVectorMax(m, XMVectorSwizzle<1, 0, 3, 2>(m));
+	}
+
+	// Sorts runs in parallel, then merges neighbouring runs pairwise.
+	void ParallelSort(TaskPool& pool, std::vector<CellEntry>& entries)
+	{
+		const std::size_t count = entries.size();
+		const std::size_t threadCount = pool.GetThreadCount();
+		const std::size_t runSize = std::max<std::size_t>(16384, (count + threadCount - 1) / threadCount);
+		const std::size_t runCount = (count + runSize - 1) / runSize;
+
+		pool.ParallelFor(runCount, 1, [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t r = begin; r < end; ++r)
+			{
+				std::size_t last = std::min<std::size_t>((r + 1)*runSize, count);
+				std::sort(entries.begin() + r*runSize, entries.begin() + last);
+			}
+		});
+
+		for(std::size_t width = runSize; width < count; width *= 2)
+		{
+			const std::size_t pairCount = (count + 2*width - 1) / (2*width);
+			pool.ParallelFor(pairCount, 1, [&](std::size_t begin, std::size_t end)
+			{
+				for(std::size_t p = begin; p < end; ++p)
+				{
+					std::size_t first = p*2*width;
+					std::size_t mid = std::min<std::size_t>(first + width, count);
+					std::size_t last = std::min<std::size_t>(first + 2*width, count);
+					if(mid < last)
+						std::inplace_merge(entries.begin() + first, entries.begin() + mid, entries.begin() + last);
+				}
+			});
+		}
+	}
+}
+
+bool MeshUtil::LoadTextModel(const std::wstring& filename, GeometryGenerator::MeshData& meshData)
+{
+	std::ifstream fin(filename);
+	if(!fin)
+		return false;
+
+	UINT vCount = 0;
+	UINT tCount = 0;
+	std::string ignore;
+
+	fin >> ignore >> vCount;
+	fin >> ignore >> tCount;
+	fin >> ignore >> ignore >> ignore >> ignore;
+
+	GeometryGenerator::MeshData loaded;
+	loaded.Vertices.resize(vCount);
+	for(UINT i = 0; i < vCount; ++i)
+	{
+		Vertex& v = loaded.Vertices[i];
+		fin >> v.Position.x >> v.Position.y >> v.Position.z;
+		fin >> v.Normal.x >> v.Normal.y >> v.Normal.z;
+		v.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		v.TexC = XMFLOAT2(0.0f, 0.0f);
+	}
+	fin >> ignore >> ignore >> ignore;
+
+	loaded.Indices32.resize(3 * tCount);
+	for(UINT i = 0; i < tCount; ++i)
+	{
+		fin >> loaded.Indices32[i * 3 + 0] >> loaded.Indices32[i * 3 + 1] >> loaded.Indices32[i * 3 + 2];
+	}
+
+	if(fin.fail() || !HasValidIndices(TaskPool::Default(), loaded))
+		return false;
+
+	meshData = std::move(loaded);
+
+	return true;
+}
+
+bool MeshUtil::WeldVertices(GeometryGenerator::MeshData& meshData, float epsilon, WeldStats& stats)
+{
+	assert(epsilon > 0.0f);
+
+	const std::vector<Vertex>& vertices = meshData.Vertices;
+	const std::size_t vertexCount = vertices.size();
+
+	stats = WeldStats();
+	stats.VertexCountBefore = vertexCount;
+	stats.IndexCountBefore = meshData.Indices32.size();
+	stats.VertexCountAfter = stats.VertexCountBefore;
+	stats.IndexCountAfter = stats.IndexCountBefore;
+
+	TaskPool& pool = TaskPool::Default();
+	if(!HasValidIndices(pool, meshData))
+		return false;
+
+	if(vertexCount == 0)
+		return true;
+
+	// Cells are twice epsilon wide, so a match is either in the vertex's own cell or
+	// in the neighbour on the nearer side along each axis: 8 cells to visit, not 27.
+	const float invCellSize = 0.5f / epsilon;
+
+	//
+	// Bucket every vertex into the spatial hash and sort the buckets.
+	//
+
+	std::vector<CellEntry> cells(vertexCount);
+	pool.ParallelFor(vertexCount, GrainSize, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			XMINT3 c = CellOf(vertices[i].Position, invCellSize);
+			cells[i] = CellEntry(CellKey(c.x, c.y, c.z), (uint32)i);
+		}
+	});
+
+	ParallelSort(pool, cells);
+	const CellTable table(cells);
+
+	//
+	// For every vertex find the lowest-indexed vertex it can be welded to.
+	//
+
+	std::vector<uint32> target(vertexCount);
+	pool.ParallelFor(vertexCount, GrainSize, [&](std::size_t begin, std::size_t end)
+	{
+		const XMVECTOR eps = XMVectorReplicate(epsilon);
+
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			const XMFLOAT3& p = vertices[i].Position;
+			XMINT3 c = CellOf(p, invCellSize);
+
+			// Step towards the nearer cell boundary on each axis.
+			const int sx = (p.x*invCellSize - c.x < 0.5f) ? -1 : 1;
+			const int sy = (p.y*invCellSize - c.y < 0.5f) ? -1 : 1;
+			const int sz = (p.z*invCellSize - c.z < 0.5f) ? -1 : 1;
+
+			uint32 best = (uint32)i;
+			for(int n = 0; n < 8; ++n)
+			{
+				const std::uint64_t key = CellKey(
+					c.x + ((n & 1) ? sx : 0),
+					c.y + ((n & 2) ? sy : 0),
+					c.z + ((n & 4) ? sz : 0));
+
+				uint32 first, last;
+				if(!table.Find(key, first, last))
+					continue;
+
+				// Entries of a cell are sorted by index, so the first match is the lowest.
+				for(uint32 k = first; k < last && cells[k].second < best; ++k)
+				{
+					if(AreWeldable(vertices[i], vertices[cells[k].second], eps))
+					{
+						best = cells[k].second;
+						break;
+					}
+				}
+			}
+
+			target[i] = best;
+		}
+	});
+
+	//
+	// Assign compacted indices.  target[i] < i for merged vertices, so the slot of
+	// the target is known by the time i is visited and chains resolve on their own.
+	//
+
+	std::vector<uint32> newIndex(vertexCount);
+	uint32 weldedCount = 0;
+	for(std::size_t i = 0; i < vertexCount; ++i)
+	{
+		newIndex[i] = (target[i] == i) ? weldedCount++ : newIndex[target[i]];
+	}
+
+	GeometryGenerator::MeshData welded;
+	welded.Vertices.resize(weldedCount);
+	pool.ParallelFor(vertexCount, GrainSize, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			if(target[i] == i)
+				welded.Vertices[newIndex[i]] = vertices[i];
+		}
+	});
+
+	welded.Indices32.resize(meshData.Indices32.size());
+	const std::vector<uint32>& indices = meshData.Indices32;
+	pool.ParallelFor(indices.size(), GrainSize, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t k = begin; k < end; ++k)
+			welded.Indices32[k] = newIndex[indices[k]];
+	});
+
+	// Drop triangles that collapsed to a line or a point.
+	std::size_t indexCount = 0;
+	for(std::size_t t = 0; t + 2 < welded.Indices32.size(); t += 3)
+	{
+		uint32 i0 = welded.Indices32[t + 0];
+		uint32 i1 = welded.Indices32[t + 1];
+		uint32 i2 = welded.Indices32[t + 2];
+		if(i0 == i1 || i1 == i2 || i0 == i2)
+			continue;
+
+		welded.Indices32[indexCount++] = i0;
+		welded.Indices32[indexCount++] = i1;
+		welded.Indices32[indexCount++] = i2;
+	}
+	welded.Indices32.resize(indexCount);
+
+	stats.VertexCountAfter = welded.Vertices.size();
+	stats.IndexCountAfter = welded.Indices32.size();
+	stats.BytesSaved =
+		(stats.VertexCountBefore - stats.VertexCountAfter)*sizeof(Vertex) +
+		(stats.IndexCountBefore - stats.IndexCountAfter)*sizeof(uint32);
+
+	// Assigning a fresh MeshData also drops any cached 16-bit indices.
+	meshData = std::move(welded);
+
+	return true;
+}
+
+bool MeshUtil::ComputeTangents(GeometryGenerator::MeshData& meshData)
+{
+	std::vector<Vertex>& vertices = meshData.Vertices;
+	const std::vector<uint32>& indices = meshData.Indices32;
+
+	const std::size_t vertexCount = vertices.size();
+	const std::size_t triangleCount = indices.size() / 3;
+
+	TaskPool& pool = TaskPool::Default();
+	if(!HasValidIndices(pool, meshData))
+		return false;
+
+	if(vertexCount == 0)
+		return true;
+
+	//
+	// Tangent of every triangle, scaled by its size so large triangles weigh more.
+	//
+
+	std::vector<XMFLOAT3> triangleTangents(triangleCount);
+	pool.ParallelFor(triangleCount, GrainSize, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t t = begin; t < end; ++t)
+		{
+			const Vertex& v0 = vertices[indices[3*t + 0]];
+			const Vertex& v1 = vertices[indices[3*t + 1]];
+			const Vertex& v2 = vertices[indices[3*t + 2]];
+
+			XMVECTOR e1 = XMVectorSubtract(XMLoadFloat3(&v1.Position), XMLoadFloat3(&v0.Position));
+			XMVECTOR e2 = XMVectorSubtract(XMLoadFloat3(&v2.Position), XMLoadFloat3(&v0.Position));
+
+			float du1 = v1.TexC.x - v0.TexC.x;
+			float dv1 = v1.TexC.y - v0.TexC.y;
+			float du2 = v2.TexC.x - v0.TexC.x;
+			float dv2 = v2.TexC.y - v0.TexC.y;
+
+			// T = (dv2*e1 - dv1*e2) / det.  Only the sign of det is applied, which keeps
+			// the tangent pointing along +u and weights it by the triangle's size.
+			float det = du1*dv2 - du2*dv1;
+			XMVECTOR tangent = XMVectorZero();
+			if(det != 0.0f)
+			{
+				tangent = XMVectorSubtract(XMVectorScale(e1, dv2), XMVectorScale(e2, dv1));
+				if(det < 0.0f)
+					tangent = XMVectorNegate(tangent);
+			}
+
+			XMStoreFloat3(&triangleTangents[t], tangent);
+		}
+	});
+
+	//
+	// Vertex to triangle adjacency in compressed rows.  Filling it sequentially lists
+	// the triangles of every vertex in ascending order.
+	//
+
+	std::vector<uint32> firstTriangle(vertexCount + 1, 0);
+	for(std::size_t k = 0; k < 3*triangleCount; ++k)
+		++firstTriangle[indices[k] + 1];
+
+	for(std::size_t i = 0; i < vertexCount; ++i)
+		firstTriangle[i + 1] += firstTriangle[i];
+
+	std::vector<uint32> adjacentTriangles(3*triangleCount);
+	{
+		std::vector<uint32> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+		for(std::size_t k = 0; k < 3*triangleCount; ++k)
+			adjacentTriangles[cursor[indices[k]]++] = (uint32)(k / 3);
+	}
+
+	//
+	// Sum, orthogonalize against the normal (Gram-Schmidt) and normalize.
+	//
+
+	pool.ParallelFor(vertexCount, GrainSize, [&](std::size_t begin, std::size_t end)
+	{
+		const XMVECTOR minLengthSq = XMVectorReplicate(1e-12f);
+		const XMVECTOR unitX = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+		const XMVECTOR unitY = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			XMVECTOR sum = XMVectorZero();
+			for(uint32 k = firstTriangle[i]; k < firstTriangle[i + 1]; ++k)
+				sum = XMVectorAdd(sum, XMLoadFloat3(&triangleTangents[adjacentTriangles[k]]));
+
+			XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&vertices[i].Normal));
+			XMVECTOR t = XMVectorSubtract(sum, XMVectorMultiply(n, XMVector3Dot(n, sum)));
+
+			if(XMVector3Less(XMVector3LengthSq(t), minLengthSq))
+			{
+				// No texture mapping to follow; use any direction perpendicular to n.
+				XMVECTOR axis = fabsf(XMVectorGetY(n)) < 0.99f ? unitY : unitX;
+				t = XMVector3Cross(axis, n);
+			}
+
+			XMStoreFloat3(&vertices[i].TangentU, XMVector3Normalize(t));
+		}
+	});
+
+	return true;
+}
+
+void MeshUtil::ComputeBounds(const void* vertices, UINT vertexCount, UINT vertexByteStride,
+	BoundingBox& box, BoundingSphere& sphere, BoundingOrientedBox* orientedBox)
+{
+	if(vertexCount == 0)
+	{
+		box = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+		sphere = BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+		if(orientedBox != nullptr)
+			*orientedBox = BoundingOrientedBox();
+		return;
+	}
+
+	const std::vector<PositionBlock> blocks = ToPositionBlocks(vertices, vertexCount, vertexByteStride);
+
+	XMVECTOR minX = blocks[0].X, minY = blocks[0].Y, minZ = blocks[0].Z;
+	XMVECTOR maxX = blocks[0].X, maxY = blocks[0].Y, maxZ = blocks[0].Z;
+	for(size_t b = 1; b < blocks.size(); ++b)
+	{
+		minX = XMVectorMin(minX, blocks[b].X);
+		minY = XMVectorMin(minY, blocks[b].Y);
+		minZ = XMVectorMin(minZ, blocks[b].Z);
+		maxX = XMVectorMax(maxX, blocks[b].X);
+		maxY = XMVectorMax(maxY, blocks[b].Y);
+		maxZ = XMVectorMax(maxZ, blocks[b].Z);
+	}
+
+	XMVECTOR vMin = XMVectorSet(XMVectorGetX(HorizontalMin(minX)), XMVectorGetX(HorizontalMin(minY)), XMVectorGetX(HorizontalMin(minZ)), 0.0f);
+	XMVECTOR vMax = XMVectorSet(XMVectorGetX(HorizontalMax(maxX)), XMVectorGetX(HorizontalMax(maxY)), XMVectorGetX(HorizontalMax(maxZ)), 0.0f);
+
+	BoundingBox::CreateFromPoints(box, vMin, vMax);
+
+	//
+	// Center the sphere on the box and take the farthest vertex as the radius.
+	//
+
+	XMVECTOR cx = XMVectorReplicate(box.Center.x);
+	XMVECTOR cy = XMVectorReplicate(box.Center.y);
+	XMVECTOR cz = XMVectorReplicate(box.Center.z);
+
+	XMVECTOR maxDistSq = XMVectorZero();
+	for(const PositionBlock& block : blocks)
+	{
+		XMVECTOR dx = XMVectorSubtract(block.X, cx);
+		XMVECTOR dy = XMVectorSubtract(block.Y, cy);
+		XMVECTOR dz = XMVectorSubtract(block.Z, cz);
+
+		XMVECTOR distSq = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+		maxDistSq = XMVectorMax(maxDistSq, distSq);
+	}
+
+	sphere.Center = box.Center;
+	sphere.Radius = sqrtf(XMVectorGetX(HorizontalMax(maxDistSq)));
+
+	if(orientedBox != nullptr)
+	{
+		BoundingOrientedBox::CreateFromPoints(*orientedBox, vertexCount,
+			reinterpret_cast<const XMFLOAT3*>(vertices), vertexByteStride);
+	}
+}
+
+void MeshUtil::ComputeSubmeshBounds(MeshGeometry& geo, bool orientedBounds)
+{
+	assert(geo.VertexBufferCPU != nullptr && geo.IndexBufferCPU != nullptr);
+	assert(geo.IndexFormat == DXGI_FORMAT_R16_UINT || geo.IndexFormat == DXGI_FORMAT_R32_UINT);
+
+	const std::uint8_t* vertexData = static_cast<const std::uint8_t*>(geo.VertexBufferCPU->GetBufferPointer());
+	const void* indexData = geo.IndexBufferCPU->GetBufferPointer();
+	const bool indices16 = geo.IndexFormat == DXGI_FORMAT_R16_UINT;
+
+	for(auto& e : geo.DrawArgs)
+	{
+		SubmeshGeometry& submesh = e.second;
+		if(submesh.IndexCount == 0)
+			continue;
+
+		// A submesh only knows its index range, so bound the vertex range it references.
+		UINT first = UINT_MAX;
+		UINT last = 0;
+		for(UINT i = 0; i < submesh.IndexCount; ++i)
+		{
+			UINT index = indices16 ?
+				static_cast<const std::uint16_t*>(indexData)[submesh.StartIndexLocation + i] :
+				static_cast<const std::uint32_t*>(indexData)[submesh.StartIndexLocation + i];
+
+			first = std::min<UINT>(first, index);
+			last = std::max<UINT>(last, index);
+		}
+
+		const std::uint8_t* base = vertexData + (size_t)(submesh.BaseVertexLocation + (INT)first)*geo.VertexByteStride;
+		ComputeBounds(base, last - first + 1, geo.VertexByteStride,
+			submesh.Bounds, submesh.SphereBounds, orientedBounds ? &submesh.OrientedBounds : nullptr);
+		submesh.HasOrientedBounds = orientedBounds;
+	}
+}
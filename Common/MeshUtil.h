@@ -0,0 +1,73 @@
+//***************************************************************************************
+// MeshUtil.h
+//
+// CPU-side processing passes for GeometryGenerator::MeshData, mostly used on meshes
+// imported from the text model files.  The passes are written to scale to meshes with
+// millions of vertices and run on TaskPool::Default().
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryGenerator.h"
+
+class MeshUtil
+{
+public:
+	struct WeldStats
+	{
+		std::size_t VertexCountBefore = 0;
+		std::size_t VertexCountAfter = 0;
+		std::size_t IndexCountBefore = 0;
+		std::size_t IndexCountAfter = 0;
+
+		// System memory saved by the smaller vertex and index arrays.
+		std::size_t BytesSaved = 0;
+	};
+
+	///<summary>
+	/// Loads a model in the text format of Models/skull.txt and Models/car.txt
+	/// (positions and normals only).  Returns false if the file cannot be read or an
+	/// index is out of range of the vertices.
+	///</summary>
+	static bool LoadTextModel(const std::wstring& filename, GeometryGenerator::MeshData& meshData);
+
+	///<summary>
+	/// Merges vertices whose positions lie within epsilon of each other and whose
+	/// normal, tangent and texture coordinates also match within epsilon, then remaps
+	/// the indices and drops triangles that became degenerate.  Candidates are found
+	/// through a spatial hash with cells twice epsilon wide.  Each vertex is merged into
+	/// the lowest-indexed match, so the result does not depend on the thread count.
+	/// Returns false, leaving meshData as it is, if the indices do not form whole
+	/// triangles or one is out of range of the vertices.
+	///</summary>
+	static bool WeldVertices(GeometryGenerator::MeshData& meshData, float epsilon, WeldStats& stats);
+
+	///<summary>
+	/// Generates TangentU for every vertex from the positions, normals and texture
+	/// coordinates.  Each triangle's tangent is computed once; every vertex then sums the
+	/// tangents of its triangles in triangle order, so no atomics are needed and the
+	/// result is identical for any thread count.  The sum is made orthogonal to the
+	/// normal and normalized.  Vertices without a usable texture mapping (all
+	/// coordinates equal, as in the text models) get an arbitrary tangent perpendicular
+	/// to the normal.  Returns false, leaving meshData as it is, if the indices do not
+	/// form whole triangles or one is out of range of the vertices.
+	///</summary>
+	static bool ComputeTangents(GeometryGenerator::MeshData& meshData);
+
+	///<summary>
+	/// Computes the bounding box and bounding sphere of vertexCount positions, the first
+	/// element of each vertexByteStride sized vertex.  The positions are transposed into
+	/// blocks of four x, y and z values so every step works on four vertices at once.
+	/// The oriented box is only computed if orientedBox is not null.
+	///</summary>
+	static void ComputeBounds(const void* vertices, UINT vertexCount, UINT vertexByteStride,
+		DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere,
+		DirectX::BoundingOrientedBox* orientedBox = nullptr);
+
+	///<summary>
+	/// Fills the bounds of every entry in geo.DrawArgs from the CPU copies of the vertex
+	/// and index buffers.  Call once the DrawArgs are populated.
+	///</summary>
+	static void ComputeSubmeshBounds(MeshGeometry& geo, bool orientedBounds = false);
+};
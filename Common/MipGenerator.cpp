@@ -0,0 +1,390 @@
+//***************************************************************************************
+// MipGenerator.cpp
+//***************************************************************************************
+
+#include "MipGenerator.h"
+#include "TaskPool.h"
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	enum class TexelFormat
+	{
+		UByte4,
+		Half4,
+		Float4,
+	};
+
+	bool GetTexelFormat(DXGI_FORMAT format, TexelFormat& texel, bool& srgb)
+	{
+		srgb = false;
+
+		switch(format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			srgb = true;
+			texel = TexelFormat::UByte4;
+			return true;
+
+		// Every channel is filtered the same way and alpha is the fourth in both orders.
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			texel = TexelFormat::UByte4;
+			return true;
+
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			texel = TexelFormat::Half4;
+			return true;
+
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			texel = TexelFormat::Float4;
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	std::size_t GetTexelSize(TexelFormat texel)
+	{
+		switch(texel)
+		{
+		case TexelFormat::UByte4: return 4;
+		case TexelFormat::Half4:  return 8;
+		default:                  return 16;
+		}
+	}
+
+	void LoadRow(TexelFormat texel, bool srgb, const std::uint8_t* src, std::size_t width, XMFLOAT4A* dst)
+	{
+		for(std::size_t x = 0; x < width; ++x)
+		{
+			XMVECTOR v;
+			switch(texel)
+			{
+			case TexelFormat::UByte4: v = XMLoadUByteN4(reinterpret_cast<const XMUBYTEN4*>(src) + x); break;
+			case TexelFormat::Half4:  v = XMLoadHalf4(reinterpret_cast<const XMHALF4*>(src) + x); break;
+			default:                  v = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(src) + x); break;
+			}
+
+			if(srgb)
+				v = XMColorSRGBToRGB(v);
+
+			XMStoreFloat4A(&dst[x], v);
+		}
+	}
+
+	void StoreRow(TexelFormat texel, bool srgb, const XMFLOAT4A* src, std::size_t width, std::uint8_t* dst)
+	{
+		for(std::size_t x = 0; x < width; ++x)
+		{
+			XMVECTOR v = XMLoadFloat4A(&src[x]);
+			if(srgb)
+				v = XMColorRGBToSRGB(v);
+
+			// The UNORM store saturates the overshoot of the Kaiser filter.
+			switch(texel)
+			{
+			case TexelFormat::UByte4: XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(dst) + x, v); break;
+			case TexelFormat::Half4:  XMStoreHalf4(reinterpret_cast<XMHALF4*>(dst) + x, v); break;
+			default:                  XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(dst) + x, v); break;
+			}
+		}
+	}
+
+	// Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+	double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for(int k = 1; k < 32; ++k)
+		{
+			term *= (0.5*x / k) * (0.5*x / k);
+			sum += term;
+			if(term < sum*1e-12)
+				break;
+		}
+
+		return sum;
+	}
+
+	// The taps of a 1D resampling from srcSize to dstSize texels.  Every destination texel
+	// has TapCount taps; short kernels are padded with zero weights.
+	struct FilterWeights
+	{
+		std::size_t TapCount = 0;
+		std::vector<std::uint32_t> Indices;
+		std::vector<float> Weights;
+	};
+
+	FilterWeights BuildWeights(std::size_t srcSize, std::size_t dstSize, const MipGenerator::Options& options)
+	{
+		const double scale = (double)srcSize / (double)dstSize;
+		const double pi = 3.14159265358979323846;
+
+		std::vector<std::vector<std::pair<std::uint32_t, double>>> taps(dstSize);
+		for(std::size_t x = 0; x < dstSize; ++x)
+		{
+			auto addTap = [&](std::ptrdiff_t i, double w)
+			{
+				// Clamp to the edge.
+				i = std::min<std::ptrdiff_t>(std::max<std::ptrdiff_t>(i, 0), (std::ptrdiff_t)srcSize - 1);
+				taps[x].push_back(std::make_pair((std::uint32_t)i, w));
+			};
+
+			if(options.MipFilter == MipGenerator::Filter::Box)
+			{
+				// Exact overlap of each source texel with the destination texel's footprint,
+				// which also handles odd sizes.
+				const double lo = x*scale;
+				const double hi = (x + 1)*scale;
+				for(std::ptrdiff_t i = (std::ptrdiff_t)floor(lo); i < (std::ptrdiff_t)ceil(hi); ++i)
+					addTap(i, std::min<double>(hi, (double)i + 1.0) - std::max<double>(lo, (double)i));
+			}
+			else
+			{
+				const double width = options.KaiserWidth;
+				const double i0Alpha = BesselI0(options.KaiserAlpha);
+				const double center = (x + 0.5)*scale;
+				const double radius = width*scale;
+
+				for(std::ptrdiff_t i = (std::ptrdiff_t)floor(center - radius); i <= (std::ptrdiff_t)ceil(center + radius); ++i)
+				{
+					// Distance in destination texels.
+					const double t = ((double)i + 0.5 - center) / scale;
+					if(fabs(t) >= width)
+						continue;
+
+					const double sinc = t == 0.0 ? 1.0 : sin(pi*t) / (pi*t);
+					const double u = t / width;
+					const double window = BesselI0(options.KaiserAlpha*sqrt(1.0 - u*u)) / i0Alpha;
+
+					addTap(i, sinc*window);
+				}
+			}
+		}
+
+		FilterWeights weights;
+		for(const auto& t : taps)
+			weights.TapCount = std::max<std::size_t>(weights.TapCount, t.size());
+
+		weights.Indices.assign(dstSize*weights.TapCount, 0);
+		weights.Weights.assign(dstSize*weights.TapCount, 0.0f);
+
+		for(std::size_t x = 0; x < dstSize; ++x)
+		{
+			double sum = 0.0;
+			for(const auto& tap : taps[x])
+				sum += tap.second;
+
+			for(std::size_t k = 0; k < taps[x].size(); ++k)
+			{
+				weights.Indices[x*weights.TapCount + k] = taps[x][k].first;
+				weights.Weights[x*weights.TapCount + k] = (float)(taps[x][k].second / sum);
+			}
+		}
+
+		return weights;
+	}
+
+	// Rows per ParallelFor chunk, so every chunk filters a few thousand texels.
+	std::size_t RowGrain(std::size_t width)
+	{
+		return std::max<std::size_t>(1, 16384 / width);
+	}
+
+	void Downsample(const std::vector<XMFLOAT4A>& src, std::size_t srcWidth, std::size_t srcHeight,
+		std::vector<XMFLOAT4A>& dst, std::size_t dstWidth, std::size_t dstHeight,
+		std::vector<XMFLOAT4A>& temp, const MipGenerator::Options& options)
+	{
+		const FilterWeights horizontal = BuildWeights(srcWidth, dstWidth, options);
+		const FilterWeights vertical = BuildWeights(srcHeight, dstHeight, options);
+
+		temp.resize(dstWidth*srcHeight);
+		dst.resize(dstWidth*dstHeight);
+
+		TaskPool& pool = TaskPool::Default();
+
+		pool.ParallelFor(srcHeight, RowGrain(srcWidth), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t y = begin; y < end; ++y)
+			{
+				const XMFLOAT4A* srcRow = &src[y*srcWidth];
+				XMFLOAT4A* tempRow = &temp[y*dstWidth];
+
+				for(std::size_t x = 0; x < dstWidth; ++x)
+				{
+					const std::uint32_t* indices = &horizontal.Indices[x*horizontal.TapCount];
+					const float* w = &horizontal.Weights[x*horizontal.TapCount];
+
+					XMVECTOR sum = XMVectorZero();
+					for(std::size_t k = 0; k < horizontal.TapCount; ++k)
+						sum = XMVectorMultiplyAdd(XMVectorReplicate(w[k]), XMLoadFloat4A(&srcRow[indices[k]]), sum);
+
+					XMStoreFloat4A(&tempRow[x], sum);
+				}
+			}
+		});
+
+		// Whole rows are accumulated at a time so the reads stay sequential.
+		pool.ParallelFor(dstHeight, RowGrain(dstWidth), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t y = begin; y < end; ++y)
+			{
+				XMFLOAT4A* dstRow = &dst[y*dstWidth];
+				std::fill(dstRow, dstRow + dstWidth, XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f));
+
+				for(std::size_t k = 0; k < vertical.TapCount; ++k)
+				{
+					const float w = vertical.Weights[y*vertical.TapCount + k];
+					if(w == 0.0f)
+						continue;
+
+					const XMVECTOR weight = XMVectorReplicate(w);
+					const XMFLOAT4A* tempRow = &temp[vertical.Indices[y*vertical.TapCount + k]*dstWidth];
+
+					for(std::size_t x = 0; x < dstWidth; ++x)
+					{
+						XMVECTOR sum = XMVectorMultiplyAdd(weight, XMLoadFloat4A(&tempRow[x]), XMLoadFloat4A(&dstRow[x]));
+						XMStoreFloat4A(&dstRow[x], sum);
+					}
+				}
+			}
+		});
+	}
+}
+
+bool MipGenerator::IsSupported(DXGI_FORMAT format)
+{
+	TexelFormat texel;
+	bool srgb;
+	return GetTexelFormat(format, texel, srgb);
+}
+
+std::uint32_t MipGenerator::GetFullMipCount(std::size_t width, std::size_t height)
+{
+	std::uint32_t count = 1;
+	for(std::size_t size = std::max<std::size_t>(width, height); size > 1; size >>= 1)
+		++count;
+
+	return count;
+}
+
+bool MipGenerator::Generate(const DDSImage& source, DDSImage& result)
+{
+	return Generate(source, result, Options());
+}
+
+bool MipGenerator::Generate(const DDSImage& source, DDSImage& result, const Options& options)
+{
+	TexelFormat texel;
+	bool srgb;
+	if(!GetTexelFormat(source.Format, texel, srgb))
+		return false;
+
+	if(source.Dimension != DDS_DIMENSION_TEXTURE2D || source.Depth > 1 ||
+		source.Subresources.size() != source.MipCount*source.ArraySize || source.Subresources.empty())
+	{
+		return false;
+	}
+
+	srgb = srgb || options.SRGB;
+
+	const std::uint32_t fullCount = GetFullMipCount(source.Width, source.Height);
+	const std::uint32_t mipCount = options.MipCount == 0 ? fullCount : std::min<std::uint32_t>(options.MipCount, fullCount);
+	const std::size_t texelSize = GetTexelSize(texel);
+
+	DDSImage image;
+	image.Dimension = source.Dimension;
+	image.Format = source.Format;
+	image.Width = source.Width;
+	image.Height = source.Height;
+	image.Depth = 1;
+	image.MipCount = mipCount;
+	image.ArraySize = source.ArraySize;
+	image.IsCubeMap = source.IsCubeMap;
+
+	// Same order as in a DDS file: every mip of slice 0, then every mip of slice 1...
+	std::vector<std::size_t> offsets;
+	std::size_t byteSize = 0;
+	for(std::size_t j = 0; j < image.ArraySize; ++j)
+	{
+		for(std::uint32_t i = 0; i < mipCount; ++i)
+		{
+			DDSSubresource sub;
+			sub.Width = std::max<std::size_t>(image.Width >> i, 1);
+			sub.Height = std::max<std::size_t>(image.Height >> i, 1);
+			sub.Depth = 1;
+			sub.RowPitch = sub.Width*texelSize;
+			sub.SlicePitch = sub.RowPitch*sub.Height;
+			sub.NumRows = sub.Height;
+
+			offsets.push_back(byteSize);
+			byteSize += sub.SlicePitch;
+
+			image.Subresources.push_back(sub);
+		}
+	}
+
+	auto memory = std::make_shared<std::vector<std::uint8_t>>(byteSize);
+	for(std::size_t k = 0; k < image.Subresources.size(); ++k)
+		image.Subresources[k].Data = memory->data() + offsets[k];
+
+	TaskPool& pool = TaskPool::Default();
+
+	std::vector<XMFLOAT4A> level;
+	std::vector<XMFLOAT4A> next;
+	std::vector<XMFLOAT4A> temp;
+
+	for(std::size_t j = 0; j < image.ArraySize; ++j)
+	{
+		const DDSSubresource& top = source.Subresources[j*source.MipCount];
+		const DDSSubresource& dstTop = image.Subresources[j*mipCount];
+		std::uint8_t* dstTopData = memory->data() + offsets[j*mipCount];
+
+		// Mip 0 is copied as is and decoded once for filtering.
+		level.resize(top.Width*top.Height);
+		pool.ParallelFor(top.Height, RowGrain(top.Width), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t y = begin; y < end; ++y)
+			{
+				const std::uint8_t* srcRow = top.Data + y*top.RowPitch;
+				std::copy(srcRow, srcRow + dstTop.RowPitch, dstTopData + y*dstTop.RowPitch);
+				LoadRow(texel, srgb, srcRow, top.Width, &level[y*top.Width]);
+			}
+		});
+
+		for(std::uint32_t i = 1; i < mipCount; ++i)
+		{
+			const DDSSubresource& prev = image.Subresources[j*mipCount + i - 1];
+			const DDSSubresource& sub = image.Subresources[j*mipCount + i];
+			std::uint8_t* data = memory->data() + offsets[j*mipCount + i];
+
+			Downsample(level, prev.Width, prev.Height, next, sub.Width, sub.Height, temp, options);
+
+			pool.ParallelFor(sub.Height, RowGrain(sub.Width), [&](std::size_t begin, std::size_t end)
+			{
+				for(std::size_t y = begin; y < end; ++y)
+					StoreRow(texel, srgb, &next[y*sub.Width], sub.Width, data + y*sub.RowPitch);
+			});
+
+			std::swap(level, next);
+		}
+	}
+
+	image.BitData = memory->data();
+	image.BitSize = byteSize;
+	image.Memory = memory;
+
+	// Only now, since result may be source.
+	result = std::move(image);
+
+	return true;
+}
@@ -0,0 +1,62 @@
+//***************************************************************************************
+// MipGenerator.h
+//
+// Builds full mip chains on the CPU for uncompressed textures that were shipped without
+// one.  The result is a DDSImage with the same subresource layout DDSParser produces,
+// so it can be handed to CreateDDSTextureFromImage12, TextureCache or TextureStreamer
+// like a parsed file.
+//
+// Every level is filtered from the previous one in linear floating point, one texel per
+// XMVECTOR, with separate horizontal and vertical passes split into rows on
+// TaskPool::Default().
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+
+class MipGenerator
+{
+public:
+	enum class Filter
+	{
+		// Average of the texels each destination texel covers (2x2 for even sizes).
+		Box,
+
+		// Kaiser windowed sinc; sharper than the box filter with less aliasing.
+		Kaiser,
+	};
+
+	struct Options
+	{
+		Filter MipFilter = Filter::Box;
+
+		// Filter in linear space and store back to sRGB.  Always done for *_SRGB formats;
+		// set it for UNORM textures that hold sRGB colors.  Alpha is never converted.
+		bool SRGB = false;
+
+		// Number of levels to build, 0 for a full chain down to 1x1.
+		std::uint32_t MipCount = 0;
+
+		// Kaiser filter radius in destination texels, and its window shape.
+		float KaiserWidth = 3.0f;
+		float KaiserAlpha = 4.0f;
+	};
+
+	///<summary>
+	/// True for the formats Generate() handles: RGBA8 and BGRA8 (UNORM or SRGB),
+	/// RGBA16F and RGBA32F.
+	///</summary>
+	static bool IsSupported(DXGI_FORMAT format);
+
+	// Number of levels of a full chain for a width x height texture.
+	static std::uint32_t GetFullMipCount(std::size_t width, std::size_t height);
+
+	///<summary>
+	/// Builds a mip chain for every slice of a 2D texture, array or cube from mip 0 of
+	/// source; any other mips of source are ignored.  Returns false if the format or
+	/// dimension is not supported.  result owns its texels and may be source itself.
+	///</summary>
+	static bool Generate(const DDSImage& source, DDSImage& result, const Options& options);
+	static bool Generate(const DDSImage& source, DDSImage& result);
+};
@@ -0,0 +1,169 @@
+//***************************************************************************************
+// PrimitiveLODSet.cpp
+//***************************************************************************************
+
+#include "PrimitiveLODSet.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const float FinestLevelPixelHeight = 256.0f;
+}
+
+PrimitiveLODSet PrimitiveLODSet::CreateSphere(float radius, std::uint32_t sliceCount, std::uint32_t stackCount, UINT levelCount)
+{
+	assert(levelCount > 0);
+
+	GeometryGenerator geoGen;
+	PrimitiveLODSet set;
+	set.mBoundingRadius = radius;
+
+	for(UINT i = 0; i < levelCount; ++i)
+	{
+		set.AddLevel(geoGen.CreateSphere(radius, sliceCount, stackCount));
+
+		// A sphere needs at least 3 slices and 2 stacks to enclose any volume.
+		sliceCount = std::max<std::uint32_t>(sliceCount / 2, 3);
+		stackCount = std::max<std::uint32_t>(stackCount / 2, 2);
+	}
+
+	return set;
+}
+
+PrimitiveLODSet PrimitiveLODSet::CreateGeosphere(float radius, std::uint32_t numSubdivisions, UINT levelCount)
+{
+	assert(levelCount > 0);
+
+	GeometryGenerator geoGen;
+	PrimitiveLODSet set;
+	set.mBoundingRadius = radius;
+
+	// Level 0 is the icosahedron subdivided numSubdivisions times; the coarsest level
+	// is the plain icosahedron.
+	levelCount = std::min<UINT>(levelCount, numSubdivisions + 1);
+	for(UINT i = 0; i < levelCount; ++i)
+		set.AddLevel(geoGen.CreateGeosphere(radius, numSubdivisions - i));
+
+	return set;
+}
+
+PrimitiveLODSet PrimitiveLODSet::CreateCylinder(float bottomRadius, float topRadius, float height,
+	std::uint32_t sliceCount, std::uint32_t stackCount, UINT levelCount)
+{
+	assert(levelCount > 0);
+
+	GeometryGenerator geoGen;
+	PrimitiveLODSet set;
+
+	float r = std::max<float>(bottomRadius, topRadius);
+	set.mBoundingRadius = sqrtf(r*r + 0.25f*height*height);
+
+	for(UINT i = 0; i < levelCount; ++i)
+	{
+		set.AddLevel(geoGen.CreateCylinder(bottomRadius, topRadius, height, sliceCount, stackCount));
+
+		sliceCount = std::max<std::uint32_t>(sliceCount / 2, 3);
+		stackCount = std::max<std::uint32_t>(stackCount / 2, 1);
+	}
+
+	return set;
+}
+
+UINT PrimitiveLODSet::GetLevelCount()const
+{
+	return (UINT)mLevels.size();
+}
+
+float PrimitiveLODSet::GetBoundingRadius()const
+{
+	return mBoundingRadius;
+}
+
+float PrimitiveLODSet::GetMinPixelHeight(UINT level)const
+{
+	return mLevels[level].MinPixelHeight;
+}
+
+void PrimitiveLODSet::SetMinPixelHeight(UINT level, float pixels)
+{
+	mLevels[level].MinPixelHeight = pixels;
+}
+
+GeometryGenerator::MeshData PrimitiveLODSet::Flatten()const
+{
+	GeometryGenerator::MeshData meshData;
+
+	for(const Level& level : mLevels)
+	{
+		assert(level.Mesh.Indices32.size() == level.IndexCount);
+
+		// The indices of every level stay relative to the level; Register() turns the
+		// vertex offset into a BaseVertexLocation instead.
+		meshData.Vertices.insert(meshData.Vertices.end(), level.Mesh.Vertices.begin(), level.Mesh.Vertices.end());
+		meshData.Indices32.insert(meshData.Indices32.end(), level.Mesh.Indices32.begin(), level.Mesh.Indices32.end());
+	}
+
+	return meshData;
+}
+
+void PrimitiveLODSet::Register(MeshGeometry& geo, const std::string& name, UINT startIndex, INT baseVertex)
+{
+	for(size_t i = 0; i < mLevels.size(); ++i)
+	{
+		Level& level = mLevels[i];
+
+		level.Submesh.IndexCount = level.IndexCount;
+		level.Submesh.StartIndexLocation = startIndex;
+		level.Submesh.BaseVertexLocation = baseVertex;
+
+		geo.DrawArgs[name + "_lod" + std::to_string(i)] = level.Submesh;
+
+		startIndex += level.IndexCount;
+		baseVertex += (INT)level.VertexCount;
+
+		// The flattened copy has been uploaded by now; only the counts are needed later.
+		level.Mesh = GeometryGenerator::MeshData();
+	}
+}
+
+const SubmeshGeometry& PrimitiveLODSet::GetSubmesh(UINT level)const
+{
+	return mLevels[level].Submesh;
+}
+
+UINT PrimitiveLODSet::SelectLevel(float worldRadius, float distance, float fovY, float viewportHeight)const
+{
+	assert(!mLevels.empty());
+
+	const float pixels = ProjectedHeight(worldRadius, distance, fovY, viewportHeight);
+
+	for(UINT i = 0; i + 1 < (UINT)mLevels.size(); ++i)
+	{
+		if(pixels >= mLevels[i].MinPixelHeight)
+			return i;
+	}
+
+	return (UINT)mLevels.size() - 1;
+}
+
+float PrimitiveLODSet::ProjectedHeight(float radius, float distance, float fovY, float viewportHeight)
+{
+	// Inside the sphere it covers the whole screen.
+	if(distance <= radius)
+		return viewportHeight;
+
+	// The frustum is 2*d*tan(fovY/2) units high at distance d.
+	return viewportHeight * radius / (distance * tanf(0.5f*fovY));
+}
+
+void PrimitiveLODSet::AddLevel(GeometryGenerator::MeshData&& mesh)
+{
+	Level level;
+	level.Mesh = std::move(mesh);
+	level.VertexCount = (UINT)level.Mesh.Vertices.size();
+	level.IndexCount = (UINT)level.Mesh.Indices32.size();
+	level.MinPixelHeight = FinestLevelPixelHeight / (float)(1u << mLevels.size());
+
+	mLevels.push_back(std::move(level));
+}
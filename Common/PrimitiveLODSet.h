@@ -0,0 +1,99 @@
+//***************************************************************************************
+// PrimitiveLODSet.h
+//
+// Several tessellation levels of one GeometryGenerator primitive, stored back to back
+// so they can share a vertex/index buffer with the rest of a MeshGeometry.  Level 0 is
+// the finest.  Each frame the level to draw is picked from the height the primitive's
+// bounding sphere covers on screen.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryGenerator.h"
+#include "Camera.h"
+
+class PrimitiveLODSet
+{
+public:
+	PrimitiveLODSet() = default;
+
+	///<summary>
+	/// Builds levelCount spheres, halving the slice and stack counts for every level.
+	///</summary>
+	static PrimitiveLODSet CreateSphere(float radius, std::uint32_t sliceCount, std::uint32_t stackCount, UINT levelCount);
+
+	///<summary>
+	/// Builds levelCount geospheres, one subdivision less for every level.
+	///</summary>
+	static PrimitiveLODSet CreateGeosphere(float radius, std::uint32_t numSubdivisions, UINT levelCount);
+
+	///<summary>
+	/// Builds levelCount cylinders, halving the slice and stack counts for every level.
+	///</summary>
+	static PrimitiveLODSet CreateCylinder(float bottomRadius, float topRadius, float height,
+		std::uint32_t sliceCount, std::uint32_t stackCount, UINT levelCount);
+
+	UINT GetLevelCount()const;
+
+	// Radius of the bounding sphere around the origin in the primitive's local space.
+	float GetBoundingRadius()const;
+
+	// Level i is drawn while the primitive covers at least this many pixels on screen.
+	// By default level 0 needs 256 pixels and every following level half as many.
+	float GetMinPixelHeight(UINT level)const;
+	void SetMinPixelHeight(UINT level, float pixels);
+
+	///<summary>
+	/// Concatenates every level into one mesh, ready to be packed into a vertex/index
+	/// buffer like any other GeometryGenerator mesh.
+	///</summary>
+	GeometryGenerator::MeshData Flatten()const;
+
+	///<summary>
+	/// Adds one DrawArgs entry per level, named name + "_lod" + level, for the mesh
+	/// returned by Flatten() placed at startIndex/baseVertex in geo's buffers.  The
+	/// levels' vertices and indices are released, so call Flatten() first.
+	///</summary>
+	void Register(MeshGeometry& geo, const std::string& name, UINT startIndex, INT baseVertex);
+
+	// Submesh of a level; valid after Register().
+	const SubmeshGeometry& GetSubmesh(UINT level)const;
+
+	///<summary>
+	/// Returns the level to draw for a primitive whose world-space bounding sphere has
+	/// the given radius and lies distance units from the eye.
+	///</summary>
+	UINT SelectLevel(float worldRadius, float distance, float fovY, float viewportHeight)const;
+
+	UINT SelectLevel(float worldRadius, DirectX::FXMVECTOR worldCenter, const Camera& camera, float viewportHeight)const
+	{
+		float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(
+			DirectX::XMVectorSubtract(worldCenter, camera.GetPosition())));
+
+		return SelectLevel(worldRadius, distance, camera.GetFovY(), viewportHeight);
+	}
+
+	///<summary>
+	/// Height in pixels of a sphere of the given radius seen from distance units away.
+	///</summary>
+	static float ProjectedHeight(float radius, float distance, float fovY, float viewportHeight);
+
+private:
+	struct Level
+	{
+		// Empty once Register() has run.
+		GeometryGenerator::MeshData Mesh;
+		UINT VertexCount = 0;
+		UINT IndexCount = 0;
+
+		float MinPixelHeight = 0.0f;
+		SubmeshGeometry Submesh;
+	};
+
+	void AddLevel(GeometryGenerator::MeshData&& mesh);
+
+private:
+	std::vector<Level> mLevels;
+	float mBoundingRadius = 0.0f;
+};
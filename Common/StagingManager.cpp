@@ -0,0 +1,148 @@
+//***************************************************************************************
+// StagingManager.cpp
+//***************************************************************************************
+
+#include "StagingManager.h"
+#include "SubresourceCopy.h"
+
+using Microsoft::WRL::ComPtr;
+
+StagingManager::StagingManager(ID3D12Device* device)
+	: md3dDevice(device)
+{
+}
+
+void StagingManager::QueueBufferCopy(ID3D12Resource* dest, UINT64 destOffset, const void* data, UINT64 byteSize,
+	D3D12_RESOURCE_STATES destState)
+{
+	// Nothing to record, and a flush of only empty copies would create an empty buffer.
+	if(byteSize == 0)
+		return;
+
+	PendingCopy copy;
+	copy.Dest = dest;
+	copy.DestOffset = destOffset;
+	copy.DataOffset = mPendingData.size();
+	copy.ByteSize = byteSize;
+	copy.DestState = destState;
+	mPending.push_back(copy);
+
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+	mPendingData.insert(mPendingData.end(), bytes, bytes + byteSize);
+
+	mStats.PendingBytes += byteSize;
+	mStats.CopyCount++;
+	UpdatePeak();
+}
+
+ComPtr<ID3D12Resource> StagingManager::CreateDefaultBuffer(const void* initData, UINT64 byteSize)
+{
+	ComPtr<ID3D12Resource> defaultBuffer;
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(defaultBuffer.GetAddressOf())));
+	d3dUtil::TrackResource(defaultBuffer.Get(), MemoryTag::Geometry);
+
+	QueueBufferCopy(defaultBuffer.Get(), 0, initData, byteSize, D3D12_RESOURCE_STATE_GENERIC_READ);
+	return defaultBuffer;
+}
+
+void StagingManager::Flush(ID3D12GraphicsCommandList* cmdList, UINT64 fenceValue)
+{
+	if(mPending.empty())
+		return;
+
+	StagingBuffer staging;
+	staging.Fence = fenceValue;
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(mPendingData.size()),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(staging.Resource.GetAddressOf())));
+	d3dUtil::TrackResource(staging.Resource.Get(), MemoryTag::Upload);
+
+	const CD3DX12_RANGE readRange(0, 0);
+	std::uint8_t* mappedData = nullptr;
+	ThrowIfFailed(staging.Resource->Map(0, &readRange, reinterpret_cast<void**>(&mappedData)));
+
+	SubresourceCopyDesc desc;
+	desc.Dst = mappedData;
+	desc.DstRowPitch = mPendingData.size();
+	desc.DstSlicePitch = mPendingData.size();
+	desc.Src = mPendingData.data();
+	desc.SrcRowPitch = mPendingData.size();
+	desc.SrcSlicePitch = mPendingData.size();
+	desc.RowBytes = mPendingData.size();
+	desc.NumRows = 1;
+	SubresourceCopy::Copy(&desc, 1, SubresourceCopy::Destination::WriteCombined);
+
+	staging.Resource->Unmap(0, nullptr);
+
+	// One transition per destination resource, whatever the number of copies into it.
+	std::vector<D3D12_RESOURCE_BARRIER> toCopyDest;
+	std::vector<D3D12_RESOURCE_BARRIER> toRead;
+	for(const PendingCopy& copy : mPending)
+	{
+		auto seen = std::find_if(toCopyDest.begin(), toCopyDest.end(),
+			[&copy](const D3D12_RESOURCE_BARRIER& b) { return b.Transition.pResource == copy.Dest.Get(); });
+		if(seen != toCopyDest.end())
+			continue;
+
+		toCopyDest.push_back(CD3DX12_RESOURCE_BARRIER::Transition(copy.Dest.Get(),
+			copy.DestState, D3D12_RESOURCE_STATE_COPY_DEST));
+		toRead.push_back(CD3DX12_RESOURCE_BARRIER::Transition(copy.Dest.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, copy.DestState));
+	}
+
+	cmdList->ResourceBarrier((UINT)toCopyDest.size(), toCopyDest.data());
+	for(const PendingCopy& copy : mPending)
+	{
+		cmdList->CopyBufferRegion(copy.Dest.Get(), copy.DestOffset,
+			staging.Resource.Get(), copy.DataOffset, copy.ByteSize);
+	}
+	cmdList->ResourceBarrier((UINT)toRead.size(), toRead.data());
+
+	mStats.BarrierCount += (UINT)(toCopyDest.size() + toRead.size());
+	mStats.FlushCount++;
+	mStats.StagingBytes += mPendingData.size();
+	UpdatePeak();
+
+	mStats.PendingBytes = 0;
+	mPending.clear();
+	mPendingData.clear();
+	mPendingData.shrink_to_fit();
+
+	mStaging.push_back(staging);
+}
+
+void StagingManager::ReleaseCompleted(UINT64 completedFence)
+{
+	for(auto it = mStaging.begin(); it != mStaging.end();)
+	{
+		if(it->Fence <= completedFence)
+		{
+			mStats.StagingBytes -= it->Resource->GetDesc().Width;
+			it = mStaging.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+StagingManager::Stats StagingManager::GetStats()const
+{
+	return mStats;
+}
+
+void StagingManager::UpdatePeak()
+{
+	mStats.PeakBytes = std::max<UINT64>(mStats.PeakBytes, mStats.PendingBytes + mStats.StagingBytes);
+}
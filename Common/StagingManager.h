@@ -0,0 +1,87 @@
+//***************************************************************************************
+// StagingManager.h
+//
+// Gathers the buffer uploads made while a scene loads and records them together: one
+// upload buffer for all of their data, one barrier batch into COPY_DEST and one back,
+// with each destination resource transitioned once however many ranges of it are
+// written (GeometryHeap pages hold many).  The upload buffer is released by
+// ReleaseCompleted() once the fence passes the value given to Flush(), so nothing has
+// to hold on to per-mesh uploaders.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class StagingManager
+{
+public:
+	struct Stats
+	{
+		// Queued and not yet flushed.
+		UINT64 PendingBytes = 0;
+
+		// Upload buffers waiting for their fence.
+		UINT64 StagingBytes = 0;
+
+		// Highest PendingBytes + StagingBytes so far: the extra memory loading took.
+		UINT64 PeakBytes = 0;
+
+		UINT CopyCount = 0;
+		UINT BarrierCount = 0;
+		UINT FlushCount = 0;
+	};
+
+	explicit StagingManager(ID3D12Device* device);
+	StagingManager(const StagingManager& rhs) = delete;
+	StagingManager& operator=(const StagingManager& rhs) = delete;
+
+	///<summary>
+	/// Queues a copy of byteSize bytes from data into dest at destOffset.  data is copied
+	/// before the call returns.  dest is in destState before and after the copy.  An empty
+	/// copy is ignored.
+	///</summary>
+	void QueueBufferCopy(ID3D12Resource* dest, UINT64 destOffset, const void* data, UINT64 byteSize,
+		D3D12_RESOURCE_STATES destState);
+
+	// Like d3dUtil::CreateDefaultBuffer, with the upload queued here.
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(const void* initData, UINT64 byteSize);
+
+	///<summary>
+	/// Records every queued copy on cmdList.  The GPU is done with them once the fence
+	/// reaches fenceValue.
+	///</summary>
+	void Flush(ID3D12GraphicsCommandList* cmdList, UINT64 fenceValue);
+
+	// Releases the upload buffers of flushes whose fence value is at most completedFence.
+	void ReleaseCompleted(UINT64 completedFence);
+
+	Stats GetStats()const;
+
+private:
+	struct PendingCopy
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Dest;
+		UINT64 DestOffset = 0;
+		UINT64 DataOffset = 0;
+		UINT64 ByteSize = 0;
+		D3D12_RESOURCE_STATES DestState = D3D12_RESOURCE_STATE_COMMON;
+	};
+
+	struct StagingBuffer
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		UINT64 Fence = 0;
+	};
+
+	void UpdatePeak();
+
+private:
+	ID3D12Device* md3dDevice = nullptr;
+
+	std::vector<PendingCopy> mPending;
+	std::vector<std::uint8_t> mPendingData;
+	std::vector<StagingBuffer> mStaging;
+
+	Stats mStats;
+};
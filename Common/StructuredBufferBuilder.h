@@ -0,0 +1,70 @@
+//***************************************************************************************
+// StructuredBufferBuilder.h
+//
+// Builds an array of T in ordinary memory and uploads it tightly packed, sizeof(T) apart,
+// for a shader to read as StructuredBuffer<T> through a root SRV.  Constant buffers put
+// every element on its own 256 byte boundary, so a 128 byte ObjectConstants took 256
+// bytes of upload memory; an array indexed by a root constant takes only what it holds.
+// The whole array goes to the write-combined upload memory in one streaming copy.
+//***************************************************************************************
+
+#pragma once
+
+#include "UploadRing.h"
+#include "SubresourceCopy.h"
+#include <vector>
+
+template<typename T>
+class StructuredBufferBuilder
+{
+public:
+	// Element addresses are aligned to this; enough for any float4 member.
+	static const std::uint64_t Alignment = 16;
+
+	// Keeps the memory of earlier frames, so steady frames do not allocate.
+	void Resize(std::size_t count)
+	{
+		mElements.resize(count);
+	}
+
+	T& operator[](std::size_t index)
+	{
+		return mElements[index];
+	}
+
+	const T& operator[](std::size_t index)const
+	{
+		return mElements[index];
+	}
+
+	std::size_t GetCount()const
+	{
+		return mElements.size();
+	}
+
+	std::uint64_t GetByteSize()const
+	{
+		return sizeof(T) * mElements.size();
+	}
+
+	///<summary>
+	/// Copies the array into memory allocated from ring and returns it; bind its GPU
+	/// address as the root SRV.  CPU is null if the ring could not grow.
+	///</summary>
+	UploadAllocation Upload(UploadRing& ring)const
+	{
+		UploadAllocation allocation = ring.Allocate(GetByteSize(), Alignment);
+		if(allocation.CPU != nullptr && !mElements.empty())
+		{
+			SubresourceCopy::CopyBytes(allocation.CPU, mElements.data(), (std::size_t)GetByteSize(),
+				SubresourceCopy::Destination::WriteCombined);
+		}
+		return allocation;
+	}
+
+private:
+	std::vector<T> mElements;
+};
+
+template<typename T>
+const std::uint64_t StructuredBufferBuilder<T>::Alignment;
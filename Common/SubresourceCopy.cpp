@@ -0,0 +1,174 @@
+//***************************************************************************************
+// SubresourceCopy.cpp
+//***************************************************************************************
+
+#include "SubresourceCopy.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SUBRESOURCE_COPY_STREAMING 1
+#else
+#define SUBRESOURCE_COPY_STREAMING 0
+#endif
+
+namespace
+{
+	// Rows of one slice, or a byte range of tightly packed data as a single row.
+	struct CopySpan
+	{
+		std::uint8_t* Dst;
+		const std::uint8_t* Src;
+		std::size_t DstRowPitch;
+		std::size_t SrcRowPitch;
+		std::size_t RowBytes;
+		std::size_t NumRows;
+	};
+
+	void StreamBytes(std::uint8_t* dst, const std::uint8_t* src, std::size_t byteSize)
+	{
+#if SUBRESOURCE_COPY_STREAMING
+		// Plain stores up to the first 16 byte boundary of the destination.
+		const std::size_t head = std::min<std::size_t>((16 - ((std::uintptr_t)dst & 15)) & 15, byteSize);
+		std::memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		byteSize -= head;
+
+		// Whole 64 byte lines, so the write-combining buffers fill completely.
+		for(; byteSize >= 64; byteSize -= 64, dst += 64, src += 64)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+			const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+		}
+
+		for(; byteSize >= 16; byteSize -= 16, dst += 16, src += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+#endif
+
+		std::memcpy(dst, src, byteSize);
+	}
+
+	// Non-temporal stores are weakly ordered; every thread that made some fences them
+	// before the copy counts as done.
+	void FlushStreamingStores()
+	{
+#if SUBRESOURCE_COPY_STREAMING
+		_mm_sfence();
+#endif
+	}
+
+	void CopySpanRows(const CopySpan& span, SubresourceCopy::Destination destination)
+	{
+		for(std::size_t row = 0; row < span.NumRows; ++row)
+		{
+			std::uint8_t* dst = span.Dst + row*span.DstRowPitch;
+			const std::uint8_t* src = span.Src + row*span.SrcRowPitch;
+
+			if(destination == SubresourceCopy::Destination::WriteCombined)
+				StreamBytes(dst, src, span.RowBytes);
+			else
+				std::memcpy(dst, src, span.RowBytes);
+		}
+	}
+
+	// Cuts every subresource into spans of about SpanBytes.  Data whose rows follow
+	// each other without gaps on both sides is cut by bytes, so a single row buffer
+	// splits too; anything else is cut by whole rows within each slice.
+	void BuildSpans(const SubresourceCopyDesc& desc, std::vector<CopySpan>& spans)
+	{
+		const std::size_t sliceBytes = desc.RowBytes*desc.NumRows;
+		const bool packed =
+			(desc.NumRows == 1 || (desc.DstRowPitch == desc.RowBytes && desc.SrcRowPitch == desc.RowBytes)) &&
+			(desc.NumSlices == 1 || (desc.DstSlicePitch == sliceBytes && desc.SrcSlicePitch == sliceBytes));
+
+		if(packed)
+		{
+			const std::size_t byteSize = sliceBytes*desc.NumSlices;
+			for(std::size_t offset = 0; offset < byteSize; offset += SubresourceCopy::SpanBytes)
+			{
+				const std::size_t bytes = std::min<std::size_t>(SubresourceCopy::SpanBytes, byteSize - offset);
+				spans.push_back({ desc.Dst + offset, desc.Src + offset, bytes, bytes, bytes, 1 });
+			}
+			return;
+		}
+
+		const std::size_t rowsPerSpan = std::max<std::size_t>(SubresourceCopy::SpanBytes / std::max<std::size_t>(desc.RowBytes, 1), 1);
+		for(std::size_t z = 0; z < desc.NumSlices; ++z)
+		{
+			for(std::size_t row = 0; row < desc.NumRows; row += rowsPerSpan)
+			{
+				CopySpan span;
+				span.Dst = desc.Dst + z*desc.DstSlicePitch + row*desc.DstRowPitch;
+				span.Src = desc.Src + z*desc.SrcSlicePitch + row*desc.SrcRowPitch;
+				span.DstRowPitch = desc.DstRowPitch;
+				span.SrcRowPitch = desc.SrcRowPitch;
+				span.RowBytes = desc.RowBytes;
+				span.NumRows = std::min<std::size_t>(rowsPerSpan, desc.NumRows - row);
+				spans.push_back(span);
+			}
+		}
+	}
+}
+
+const std::size_t SubresourceCopy::SerialBytes;
+const std::size_t SubresourceCopy::SpanBytes;
+
+void SubresourceCopy::CopyBytes(void* dst, const void* src, std::size_t byteSize, Destination destination)
+{
+	if(destination == Destination::WriteCombined)
+	{
+		StreamBytes(static_cast<std::uint8_t*>(dst), static_cast<const std::uint8_t*>(src), byteSize);
+		FlushStreamingStores();
+	}
+	else
+	{
+		std::memcpy(dst, src, byteSize);
+	}
+}
+
+void SubresourceCopy::Copy(const SubresourceCopyDesc* descs, std::size_t count, Destination destination,
+	TaskPool& pool)
+{
+	std::size_t totalBytes = 0;
+	for(std::size_t i = 0; i < count; ++i)
+		totalBytes += descs[i].RowBytes*descs[i].NumRows*descs[i].NumSlices;
+
+	if(totalBytes < SerialBytes || pool.GetThreadCount() == 1)
+	{
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			const SubresourceCopyDesc& desc = descs[i];
+			for(std::size_t z = 0; z < desc.NumSlices; ++z)
+			{
+				const CopySpan span = { desc.Dst + z*desc.DstSlicePitch, desc.Src + z*desc.SrcSlicePitch,
+					desc.DstRowPitch, desc.SrcRowPitch, desc.RowBytes, desc.NumRows };
+				CopySpanRows(span, destination);
+			}
+		}
+
+		FlushStreamingStores();
+		return;
+	}
+
+	std::vector<CopySpan> spans;
+	spans.reserve(totalBytes / SpanBytes + count);
+	for(std::size_t i = 0; i < count; ++i)
+		BuildSpans(descs[i], spans);
+
+	pool.ParallelFor(spans.size(), 1, [&spans, destination](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t i = begin; i < end; ++i)
+			CopySpanRows(spans[i], destination);
+
+		FlushStreamingStores();
+	});
+}
@@ -0,0 +1,65 @@
+//***************************************************************************************
+// SubresourceCopy.h
+//
+// Copies subresources into upload memory, the work d3dx12.h's MemcpySubresource does
+// one row at a time on the calling thread.  Large copies are cut into spans of rows (or
+// of bytes, for tightly packed data such as buffers) that run in parallel on a TaskPool.
+// Upload heaps are write-combined, so their copies use non-temporal stores, which skip
+// the cache instead of reading destination lines in that will never be read back.
+//
+// Nothing here touches Direct3D, so the copies can be timed against plain (cached) CPU
+// memory on any system; d3dUtil::UploadSubresources wires them to the D3D12 footprints.
+//***************************************************************************************
+
+#pragma once
+
+#include "TaskPool.h"
+#include <cstddef>
+#include <cstdint>
+
+// One subresource: NumSlices slices of NumRows rows of RowBytes bytes each.  Mirrors
+// D3D12_MEMCPY_DEST and D3D12_SUBRESOURCE_DATA.
+struct SubresourceCopyDesc
+{
+	std::uint8_t* Dst = nullptr;
+	std::size_t DstRowPitch = 0;
+	std::size_t DstSlicePitch = 0;
+
+	const std::uint8_t* Src = nullptr;
+	std::size_t SrcRowPitch = 0;
+	std::size_t SrcSlicePitch = 0;
+
+	std::size_t RowBytes = 0;
+	std::size_t NumRows = 0;
+	std::size_t NumSlices = 1;
+};
+
+class SubresourceCopy
+{
+public:
+	enum class Destination
+	{
+		// Ordinary memory; copied with memcpy.
+		Cached,
+
+		// Memory the CPU only writes, such as a mapped upload heap; copied with
+		// non-temporal stores where the CPU has them.
+		WriteCombined,
+	};
+
+	// Copies below this many bytes run on the calling thread.
+	static const std::size_t SerialBytes = 256*1024;
+
+	// Bytes per span handed to the pool.
+	static const std::size_t SpanBytes = 64*1024;
+
+	static void CopyBytes(void* dst, const void* src, std::size_t byteSize, Destination destination);
+
+	///<summary>
+	/// Copies the subresources, splitting them into spans over pool once they add up to
+	/// SerialBytes.  Returns when every byte has been written and, for write-combined
+	/// destinations, flushed.
+	///</summary>
+	static void Copy(const SubresourceCopyDesc* descs, std::size_t count, Destination destination,
+		TaskPool& pool = TaskPool::Default());
+};
@@ -0,0 +1,160 @@
+//***************************************************************************************
+// TaskPool.cpp
+//***************************************************************************************
+
+#include "TaskPool.h"
+#include <algorithm>
+
+namespace
+{
+	// Shared between the caller of ParallelFor and the helper tasks it queued.  Helpers
+	// that only start after every chunk was claimed touch nothing but this state, so
+	// the caller does not have to wait for them.
+	struct ParallelForState
+	{
+		std::function<void(std::size_t, std::size_t)> Body;
+		std::size_t Count = 0;
+		std::size_t GrainSize = 0;
+		std::size_t ChunkCount = 0;
+
+		std::atomic<std::size_t> NextChunk{ 0 };
+		std::atomic<std::size_t> ChunksDone{ 0 };
+
+		std::mutex Mutex;
+		std::condition_variable Done;
+
+		// First exception thrown by Body; the chunks after it are skipped.
+		std::exception_ptr Error;
+		std::atomic<bool> Failed{ false };
+
+		// Never throws: every claimed chunk is counted as done, or the caller would wait
+		// forever (or return while helpers still run Body on its stack).
+		void RunChunks()
+		{
+			std::size_t chunk;
+			while((chunk = NextChunk.fetch_add(1)) < ChunkCount)
+			{
+				if(!Failed.load())
+				{
+					std::size_t begin = chunk*GrainSize;
+					std::size_t end = std::min<std::size_t>(begin + GrainSize, Count);
+					try
+					{
+						Body(begin, end);
+					}
+					catch(...)
+					{
+						std::lock_guard<std::mutex> lock(Mutex);
+						if(!Failed.exchange(true))
+							Error = std::current_exception();
+					}
+				}
+
+				if(ChunksDone.fetch_add(1) + 1 == ChunkCount)
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					Done.notify_all();
+				}
+			}
+		}
+	};
+}
+
+TaskPool::TaskPool(unsigned workerCount)
+{
+	if(workerCount == 0)
+	{
+		unsigned hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for(unsigned i = 0; i < workerCount; ++i)
+		mWorkers.emplace_back(&TaskPool::WorkerLoop, this);
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+	mWake.notify_all();
+
+	for(auto& t : mWorkers)
+		t.join();
+}
+
+TaskPool& TaskPool::Default()
+{
+	static TaskPool pool;
+	return pool;
+}
+
+unsigned TaskPool::GetThreadCount()const
+{
+	return (unsigned)mWorkers.size() + 1;
+}
+
+void TaskPool::ParallelFor(std::size_t count, std::size_t grainSize,
+	const std::function<void(std::size_t, std::size_t)>& body)
+{
+	if(count == 0)
+		return;
+
+	grainSize = std::max<std::size_t>(grainSize, 1);
+
+	const std::size_t chunkCount = (count + grainSize - 1) / grainSize;
+	if(chunkCount == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>();
+	state->Body = body;
+	state->Count = count;
+	state->GrainSize = grainSize;
+	state->ChunkCount = chunkCount;
+
+	const std::size_t helperCount = std::min<std::size_t>(mWorkers.size(), chunkCount - 1);
+	for(std::size_t i = 0; i < helperCount; ++i)
+		Enqueue([state]() { state->RunChunks(); });
+
+	state->RunChunks();
+
+	std::unique_lock<std::mutex> lock(state->Mutex);
+	state->Done.wait(lock, [&state]() { return state->ChunksDone.load() == state->ChunkCount; });
+
+	if(state->Error)
+		std::rethrow_exception(state->Error);
+}
+
+void TaskPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueue.push_back(std::move(task));
+	}
+	mWake.notify_one();
+}
+
+void TaskPool::WorkerLoop()
+{
+	for(;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this]() { return mShutdown || !mQueue.empty(); });
+
+			if(mShutdown && mQueue.empty())
+				return;
+
+			task = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		// Submit() and ParallelFor() tasks catch their own exceptions.
+		task();
+	}
+}
@@ -0,0 +1,72 @@
+//***************************************************************************************
+// TaskPool.h
+//
+// Small fixed-size worker pool used by the CPU-side asset processing code (mesh welding,
+// tangent generation, texture loading...).  Work is either submitted as independent
+// tasks or split into chunks with ParallelFor, where the calling thread helps out until
+// every chunk has run, so ParallelFor may be nested inside a task without deadlocking.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskPool
+{
+public:
+	// workerCount == 0 uses one worker per hardware thread, minus the calling thread.
+	explicit TaskPool(unsigned workerCount = 0);
+	TaskPool(const TaskPool& rhs) = delete;
+	TaskPool& operator=(const TaskPool& rhs) = delete;
+	~TaskPool();
+
+	// Process-wide pool shared by the Common helpers.
+	static TaskPool& Default();
+
+	// Number of threads that execute ParallelFor chunks (workers plus the caller).
+	unsigned GetThreadCount()const;
+
+	// Queues f on a worker thread and returns a future for its result.  An exception
+	// thrown by f is stored in the future and rethrown by get().
+	template<typename F>
+	auto Submit(F&& f) -> std::future<decltype(f())>
+	{
+		using R = decltype(f());
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+		std::future<R> result = task->get_future();
+		Enqueue([task]() { (*task)(); });
+		return result;
+	}
+
+	///<summary>
+	/// Splits [0, count) into chunks of at most grainSize elements and calls
+	/// body(begin, end) for each chunk.  Chunk boundaries only depend on count and
+	/// grainSize, never on the number of threads.  Returns when all chunks have run.
+	/// If body throws, the chunks not yet started are skipped and the first exception
+	/// is rethrown on the calling thread once no chunk is running any more.
+	///</summary>
+	void ParallelFor(std::size_t count, std::size_t grainSize,
+		const std::function<void(std::size_t, std::size_t)>& body);
+
+private:
+	void Enqueue(std::function<void()> task);
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::deque<std::function<void()>> mQueue;
+	bool mShutdown = false;
+};
@@ -0,0 +1,214 @@
+//***************************************************************************************
+// TextureBatchLoader.cpp
+//***************************************************************************************
+
+#include "TextureBatchLoader.h"
+#include "KTXParser.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include "TexturePacker.h"
+#include <chrono>
+#include <iomanip>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	struct ParseJob
+	{
+		DDSImage Image;
+		DDSParser::Result Result = DDSParser::Result::Ok;
+		std::uint64_t ContentHash = 0;
+		std::uint64_t FileBytes = 0;
+		double ParseMs = 0.0;
+		Clock::time_point Finished;
+
+		// The call that failed, for the exception.
+		std::wstring FailedCall;
+	};
+
+	// Parses the slice files of an array entry and stacks them into one texture array.
+	DDSParser::Result ParseArraySlices(const TextureLoadEntry& entry, ParseJob& job)
+	{
+		std::vector<DDSImage> slices(entry.ArraySlices.size());
+		std::vector<const DDSImage*> sources;
+
+		for(size_t i = 0; i < slices.size(); ++i)
+		{
+			DDSParser::Result result = KTXParser::ParseTextureFile(entry.ArraySlices[i], slices[i]);
+			if(result != DDSParser::Result::Ok)
+			{
+				job.FailedCall = L"KTXParser::ParseTextureFile(" + entry.ArraySlices[i] + L")";
+				return result;
+			}
+
+			job.FileBytes += slices[i].File->Size();
+			sources.push_back(&slices[i]);
+		}
+
+		if(!TexturePacker::BuildArray(sources, job.Image))
+		{
+			job.FailedCall = L"TexturePacker::BuildArray(" + AnsiToWString(entry.Name) + L")";
+			return DDSParser::Result::NotSupported;
+		}
+
+		return DDSParser::Result::Ok;
+	}
+
+	void RunParseJob(const TextureLoadEntry& entry, ParseJob& job)
+	{
+		Clock::time_point start = Clock::now();
+
+		if(entry.ArraySlices.empty())
+		{
+			job.Result = KTXParser::ParseTextureFile(entry.Filename, job.Image);
+			job.FailedCall = L"KTXParser::ParseTextureFile(" + entry.Filename + L")";
+			if(job.Result == DDSParser::Result::Ok)
+				job.FileBytes = job.Image.File->Size();
+		}
+		else
+		{
+			job.Result = ParseArraySlices(entry, job);
+		}
+
+		// Hashing reads every texel, so it also faults the file in here and the recording
+		// thread copies from memory instead of waiting on the disk.
+		if(job.Result == DDSParser::Result::Ok)
+			job.ContentHash = TextureCache::HashContents(job.Image);
+
+		// The generated chain only depends on the file, so it is keyed by the file's hash
+		// and its mip count instead of being hashed again.
+		if(job.Result == DDSParser::Result::Ok && entry.GenerateMips &&
+			job.Image.MipCount < MipGenerator::GetFullMipCount(job.Image.Width, job.Image.Height) &&
+			MipGenerator::Generate(job.Image, job.Image))
+		{
+			job.ContentHash = TextureCache::HashBytes(&job.ContentHash, sizeof(job.ContentHash), job.Image.MipCount);
+		}
+
+		job.Finished = Clock::now();
+		job.ParseMs = std::chrono::duration<double, std::milli>(job.Finished - start).count();
+	}
+}
+
+std::wstring TextureBatchLoader::Report::ToString()const
+{
+	std::uint64_t totalBytes = 0;
+	for(const TextureTiming& t : Textures)
+		totalBytes += t.Bytes;
+
+	std::wostringstream text;
+	text << std::fixed << std::setprecision(2);
+	text << L"Loaded " << Textures.size() << L" textures (" << totalBytes / 1024 << L" KB) in "
+		<< TotalMs << L" ms: parse " << ParseMs << L" ms, upload " << UploadMs << L" ms, "
+		<< BytesSaved / 1024 << L" KB shared\n";
+
+	for(const TextureTiming& t : Textures)
+	{
+		text << L"    " << AnsiToWString(t.Name) << L": " << t.Bytes / 1024 << L" KB, parse "
+			<< t.ParseMs << L" ms, upload " << t.UploadMs << L" ms" << (t.Shared ? L" (shared)\n" : L"\n");
+	}
+
+	return text.str();
+}
+
+TextureBatchLoader::Report TextureBatchLoader::Load(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, UINT64 fenceValue,
+	const std::vector<TextureLoadEntry>& entries,
+	std::unordered_map<std::string, std::unique_ptr<Texture>>& textures,
+	TextureCache& cache, TaskPool& pool)
+{
+	Clock::time_point start = Clock::now();
+
+	std::vector<ParseJob> jobs(entries.size());
+	std::vector<std::future<void>> parsed;
+	parsed.reserve(entries.size());
+
+	for(size_t i = 0; i < entries.size(); ++i)
+	{
+		const TextureLoadEntry* entry = &entries[i];
+		ParseJob* job = &jobs[i];
+		parsed.push_back(pool.Submit([entry, job]() { RunParseJob(*entry, *job); }));
+	}
+
+	Report report;
+	report.Textures.resize(entries.size());
+
+	try
+	{
+		for(size_t i = 0; i < entries.size(); ++i)
+		{
+			// get() rethrows anything the job threw, such as std::bad_alloc.
+			parsed[i].get();
+
+			ParseJob& job = jobs[i];
+			report.ParseMs = std::max<double>(report.ParseMs,
+				std::chrono::duration<double, std::milli>(job.Finished - start).count());
+
+			if(job.Result != DDSParser::Result::Ok)
+				throw DxException(TextureCache::ParseResultToHRESULT(job.Result), job.FailedCall, AnsiToWString(__FILE__), __LINE__);
+
+			Clock::time_point uploadStart = Clock::now();
+
+			const std::uint64_t savedBefore = cache.GetStats().BytesSaved;
+
+			auto tex = std::make_unique<Texture>();
+			tex->Name = entries[i].Name;
+			tex->Filename = entries[i].ArraySlices.empty() ? entries[i].Filename : entries[i].ArraySlices[0];
+
+			HRESULT hr = cache.Acquire(device, cmdList, job.Image, job.ContentHash, tex->CacheHandle);
+			if(FAILED(hr))
+				throw DxException(hr, L"TextureCache::Acquire(" + tex->Filename + L")", AnsiToWString(__FILE__), __LINE__);
+
+			tex->Resource = cache.GetResource(tex->CacheHandle);
+			tex->UploadHeap = cache.GetUploadHeap(tex->CacheHandle);
+
+			// A name that is loaded again replaces its texture.  Frames already submitted
+			// may still draw with the old one, so the cache keeps it until fenceValue.
+			auto old = textures.find(tex->Name);
+			if(old != textures.end() && old->second->CacheHandle != TextureCache::InvalidHandle)
+				cache.ReleaseAfter(old->second->CacheHandle, fenceValue);
+
+			textures[tex->Name] = std::move(tex);
+
+			TextureTiming& timing = report.Textures[i];
+			timing.Name = entries[i].Name;
+			timing.Bytes = job.FileBytes;
+			timing.ParseMs = job.ParseMs;
+			timing.UploadMs = MillisecondsSince(uploadStart);
+			timing.Shared = cache.GetStats().BytesSaved != savedBefore;
+			report.UploadMs += timing.UploadMs;
+			report.BytesSaved += cache.GetStats().BytesSaved - savedBefore;
+
+			// The upload heap now holds the texels; let go of the mapping.
+			job.Image = DDSImage();
+		}
+	}
+	catch(...)
+	{
+		// The jobs point into entries and jobs, so every one of them has to finish before
+		// the error can leave this function.  Only the first error is reported.
+		for(std::future<void>& f : parsed)
+		{
+			if(!f.valid())
+				continue;
+
+			try
+			{
+				f.get();
+			}
+			catch(...)
+			{
+			}
+		}
+
+		throw;
+	}
+
+	report.TotalMs = MillisecondsSince(start);
+
+	return report;
+}
@@ -0,0 +1,86 @@
+//***************************************************************************************
+// TextureBatchLoader.h
+//
+// Loads a list of DDS or KTX2 textures for LoadTextures().  The files are mapped, parsed
+// and read in on TaskPool workers, all at once, while the calling thread records the
+// uploads on the command list one texture at a time, in list order, as soon as each one
+// is parsed.  Zlib supercompressed KTX2 levels are inflated on the workers too, so the
+// recording thread only ever copies.  The returned report gives the time spent on every
+// texture and on the whole batch.
+//
+// The textures are created through the app's TextureCache, so files with the same
+// contents share one resource; Texture::CacheHandle holds the cache reference.  An entry
+// can also name a list of files that are stacked into one texture array by
+// TexturePacker, so a set of textures binds with a single SRV.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "TaskPool.h"
+#include "TextureCache.h"
+
+struct TextureLoadEntry
+{
+	std::string Name;
+	std::wstring Filename;
+
+	// Build the missing mips of uncompressed textures with MipGenerator.
+	bool GenerateMips = true;
+
+	// When not empty, the entry is one Texture2DArray with these files as its slices, in
+	// order, instead of Filename.  The files must share format and size.
+	std::vector<std::wstring> ArraySlices;
+};
+
+class TextureBatchLoader
+{
+public:
+	struct TextureTiming
+	{
+		std::string Name;
+
+		// Size of the file.
+		std::uint64_t Bytes = 0;
+
+		// Time a worker spent mapping, parsing and reading in the file.
+		double ParseMs = 0.0;
+
+		// Time the calling thread spent creating the resources and recording the copies.
+		double UploadMs = 0.0;
+
+		// The cache already held a texture with the same contents.
+		bool Shared = false;
+	};
+
+	struct Report
+	{
+		std::vector<TextureTiming> Textures;
+
+		// Wall clock time until the last file was parsed, and for the whole batch.
+		double ParseMs = 0.0;
+		double TotalMs = 0.0;
+
+		// Sum of the per texture upload times.
+		double UploadMs = 0.0;
+
+		// Texel bytes not uploaded because the cache already held them.
+		std::uint64_t BytesSaved = 0;
+
+		// One line for the batch followed by one line per texture.
+		std::wstring ToString()const;
+	};
+
+	///<summary>
+	/// Creates one Texture per entry in textures, keyed by the entry name, recording the
+	/// uploads on cmdList.  A name already in textures is replaced; the cache reference
+	/// of its old texture is released once the fence reaches fenceValue, which must not
+	/// come before the GPU is done with the frames that draw with it.  Throws
+	/// DxException if a file cannot be loaded, and rethrows anything else a worker
+	/// throws, once every worker is done; the textures loaded before it stay in the map.
+	///</summary>
+	static Report Load(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+		UINT64 fenceValue, const std::vector<TextureLoadEntry>& entries,
+		std::unordered_map<std::string, std::unique_ptr<Texture>>& textures,
+		TextureCache& cache, TaskPool& pool = TaskPool::Default());
+};
@@ -0,0 +1,286 @@
+//***************************************************************************************
+// TextureCache.cpp
+//***************************************************************************************
+
+#include "TextureCache.h"
+#include "KTXParser.h"
+#include <cstring>
+
+const TextureCache::Handle TextureCache::InvalidHandle;
+
+namespace
+{
+	const std::uint64_t Prime1 = 11400714785074694791ull;
+	const std::uint64_t Prime2 = 14029467366897019727ull;
+	const std::uint64_t Prime3 = 1609587929392839161ull;
+	const std::uint64_t Prime4 = 9650029242287828579ull;
+	const std::uint64_t Prime5 = 2870177450012600261ull;
+
+	std::uint64_t RotateLeft(std::uint64_t x, int r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	std::uint64_t Read64(const std::uint8_t* p)
+	{
+		std::uint64_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	std::uint32_t Read32(const std::uint8_t* p)
+	{
+		std::uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	std::uint64_t Round(std::uint64_t acc, std::uint64_t input)
+	{
+		acc += input * Prime2;
+		acc = RotateLeft(acc, 31);
+		return acc * Prime1;
+	}
+
+	std::uint64_t MergeRound(std::uint64_t acc, std::uint64_t val)
+	{
+		acc ^= Round(0, val);
+		return acc * Prime1 + Prime4;
+	}
+}
+
+HRESULT TextureCache::Acquire(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+	const DDSImage& image, std::uint64_t contentHash, Handle& handle)
+{
+	handle = InvalidHandle;
+
+	auto it = mHandlesByHash.find(contentHash);
+	if(it != mHandlesByHash.end() && mEntries[it->second].ByteSize == image.BitSize)
+	{
+		handle = it->second;
+		++mEntries[handle].RefCount;
+
+		++mStats.HandleCount;
+		++mStats.DuplicateCount;
+		mStats.BytesSaved += image.BitSize;
+
+		return S_OK;
+	}
+
+	Entry e;
+	HRESULT hr = DirectX::CreateDDSTextureFromImage12(device, cmdList, image, e.Resource, e.UploadHeap);
+	if(FAILED(hr))
+		return hr;
+
+	d3dUtil::TrackResource(e.Resource.Get(), MemoryTag::Textures);
+	d3dUtil::TrackResource(e.UploadHeap.Get(), MemoryTag::Upload);
+
+	e.ContentHash = contentHash;
+	e.ByteSize = image.BitSize;
+	e.RefCount = 1;
+
+	if(!mFreeHandles.empty())
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+		mEntries[handle] = std::move(e);
+	}
+	else
+	{
+		handle = (Handle)mEntries.size();
+		mEntries.push_back(std::move(e));
+	}
+
+	// On the unlikely hash collision the newer texture simply is not shared.
+	mHandlesByHash.emplace(contentHash, handle);
+
+	++mStats.TextureCount;
+	++mStats.HandleCount;
+	mStats.BytesUploaded += image.BitSize;
+
+	return S_OK;
+}
+
+HRESULT TextureCache::AcquireFile(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+	const std::wstring& filename, Handle& handle)
+{
+	handle = InvalidHandle;
+
+	DDSImage image;
+	HRESULT hr = ParseResultToHRESULT(KTXParser::ParseTextureFile(filename, image));
+	if(FAILED(hr))
+		return hr;
+
+	return Acquire(device, cmdList, image, HashContents(image), handle);
+}
+
+void TextureCache::AddRef(Handle handle)
+{
+	assert(mEntries[handle].RefCount > 0);
+
+	++mEntries[handle].RefCount;
+	++mStats.HandleCount;
+}
+
+void TextureCache::Release(Handle handle)
+{
+	Entry& e = mEntries[handle];
+	assert(e.RefCount > 0);
+
+	--mStats.HandleCount;
+	if(--e.RefCount > 0)
+		return;
+
+	auto it = mHandlesByHash.find(e.ContentHash);
+	if(it != mHandlesByHash.end() && it->second == handle)
+		mHandlesByHash.erase(it);
+
+	e = Entry();
+	mFreeHandles.push_back(handle);
+	--mStats.TextureCount;
+}
+
+void TextureCache::ReleaseAfter(Handle handle, UINT64 fenceValue)
+{
+	assert(mEntries[handle].RefCount > 0);
+
+	DeferredRelease r;
+	r.Texture = handle;
+	r.Fence = fenceValue;
+	mDeferredReleases.push_back(r);
+}
+
+void TextureCache::ReleaseCompleted(UINT64 completedFence)
+{
+	// Release() only recycles handles, so the list can be walked while releasing.
+	size_t kept = 0;
+	for(size_t i = 0; i < mDeferredReleases.size(); ++i)
+	{
+		if(mDeferredReleases[i].Fence <= completedFence)
+			Release(mDeferredReleases[i].Texture);
+		else
+			mDeferredReleases[kept++] = mDeferredReleases[i];
+	}
+	mDeferredReleases.resize(kept);
+}
+
+ID3D12Resource* TextureCache::GetResource(Handle handle)const
+{
+	return mEntries[handle].Resource.Get();
+}
+
+ID3D12Resource* TextureCache::GetUploadHeap(Handle handle)const
+{
+	return mEntries[handle].UploadHeap.Get();
+}
+
+const TextureCache::Stats& TextureCache::GetStats()const
+{
+	return mStats;
+}
+
+void TextureCache::Clear()
+{
+	mEntries.clear();
+	mFreeHandles.clear();
+	mHandlesByHash.clear();
+	mDeferredReleases.clear();
+
+	mStats.TextureCount = 0;
+	mStats.HandleCount = 0;
+}
+
+HRESULT TextureCache::ParseResultToHRESULT(DDSParser::Result result)
+{
+	switch(result)
+	{
+	case DDSParser::Result::Ok:
+		return S_OK;
+	case DDSParser::Result::FileNotFound:
+		return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+	case DDSParser::Result::NotSupported:
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	case DDSParser::Result::EndOfFile:
+		return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+	default:
+		return E_FAIL;
+	}
+}
+
+std::uint64_t TextureCache::HashContents(const DDSImage& image)
+{
+	// The format and dimensions count as much as the data.  They are hashed instead of
+	// the headers, which images built in memory do not have.
+	const std::uint64_t description[] =
+	{
+		(std::uint64_t)image.Dimension, (std::uint64_t)image.Format,
+		image.Width, image.Height, image.Depth, image.MipCount, image.ArraySize,
+		(std::uint64_t)image.IsCubeMap
+	};
+
+	return HashBytes(image.BitData, image.BitSize, HashBytes(description, sizeof(description)));
+}
+
+std::uint64_t TextureCache::HashBytes(const void* data, std::size_t byteSize, std::uint64_t seed)
+{
+	const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+	const std::uint8_t* end = p + byteSize;
+
+	std::uint64_t h;
+	if(byteSize >= 32)
+	{
+		std::uint64_t v1 = seed + Prime1 + Prime2;
+		std::uint64_t v2 = seed + Prime2;
+		std::uint64_t v3 = seed;
+		std::uint64_t v4 = seed - Prime1;
+
+		const std::uint8_t* limit = end - 32;
+		do
+		{
+			v1 = Round(v1, Read64(p));
+			v2 = Round(v2, Read64(p + 8));
+			v3 = Round(v3, Read64(p + 16));
+			v4 = Round(v4, Read64(p + 24));
+			p += 32;
+		} while(p <= limit);
+
+		h = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+		h = MergeRound(h, v1);
+		h = MergeRound(h, v2);
+		h = MergeRound(h, v3);
+		h = MergeRound(h, v4);
+	}
+	else
+	{
+		h = seed + Prime5;
+	}
+
+	h += (std::uint64_t)byteSize;
+
+	for(; p + 8 <= end; p += 8)
+	{
+		h ^= Round(0, Read64(p));
+		h = RotateLeft(h, 27) * Prime1 + Prime4;
+	}
+
+	if(p + 4 <= end)
+	{
+		h ^= (std::uint64_t)Read32(p) * Prime1;
+		h = RotateLeft(h, 23) * Prime2 + Prime3;
+		p += 4;
+	}
+
+	for(; p < end; ++p)
+	{
+		h ^= (*p) * Prime5;
+		h = RotateLeft(h, 11) * Prime1;
+	}
+
+	h ^= h >> 33;
+	h *= Prime2;
+	h ^= h >> 29;
+	h *= Prime3;
+	h ^= h >> 32;
+
+	return h;
+}
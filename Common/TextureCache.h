@@ -0,0 +1,115 @@
+//***************************************************************************************
+// TextureCache.h
+//
+// Cache of DDS textures keyed by a hash of the file contents, so a texture loaded under
+// several names or from several byte-identical files is created on the GPU only once.
+// Textures are referred to by integer handles with a reference count; a texture is
+// released when its last handle is.
+//
+// The app owns the cache and destroys it, like its other resources, once the GPU is
+// idle.  It is not thread-safe: use it from the thread recording the command list.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "DDSParser.h"
+
+class TextureCache
+{
+public:
+	typedef std::uint32_t Handle;
+	static const Handle InvalidHandle = 0xffffffff;
+
+	struct Stats
+	{
+		std::uint32_t TextureCount = 0;
+		std::uint32_t HandleCount = 0;
+
+		// Acquires served by a texture that was already in the cache.
+		std::uint32_t DuplicateCount = 0;
+
+		// Texel bytes uploaded, and texel bytes the duplicates did not upload.
+		std::uint64_t BytesUploaded = 0;
+		std::uint64_t BytesSaved = 0;
+	};
+
+	TextureCache() = default;
+	TextureCache(const TextureCache& rhs) = delete;
+	TextureCache& operator=(const TextureCache& rhs) = delete;
+
+	///<summary>
+	/// Returns a handle to the texture with the contents of image, creating it and
+	/// recording its upload on cmdList if the cache does not hold it yet.  contentHash
+	/// must be HashContents(image); it is a parameter so it can be computed on another
+	/// thread.
+	///</summary>
+	HRESULT Acquire(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+		const DDSImage& image, std::uint64_t contentHash, Handle& handle);
+
+	// Parses (see KTXParser::ParseTextureFile) and hashes the file, then acquires it as above.
+	HRESULT AcquireFile(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+		const std::wstring& filename, Handle& handle);
+
+	void AddRef(Handle handle);
+
+	///<summary>
+	/// Drops one reference.  The last one releases the texture, so the GPU must be done
+	/// with it.
+	///</summary>
+	void Release(Handle handle);
+
+	// Drops one reference once the fence reaches fenceValue (see ReleaseCompleted).
+	void ReleaseAfter(Handle handle, UINT64 fenceValue);
+
+	// Drops the references passed to ReleaseAfter() with a fence value at most completedFence.
+	void ReleaseCompleted(UINT64 completedFence);
+
+	ID3D12Resource* GetResource(Handle handle)const;
+
+	// Upload heap of the texture's initial copy; kept until the texture is released.
+	ID3D12Resource* GetUploadHeap(Handle handle)const;
+
+	const Stats& GetStats()const;
+
+	// Releases every texture regardless of the reference counts.  The GPU must be idle.
+	void Clear();
+
+	///<summary>
+	/// 64-bit hash of the format, dimensions and texel data of image.  Reads eight
+	/// bytes per step in four independent lanes (the xxHash64 algorithm), several times
+	/// faster than a byte-wise hash on texture sized inputs.
+	///</summary>
+	static std::uint64_t HashContents(const DDSImage& image);
+
+	// xxHash64 of a byte range.
+	static std::uint64_t HashBytes(const void* data, std::size_t byteSize, std::uint64_t seed = 0);
+
+	// The HRESULT the DDS loader returns for a parser error.
+	static HRESULT ParseResultToHRESULT(DDSParser::Result result);
+
+private:
+	struct Entry
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
+		Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap = nullptr;
+
+		std::uint64_t ContentHash = 0;
+		std::uint64_t ByteSize = 0;
+		std::uint32_t RefCount = 0;
+	};
+
+	struct DeferredRelease
+	{
+		Handle Texture = InvalidHandle;
+		UINT64 Fence = 0;
+	};
+
+private:
+	std::vector<Entry> mEntries;
+	std::vector<Handle> mFreeHandles;
+	std::unordered_map<std::uint64_t, Handle> mHandlesByHash;
+	std::vector<DeferredRelease> mDeferredReleases;
+
+	Stats mStats;
+};
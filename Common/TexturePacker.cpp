@@ -0,0 +1,334 @@
+//***************************************************************************************
+// TexturePacker.cpp
+//***************************************************************************************
+
+#include "TexturePacker.h"
+#include "FileUtil.h"
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+using namespace DirectX;
+
+namespace
+{
+	// Atlas regions start on block boundaries so BC compression keeps images apart.
+	const std::uint32_t RegionAlignment = 4;
+
+	std::uint32_t AlignUp(std::uint32_t value, std::uint32_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	std::uint32_t NextPowerOfTwo(std::uint32_t value)
+	{
+		std::uint32_t result = 1;
+		while(result < value)
+			result *= 2;
+		return result;
+	}
+
+	// Places the padded rectangles in shelves: rows as tall as their first (tallest)
+	// rectangle, filled left to right.  order is sorted by decreasing height.  Returns
+	// the height used, or 0 if a rectangle is wider than the atlas.
+	std::uint32_t PackShelves(const std::vector<std::uint32_t>& widths, const std::vector<std::uint32_t>& heights,
+		const std::vector<std::size_t>& order, std::uint32_t atlasWidth,
+		std::vector<std::uint32_t>& x, std::vector<std::uint32_t>& y)
+	{
+		std::uint32_t shelfX = 0;
+		std::uint32_t shelfY = 0;
+		std::uint32_t shelfHeight = 0;
+
+		for(std::size_t i : order)
+		{
+			if(widths[i] > atlasWidth)
+				return 0;
+
+			if(shelfX + widths[i] > atlasWidth)
+			{
+				shelfY += shelfHeight;
+				shelfX = 0;
+				shelfHeight = 0;
+			}
+
+			x[i] = shelfX;
+			y[i] = shelfY;
+			shelfX += widths[i];
+			shelfHeight = std::max<std::uint32_t>(shelfHeight, heights[i]);
+		}
+
+		return shelfY + shelfHeight;
+	}
+
+	void SetRegionUV(AtlasRegion& region, std::uint32_t atlasWidth, std::uint32_t atlasHeight)
+	{
+		region.Scale = XMFLOAT2((float)region.Width / atlasWidth, (float)region.Height / atlasHeight);
+		region.Offset = XMFLOAT2((float)region.X / atlasWidth, (float)region.Y / atlasHeight);
+	}
+}
+
+XMFLOAT4X4 AtlasRegion::GetTexTransform()const
+{
+	XMFLOAT4X4 transform;
+	XMStoreFloat4x4(&transform,
+		XMMatrixScaling(Scale.x, Scale.y, 1.0f) * XMMatrixTranslation(Offset.x, Offset.y, 0.0f));
+	return transform;
+}
+
+bool TexturePacker::BuildArray(const std::vector<const DDSImage*>& images, DDSImage& result)
+{
+	if(images.empty())
+		return false;
+
+	const DDSImage& first = *images[0];
+	std::size_t mipCount = first.MipCount;
+	std::size_t arraySize = 0;
+	std::size_t byteSize = 0;
+
+	for(const DDSImage* image : images)
+	{
+		if(image->Dimension != DDS_DIMENSION_TEXTURE2D || image->IsCubeMap ||
+			image->Format != first.Format || image->Width != first.Width || image->Height != first.Height)
+			return false;
+
+		mipCount = std::min<std::size_t>(mipCount, image->MipCount);
+		arraySize += image->ArraySize;
+	}
+
+	for(std::size_t mip = 0; mip < mipCount; ++mip)
+		byteSize += first.Subresources[mip].SlicePitch;
+	byteSize *= arraySize;
+
+	auto memory = std::make_shared<std::vector<std::uint8_t>>(byteSize);
+
+	DDSImage array;
+	array.Dimension = DDS_DIMENSION_TEXTURE2D;
+	array.Format = first.Format;
+	array.Width = first.Width;
+	array.Height = first.Height;
+	array.Depth = 1;
+	array.MipCount = mipCount;
+	array.ArraySize = arraySize;
+	array.BitData = memory->data();
+	array.BitSize = memory->size();
+	array.Subresources.reserve(arraySize*mipCount);
+
+	// Every slice keeps its own layout, which is the same for all images of one format
+	// and size; only the leading mips are copied when the images differ in mip count.
+	std::uint8_t* dst = memory->data();
+	for(const DDSImage* image : images)
+	{
+		for(std::size_t slice = 0; slice < image->ArraySize; ++slice)
+		{
+			for(std::size_t mip = 0; mip < mipCount; ++mip)
+			{
+				DDSSubresource sub = image->Subresources[slice*image->MipCount + mip];
+				std::memcpy(dst, sub.Data, sub.SlicePitch);
+
+				sub.Data = dst;
+				dst += sub.SlicePitch;
+				array.Subresources.push_back(sub);
+			}
+		}
+	}
+
+	array.Memory = memory;
+	result = std::move(array);
+
+	return true;
+}
+
+bool TexturePacker::BuildAtlas(const std::vector<const DDSImage*>& images, const AtlasOptions& options,
+	DDSImage& result, std::vector<AtlasRegion>& regions)
+{
+	if(images.empty() || !MipGenerator::IsSupported(images[0]->Format))
+		return false;
+
+	const DXGI_FORMAT format = images[0]->Format;
+	const std::size_t texelSize = DDSParser::BitsPerPixel(format) / 8;
+	const std::uint32_t padding = AlignUp(options.Padding, RegionAlignment);
+
+	// Padded rectangle of every image.
+	std::vector<std::uint32_t> widths(images.size());
+	std::vector<std::uint32_t> heights(images.size());
+	std::uint32_t widest = 0;
+
+	for(std::size_t i = 0; i < images.size(); ++i)
+	{
+		const DDSImage& image = *images[i];
+		if(image.Dimension != DDS_DIMENSION_TEXTURE2D || image.ArraySize != 1 || image.Format != format)
+			return false;
+
+		widths[i] = 2*padding + AlignUp((std::uint32_t)image.Width, RegionAlignment);
+		heights[i] = 2*padding + AlignUp((std::uint32_t)image.Height, RegionAlignment);
+		widest = std::max<std::uint32_t>(widest, widths[i]);
+	}
+
+	std::vector<std::size_t> order(images.size());
+	for(std::size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(),
+		[&heights](std::size_t a, std::size_t b) { return heights[a] > heights[b]; });
+
+	// Try every power of two width that can hold the widest image and keep the smallest
+	// atlas, preferring the squarer one on ties.
+	std::uint32_t atlasWidth = 0;
+	std::uint32_t atlasHeight = 0;
+	std::vector<std::uint32_t> x(images.size()), y(images.size());
+	std::vector<std::uint32_t> tryX(images.size()), tryY(images.size());
+
+	for(std::uint32_t width = NextPowerOfTwo(widest); width <= options.MaxSize; width *= 2)
+	{
+		const std::uint32_t used = PackShelves(widths, heights, order, width, tryX, tryY);
+		const std::uint32_t height = NextPowerOfTwo(used);
+		if(used == 0 || height > options.MaxSize)
+			continue;
+
+		const std::uint64_t tryArea = (std::uint64_t)width*height;
+		const std::uint64_t bestArea = (std::uint64_t)atlasWidth*atlasHeight;
+		if(atlasWidth == 0 || tryArea < bestArea ||
+			(tryArea == bestArea && std::max<std::uint32_t>(width, height) < std::max<std::uint32_t>(atlasWidth, atlasHeight)))
+		{
+			atlasWidth = width;
+			atlasHeight = height;
+			x.swap(tryX);
+			y.swap(tryY);
+		}
+
+		// Once everything fits on one shelf, wider atlases only grow.
+		if(used == heights[order[0]])
+			break;
+	}
+
+	if(atlasWidth == 0)
+		return false;
+
+	DDSSubresource top;
+	top.Width = atlasWidth;
+	top.Height = atlasHeight;
+	top.Depth = 1;
+	top.RowPitch = atlasWidth*texelSize;
+	top.SlicePitch = top.RowPitch*atlasHeight;
+	top.NumRows = atlasHeight;
+
+	auto memory = std::make_shared<std::vector<std::uint8_t>>(top.SlicePitch);
+	top.Data = memory->data();
+
+	regions.assign(images.size(), AtlasRegion());
+
+	for(std::size_t i = 0; i < images.size(); ++i)
+	{
+		const DDSSubresource& src = images[i]->Subresources[0];
+		const std::uint32_t imageWidth = (std::uint32_t)src.Width;
+		const std::uint32_t imageHeight = (std::uint32_t)src.Height;
+
+		AtlasRegion& region = regions[i];
+		region.X = x[i] + padding;
+		region.Y = y[i] + padding;
+		region.Width = imageWidth;
+		region.Height = imageHeight;
+		SetRegionUV(region, atlasWidth, atlasHeight);
+
+		// Copy the whole padded rectangle, clamping into the image, so the gutter repeats
+		// the edge texels.
+		for(std::uint32_t row = y[i]; row < y[i] + heights[i]; ++row)
+		{
+			const std::uint32_t srcY = (std::uint32_t)std::min<std::int64_t>(
+				std::max<std::int64_t>((std::int64_t)row - region.Y, 0), imageHeight - 1);
+			const std::uint8_t* srcRow = src.Data + srcY*src.RowPitch;
+			std::uint8_t* dstRow = memory->data() + row*top.RowPitch;
+
+			for(std::uint32_t col = x[i]; col < x[i] + widths[i]; ++col)
+			{
+				const std::uint32_t srcX = (std::uint32_t)std::min<std::int64_t>(
+					std::max<std::int64_t>((std::int64_t)col - region.X, 0), imageWidth - 1);
+				std::memcpy(dstRow + col*texelSize, srcRow + srcX*texelSize, texelSize);
+			}
+		}
+	}
+
+	DDSImage atlas;
+	atlas.Dimension = DDS_DIMENSION_TEXTURE2D;
+	atlas.Format = format;
+	atlas.Width = atlasWidth;
+	atlas.Height = atlasHeight;
+	atlas.Depth = 1;
+	atlas.MipCount = 1;
+	atlas.ArraySize = 1;
+	atlas.BitData = memory->data();
+	atlas.BitSize = memory->size();
+	atlas.Subresources.push_back(top);
+	atlas.Memory = memory;
+
+	if(options.MipCount == 1)
+	{
+		result = std::move(atlas);
+		return true;
+	}
+
+	// Mips are filtered across the whole atlas, so below the level where the padding
+	// shrinks to nothing neighbouring images start to bleed into each other.
+	MipGenerator::Options mipOptions;
+	mipOptions.MipCount = options.MipCount;
+	return MipGenerator::Generate(atlas, result, mipOptions);
+}
+
+bool TexturePacker::BuildAtlas(const std::vector<const DDSImage*>& images,
+	DDSImage& result, std::vector<AtlasRegion>& regions)
+{
+	return BuildAtlas(images, AtlasOptions(), result, regions);
+}
+
+bool TexturePacker::SaveAtlasTable(const std::wstring& filename, std::uint32_t atlasWidth, std::uint32_t atlasHeight,
+	const std::vector<AtlasRegion>& regions)
+{
+	std::ostringstream fout;
+	fout << "atlas " << atlasWidth << " " << atlasHeight << "\n";
+	for(const AtlasRegion& region : regions)
+		fout << region.Name << " " << region.X << " " << region.Y << " " << region.Width << " " << region.Height << "\n";
+
+	const std::string text = fout.str();
+	return FileUtil::WriteFile(filename, text.data(), text.size());
+}
+
+bool TexturePacker::LoadAtlasTable(const std::wstring& filename, std::vector<AtlasRegion>& regions)
+{
+	regions.clear();
+
+	std::string text;
+	if(!FileUtil::ReadFile(filename, text))
+		return false;
+
+	// Read in binary; a table saved with CR LF line ends still parses, as the fields
+	// are separated by white space.
+	std::istringstream fin(text);
+
+	std::string tag;
+	std::uint32_t atlasWidth = 0;
+	std::uint32_t atlasHeight = 0;
+	if(!(fin >> tag >> atlasWidth >> atlasHeight) || tag != "atlas" || atlasWidth == 0 || atlasHeight == 0)
+		return false;
+
+	std::string line;
+	std::getline(fin, line);
+	while(std::getline(fin, line))
+	{
+		std::istringstream lineIn(line);
+		AtlasRegion region;
+		if(!(lineIn >> region.Name))
+			continue;
+
+		if(!(lineIn >> region.X >> region.Y >> region.Width >> region.Height) ||
+			region.X + region.Width > atlasWidth || region.Y + region.Height > atlasHeight)
+		{
+			regions.clear();
+			return false;
+		}
+
+		SetRegionUV(region, atlasWidth, atlasHeight);
+		regions.push_back(region);
+	}
+
+	return true;
+}
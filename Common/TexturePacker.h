@@ -0,0 +1,79 @@
+//***************************************************************************************
+// TexturePacker.h
+//
+// Combines a set of images into one texture so the whole set binds with a single SRV:
+// either stacked as the slices of a Texture2DArray, for same sized images such as the
+// frames of an animation, or packed side by side into an atlas with a table that maps
+// each image's texture coordinates into its region.
+//
+// Like DDSParser, nothing here touches Direct3D.  The TexturePacker tool writes the
+// results to disk, and TextureBatchLoader builds arrays from separate files at load time.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+#include <DirectXMath.h>
+
+struct AtlasRegion
+{
+	std::string Name;
+
+	// Placement in the top mip of the atlas, in texels.
+	std::uint32_t X = 0;
+	std::uint32_t Y = 0;
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+
+	// Maps the image's [0,1] texture coordinates into the region: uv*Scale + Offset.
+	DirectX::XMFLOAT2 Scale = { 1.0f, 1.0f };
+	DirectX::XMFLOAT2 Offset = { 0.0f, 0.0f };
+
+	// The mapping above as a texture transform, for Material::MatTransform.  Wrap
+	// addressing would leave the region, so tiling textures do not belong in an atlas.
+	DirectX::XMFLOAT4X4 GetTexTransform()const;
+};
+
+class TexturePacker
+{
+public:
+	struct AtlasOptions
+	{
+		// Texels of repeated edge color around every image, so that filtering and the
+		// first few mips do not pull in the neighbors.  Rounded up to a multiple of four.
+		std::uint32_t Padding = 4;
+
+		// Largest width or height of the atlas.
+		std::uint32_t MaxSize = 8192;
+
+		// Mips built for the atlas, 0 for a full chain.
+		std::uint32_t MipCount = 0;
+	};
+
+	///<summary>
+	/// Stacks the slices of images, which must share format and size, into one texture
+	/// array.  Any format works, block compressed included.  The array keeps the mips
+	/// all images have.  Returns false for differing images, 3D textures and cube maps.
+	///</summary>
+	static bool BuildArray(const std::vector<const DDSImage*>& images, DDSImage& result);
+
+	///<summary>
+	/// Packs the top mips of images, which must share an uncompressed format MipGenerator
+	/// handles, into rows of a power of two sized atlas, then builds its mips.  Regions
+	/// start on multiples of four texels, so the atlas can be block compressed by the
+	/// texture cooker without blocks straddling two images.  regions[i] is the region
+	/// of images[i], with an empty name.  Returns false if the images do not fit.
+	///</summary>
+	static bool BuildAtlas(const std::vector<const DDSImage*>& images, const AtlasOptions& options,
+		DDSImage& result, std::vector<AtlasRegion>& regions);
+	static bool BuildAtlas(const std::vector<const DDSImage*>& images,
+		DDSImage& result, std::vector<AtlasRegion>& regions);
+
+	///<summary>
+	/// Text table with the atlas size and one "name x y width height" line per region.
+	/// Region names must not contain white space.
+	///</summary>
+	static bool SaveAtlasTable(const std::wstring& filename, std::uint32_t atlasWidth, std::uint32_t atlasHeight,
+		const std::vector<AtlasRegion>& regions);
+	static bool LoadAtlasTable(const std::wstring& filename, std::vector<AtlasRegion>& regions);
+};
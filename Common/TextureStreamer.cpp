@@ -0,0 +1,311 @@
+//***************************************************************************************
+// TextureStreamer.cpp
+//***************************************************************************************
+
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+const std::uint32_t CpuTextureStreamBackend::NotResident;
+const std::uint32_t TextureStreamer::InvalidHandle;
+
+bool CpuTextureStreamBackend::MakeResident(std::uint32_t id, const DDSImage& image, std::uint32_t firstMip)
+{
+	if(mFailUploads)
+		return false;
+
+	if(id >= mFirstMips.size())
+		mFirstMips.resize(id + 1, NotResident);
+
+	mFirstMips[id] = firstMip;
+	mUploadedBytes += TextureStreamer::GetMipChainBytes(image, firstMip);
+	++mChangeCount;
+
+	return true;
+}
+
+std::uint32_t CpuTextureStreamBackend::GetFirstMip(std::uint32_t id)const
+{
+	return id < mFirstMips.size() ? mFirstMips[id] : NotResident;
+}
+
+std::uint64_t CpuTextureStreamBackend::GetUploadedBytes()const
+{
+	return mUploadedBytes;
+}
+
+std::uint32_t CpuTextureStreamBackend::GetChangeCount()const
+{
+	return mChangeCount;
+}
+
+void CpuTextureStreamBackend::SetFailUploads(bool fail)
+{
+	mFailUploads = fail;
+}
+
+TextureStreamer::TextureStreamer(TextureStreamBackend& backend, std::uint64_t budgetBytes, std::size_t mipTailSize)
+	: mBackend(backend), mBudget(budgetBytes), mMipTailSize(mipTailSize)
+{
+}
+
+std::uint32_t TextureStreamer::Add(const std::wstring& filename)
+{
+	DDSImage image;
+	if(DDSParser::ParseFile(filename, image) != DDSParser::Result::Ok)
+		return InvalidHandle;
+
+	return Add(std::move(image));
+}
+
+std::uint32_t TextureStreamer::Add(DDSImage&& image)
+{
+	if(image.MipCount == 0 || image.Subresources.size() != image.MipCount*image.ArraySize)
+		return InvalidHandle;
+
+	const std::uint32_t id = (std::uint32_t)mTextures.size();
+	const std::uint32_t mipCount = (std::uint32_t)image.MipCount;
+
+	Entry e;
+	e.Image = std::move(image);
+
+	// The tail starts at the first mip that fits in a MipTailSize square (or cube).
+	e.TailMip = mipCount - 1;
+	for(std::uint32_t i = 0; i < mipCount; ++i)
+	{
+		const DDSSubresource& sub = e.Image.Subresources[i];
+		if(sub.Width <= mMipTailSize && sub.Height <= mMipTailSize && sub.Depth <= mMipTailSize)
+		{
+			e.TailMip = i;
+			break;
+		}
+	}
+
+	e.ChainBytes.resize(mipCount + 1, 0);
+	for(std::uint32_t i = 0; i < mipCount; ++i)
+		e.ChainBytes[i] = GetMipChainBytes(e.Image, i);
+
+	// Nothing is resident until the backend has the tail.
+	e.ResidentMip = mipCount;
+	e.RequestedMip = e.TailMip;
+
+	mTextures.push_back(std::move(e));
+	if(!SetResidentMip(id, mTextures[id].TailMip))
+	{
+		mTextures.pop_back();
+		return InvalidHandle;
+	}
+
+	return id;
+}
+
+void TextureStreamer::RequestMip(std::uint32_t texture, std::uint32_t mip)
+{
+	Entry& e = mTextures[texture];
+	mip = std::min<std::uint32_t>(mip, e.TailMip);
+
+	// A texture drawn several times in a frame gets the finest mip any draw asked for.
+	if(e.LastRequestFrame == mFrame)
+		e.RequestedMip = std::min<std::uint32_t>(e.RequestedMip, mip);
+	else
+		e.RequestedMip = mip;
+
+	e.LastRequestFrame = mFrame;
+}
+
+std::uint32_t TextureStreamer::SelectMip(std::uint32_t texture, float pixels)const
+{
+	const DDSImage& image = mTextures[texture].Image;
+	const std::uint32_t lastMip = (std::uint32_t)image.MipCount - 1;
+
+	if(pixels <= 0.0f)
+		return lastMip;
+
+	// Mip i is (size >> i) texels wide; take the finest one not more than twice as
+	// wide as the area it is drawn to.
+	const float size = (float)std::max<std::size_t>(image.Width, image.Height);
+	const float mip = floorf(log2f(size / pixels));
+
+	if(mip <= 0.0f)
+		return 0;
+
+	return std::min<std::uint32_t>((std::uint32_t)mip, lastMip);
+}
+
+void TextureStreamer::Update()
+{
+	std::vector<std::uint32_t> wanted;
+	for(std::uint32_t i = 0; i < (std::uint32_t)mTextures.size(); ++i)
+	{
+		const Entry& e = mTextures[i];
+		if(e.LastRequestFrame == mFrame && e.RequestedMip < e.ResidentMip)
+			wanted.push_back(i);
+	}
+
+	// Most mips missing first; ties by handle so the order does not depend on the sort.
+	std::sort(wanted.begin(), wanted.end(), [this](std::uint32_t a, std::uint32_t b)
+	{
+		const Entry& ea = mTextures[a];
+		const Entry& eb = mTextures[b];
+		const std::uint32_t missingA = ea.ResidentMip - ea.RequestedMip;
+		const std::uint32_t missingB = eb.ResidentMip - eb.RequestedMip;
+
+		return missingA != missingB ? missingA > missingB : a < b;
+	});
+
+	std::uint64_t uploaded = 0;
+	for(std::uint32_t id : wanted)
+	{
+		const Entry& e = mTextures[id];
+		const std::uint64_t residentBytes = e.ChainBytes[e.ResidentMip];
+
+		std::uint64_t available = GetReclaimableBytes(id);
+		if(mBudget > mResidentBytes)
+			available += mBudget - mResidentBytes;
+
+		// Finest mip that fits both the budget and what is left of this update's uploads.
+		std::uint32_t mip = e.RequestedMip;
+		for(; mip < e.ResidentMip; ++mip)
+		{
+			const std::uint64_t bytes = e.ChainBytes[mip];
+			const bool fitsBudget = bytes - residentBytes <= available;
+			const bool fitsUpload = mUpdateUploadLimit == 0 || uploaded == 0 ||
+				uploaded + bytes <= mUpdateUploadLimit;
+
+			if(fitsBudget && fitsUpload)
+				break;
+		}
+
+		if(mip == e.ResidentMip)
+			continue;
+
+		const std::uint64_t bytes = e.ChainBytes[mip];
+		if(MakeRoom(bytes - residentBytes, id) && SetResidentMip(id, mip))
+			uploaded += bytes;
+	}
+
+	++mFrame;
+}
+
+std::uint64_t TextureStreamer::GetBudget()const
+{
+	return mBudget;
+}
+
+void TextureStreamer::SetBudget(std::uint64_t budgetBytes)
+{
+	mBudget = budgetBytes;
+}
+
+std::uint64_t TextureStreamer::GetUpdateUploadLimit()const
+{
+	return mUpdateUploadLimit;
+}
+
+void TextureStreamer::SetUpdateUploadLimit(std::uint64_t bytes)
+{
+	mUpdateUploadLimit = bytes;
+}
+
+std::uint64_t TextureStreamer::GetResidentBytes()const
+{
+	return mResidentBytes;
+}
+
+std::uint32_t TextureStreamer::GetTextureCount()const
+{
+	return (std::uint32_t)mTextures.size();
+}
+
+std::uint32_t TextureStreamer::GetMipCount(std::uint32_t texture)const
+{
+	return (std::uint32_t)mTextures[texture].Image.MipCount;
+}
+
+std::uint32_t TextureStreamer::GetResidentMip(std::uint32_t texture)const
+{
+	return mTextures[texture].ResidentMip;
+}
+
+std::uint32_t TextureStreamer::GetTailMip(std::uint32_t texture)const
+{
+	return mTextures[texture].TailMip;
+}
+
+const DDSImage& TextureStreamer::GetImage(std::uint32_t texture)const
+{
+	return mTextures[texture].Image;
+}
+
+std::uint64_t TextureStreamer::GetMipChainBytes(const DDSImage& image, std::uint32_t firstMip)
+{
+	std::uint64_t bytes = 0;
+	for(std::size_t j = 0; j < image.ArraySize; ++j)
+	{
+		for(std::size_t i = firstMip; i < image.MipCount; ++i)
+		{
+			const DDSSubresource& sub = image.Subresources[j*image.MipCount + i];
+			bytes += (std::uint64_t)sub.SlicePitch * sub.Depth;
+		}
+	}
+
+	return bytes;
+}
+
+std::uint32_t TextureStreamer::GetEvictionFloor(const Entry& e)const
+{
+	return e.LastRequestFrame == mFrame ? e.RequestedMip : e.TailMip;
+}
+
+std::uint64_t TextureStreamer::GetReclaimableBytes(std::uint32_t except)const
+{
+	std::uint64_t bytes = 0;
+	for(std::uint32_t i = 0; i < (std::uint32_t)mTextures.size(); ++i)
+	{
+		const Entry& e = mTextures[i];
+		const std::uint32_t floorMip = GetEvictionFloor(e);
+
+		if(i != except && floorMip > e.ResidentMip)
+			bytes += e.ChainBytes[e.ResidentMip] - e.ChainBytes[floorMip];
+	}
+
+	return bytes;
+}
+
+bool TextureStreamer::MakeRoom(std::uint64_t bytes, std::uint32_t except)
+{
+	while(mResidentBytes + bytes > mBudget)
+	{
+		// Least recently requested texture that holds more than its floor.
+		std::uint32_t victim = InvalidHandle;
+		for(std::uint32_t i = 0; i < (std::uint32_t)mTextures.size(); ++i)
+		{
+			const Entry& e = mTextures[i];
+			if(i == except || GetEvictionFloor(e) <= e.ResidentMip)
+				continue;
+
+			if(victim == InvalidHandle || e.LastRequestFrame < mTextures[victim].LastRequestFrame)
+				victim = i;
+		}
+
+		if(victim == InvalidHandle || !SetResidentMip(victim, GetEvictionFloor(mTextures[victim])))
+			return false;
+	}
+
+	return true;
+}
+
+bool TextureStreamer::SetResidentMip(std::uint32_t texture, std::uint32_t mip)
+{
+	Entry& e = mTextures[texture];
+	assert(mip < e.Image.MipCount);
+
+	if(!mBackend.MakeResident(texture, e.Image, mip))
+		return false;
+
+	mResidentBytes = mResidentBytes + e.ChainBytes[mip] - e.ChainBytes[e.ResidentMip];
+	e.ResidentMip = mip;
+
+	return true;
+}
@@ -0,0 +1,157 @@
+//***************************************************************************************
+// TextureStreamer.h
+//
+// Streams the mip levels of DDS textures under a global memory budget.  A texture is
+// added with only its mip tail (the mips no larger than MipTailSize) resident, so startup
+// never waits for full resolution textures.  Every frame the application requests the
+// finest mip it needs for each texture it draws; Update() then pages in finer mips, as
+// far as the budget allows, and takes memory back from the least recently requested
+// textures.  Mip tails are never evicted.
+//
+// The streamer only makes residency decisions.  Creating the actual copies is left to
+// a TextureStreamBackend: TextureStreamerD3D12 for the demos, CpuTextureStreamBackend
+// to check the decisions without a device.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TextureStreamBackend
+{
+public:
+	virtual ~TextureStreamBackend() = default;
+
+	///<summary>
+	/// Replaces the copy of texture id with one holding mips [firstMip, image.MipCount)
+	/// of every slice.  Returns false if the new copy could not be created; the old one
+	/// then stays in use.
+	///</summary>
+	virtual bool MakeResident(std::uint32_t id, const DDSImage& image, std::uint32_t firstMip) = 0;
+};
+
+// Remembers the residency changes instead of creating textures.
+class CpuTextureStreamBackend : public TextureStreamBackend
+{
+public:
+	static const std::uint32_t NotResident = 0xffffffff;
+
+	virtual bool MakeResident(std::uint32_t id, const DDSImage& image, std::uint32_t firstMip)override;
+
+	// First resident mip of texture id, or NotResident.
+	std::uint32_t GetFirstMip(std::uint32_t id)const;
+
+	// Total bytes that would have been uploaded, and the number of MakeResident calls.
+	std::uint64_t GetUploadedBytes()const;
+	std::uint32_t GetChangeCount()const;
+
+	// Makes MakeResident fail, as if the device were out of memory.
+	void SetFailUploads(bool fail);
+
+private:
+	std::vector<std::uint32_t> mFirstMips;
+	std::uint64_t mUploadedBytes = 0;
+	std::uint32_t mChangeCount = 0;
+	bool mFailUploads = false;
+};
+
+class TextureStreamer
+{
+public:
+	static const std::uint32_t InvalidHandle = 0xffffffff;
+
+	TextureStreamer(TextureStreamBackend& backend, std::uint64_t budgetBytes, std::size_t mipTailSize = 64);
+	TextureStreamer(const TextureStreamer& rhs) = delete;
+	TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+
+	///<summary>
+	/// Parses the file and makes its mip tail resident.  Returns the handle of the
+	/// texture, or InvalidHandle if the file cannot be parsed or uploaded.
+	///</summary>
+	std::uint32_t Add(const std::wstring& filename);
+	std::uint32_t Add(DDSImage&& image);
+
+	///<summary>
+	/// Asks for mip (0 being the full resolution) to be resident.  Call every frame for
+	/// every texture that is drawn; textures that are not requested become candidates
+	/// for eviction, least recently requested first.
+	///</summary>
+	void RequestMip(std::uint32_t texture, std::uint32_t mip);
+
+	///<summary>
+	/// Returns the mip whose size best matches a texture drawn across the given number of
+	/// pixels, for passing to RequestMip().
+	///</summary>
+	std::uint32_t SelectMip(std::uint32_t texture, float pixels)const;
+
+	///<summary>
+	/// Makes the residency changes for this frame's requests.  Textures are served in
+	/// order of how many mips they are missing.  When the budget is exhausted, memory is
+	/// taken from textures not requested this frame (down to their mip tail) and from
+	/// textures holding finer mips than they asked for (down to the requested mip).  A
+	/// texture that still does not fit gets the finest mip that does.
+	///</summary>
+	void Update();
+
+	std::uint64_t GetBudget()const;
+	void SetBudget(std::uint64_t budgetBytes);
+
+	// Bytes uploaded by one Update() call are kept below this limit, except for the
+	// first change, so a burst of requests is spread over several frames.  0 means no limit.
+	std::uint64_t GetUpdateUploadLimit()const;
+	void SetUpdateUploadLimit(std::uint64_t bytes);
+
+	// Bytes of all resident mips.  Can exceed the budget only if the mip tails alone do.
+	std::uint64_t GetResidentBytes()const;
+
+	std::uint32_t GetTextureCount()const;
+	std::uint32_t GetMipCount(std::uint32_t texture)const;
+	std::uint32_t GetResidentMip(std::uint32_t texture)const;
+	std::uint32_t GetTailMip(std::uint32_t texture)const;
+	const DDSImage& GetImage(std::uint32_t texture)const;
+
+	///<summary>
+	/// Size in the file of mips [firstMip, MipCount) of every slice; the GPU copy adds
+	/// some alignment on top.
+	///</summary>
+	static std::uint64_t GetMipChainBytes(const DDSImage& image, std::uint32_t firstMip);
+
+private:
+	struct Entry
+	{
+		DDSImage Image;
+
+		std::uint32_t TailMip = 0;
+		std::uint32_t ResidentMip = 0;
+		std::uint32_t RequestedMip = 0;
+
+		// The frame of the last RequestMip() call, 0 if never requested.
+		std::uint64_t LastRequestFrame = 0;
+
+		// GetMipChainBytes(Image, i) for every mip i.
+		std::vector<std::uint64_t> ChainBytes;
+	};
+
+	// Finest mip the texture can be evicted to in this frame.
+	std::uint32_t GetEvictionFloor(const Entry& e)const;
+	std::uint64_t GetReclaimableBytes(std::uint32_t except)const;
+	bool MakeRoom(std::uint64_t bytes, std::uint32_t except);
+	bool SetResidentMip(std::uint32_t texture, std::uint32_t mip);
+
+private:
+	TextureStreamBackend& mBackend;
+
+	std::uint64_t mBudget = 0;
+	std::uint64_t mUpdateUploadLimit = 0;
+	std::size_t mMipTailSize = 0;
+
+	std::vector<Entry> mTextures;
+	std::uint64_t mResidentBytes = 0;
+
+	// Starts at 1 so a texture that was never requested is older than any frame.
+	std::uint64_t mFrame = 1;
+};
@@ -0,0 +1,113 @@
+//***************************************************************************************
+// TextureStreamerD3D12.cpp
+//***************************************************************************************
+
+#include "TextureStreamerD3D12.h"
+
+using Microsoft::WRL::ComPtr;
+
+TextureStreamerD3D12::TextureStreamerD3D12(ID3D12Device* device, ID3D12DescriptorHeap* srvHeap, UINT firstDescriptor,
+	UINT maxTextures, UINT framesInFlight)
+	: md3dDevice(device), mSrvHeap(srvHeap), mFirstDescriptor(firstDescriptor),
+	mMaxTextures(maxTextures), mVersionCount(framesInFlight + 1)
+{
+	mDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	mSlots.resize(maxTextures);
+}
+
+void TextureStreamerD3D12::BeginFrame(ID3D12GraphicsCommandList* cmdList, UINT64 frameFence, UINT64 completedFence)
+{
+	mCommandList = cmdList;
+	mFrameFence = frameFence;
+
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(),
+		[completedFence](const RetiredResource& r) { return r.Fence <= completedFence; }),
+		mRetired.end());
+}
+
+bool TextureStreamerD3D12::MakeResident(std::uint32_t id, const DDSImage& image, std::uint32_t firstMip)
+{
+	if(id >= mMaxTextures || mCommandList == nullptr)
+		return false;
+
+	// Every mip of the new chain fits in the size of its first mip.
+	const DDSSubresource& first = image.Subresources[firstMip];
+	const size_t maxsize = std::max<size_t>(std::max<size_t>(first.Width, first.Height), first.Depth);
+
+	ComPtr<ID3D12Resource> texture;
+	ComPtr<ID3D12Resource> uploadHeap;
+	if(FAILED(DirectX::CreateDDSTextureFromImage12(md3dDevice, mCommandList,
+		image, texture, uploadHeap, firstMip > 0 ? maxsize : 0)))
+	{
+		return false;
+	}
+
+	Slot& slot = mSlots[id];
+
+	// A descriptor written earlier in this frame has not been used by the GPU yet and
+	// can be overwritten; otherwise move on to the next one.
+	if(slot.Resource != nullptr && slot.ChangeFence != mFrameFence)
+		slot.Version = (slot.Version + 1) % mVersionCount;
+
+	Retire(slot.Resource);
+	Retire(uploadHeap);
+
+	slot.Resource = texture;
+	slot.ChangeFence = mFrameFence;
+
+	const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = desc.Format;
+	if(image.IsCubeMap)
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+		srvDesc.TextureCube.MostDetailedMip = 0;
+		srvDesc.TextureCube.MipLevels = desc.MipLevels;
+		srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
+	}
+	else if(desc.DepthOrArraySize > 1)
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MostDetailedMip = 0;
+		srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
+		srvDesc.Texture2DArray.FirstArraySlice = 0;
+		srvDesc.Texture2DArray.ArraySize = desc.DepthOrArraySize;
+		srvDesc.Texture2DArray.ResourceMinLODClamp = 0.0f;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = 0;
+		srvDesc.Texture2D.MipLevels = desc.MipLevels;
+		srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+	}
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvHeap->GetCPUDescriptorHandleForHeapStart());
+	hDescriptor.Offset(GetSrvIndex(id), mDescriptorSize);
+	md3dDevice->CreateShaderResourceView(texture.Get(), &srvDesc, hDescriptor);
+
+	return true;
+}
+
+UINT TextureStreamerD3D12::GetSrvIndex(std::uint32_t id)const
+{
+	return mFirstDescriptor + id*mVersionCount + mSlots[id].Version;
+}
+
+ID3D12Resource* TextureStreamerD3D12::GetResource(std::uint32_t id)const
+{
+	return mSlots[id].Resource.Get();
+}
+
+void TextureStreamerD3D12::Retire(ComPtr<ID3D12Resource>& resource)
+{
+	if(resource == nullptr)
+		return;
+
+	RetiredResource r;
+	r.Resource = std::move(resource);
+	r.Fence = mFrameFence;
+	mRetired.push_back(std::move(r));
+}
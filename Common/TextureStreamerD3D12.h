@@ -0,0 +1,79 @@
+//***************************************************************************************
+// TextureStreamerD3D12.h
+//
+// TextureStreamBackend that keeps every streamed texture as a committed resource holding
+// just its resident mips.  A residency change creates a new resource through
+// CreateDDSTextureFromImage12, records the copies on the frame's command list and writes
+// a new SRV.  Frames still in flight keep sampling the old resource through the old SRV,
+// so each texture cycles through framesInFlight + 1 descriptors, and old resources and
+// upload heaps are released once the GPU has passed the frame that replaced them.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "TextureStreamer.h"
+
+class TextureStreamerD3D12 : public TextureStreamBackend
+{
+public:
+	///<summary>
+	/// Uses the GetDescriptorCount(maxTextures, framesInFlight) descriptors of srvHeap
+	/// starting at firstDescriptor.
+	///</summary>
+	TextureStreamerD3D12(ID3D12Device* device, ID3D12DescriptorHeap* srvHeap, UINT firstDescriptor,
+		UINT maxTextures, UINT framesInFlight);
+	TextureStreamerD3D12(const TextureStreamerD3D12& rhs) = delete;
+	TextureStreamerD3D12& operator=(const TextureStreamerD3D12& rhs) = delete;
+
+	static UINT GetDescriptorCount(UINT maxTextures, UINT framesInFlight)
+	{
+		return maxTextures * (framesInFlight + 1);
+	}
+
+	///<summary>
+	/// Call before TextureStreamer::Add() or Update().  Uploads are recorded on cmdList,
+	/// whose work will be done once the fence reaches frameFence; completedFence is the
+	/// fence's current value, used to release retired resources.
+	///</summary>
+	void BeginFrame(ID3D12GraphicsCommandList* cmdList, UINT64 frameFence, UINT64 completedFence);
+
+	virtual bool MakeResident(std::uint32_t id, const DDSImage& image, std::uint32_t firstMip)override;
+
+	// Heap index of the SRV to bind for texture id this frame.
+	UINT GetSrvIndex(std::uint32_t id)const;
+
+	ID3D12Resource* GetResource(std::uint32_t id)const;
+
+private:
+	struct Slot
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
+		UINT Version = 0;
+
+		// Fence of the frame that last replaced the resource.
+		UINT64 ChangeFence = 0;
+	};
+
+	struct RetiredResource
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		UINT64 Fence = 0;
+	};
+
+	void Retire(Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+
+private:
+	ID3D12Device* md3dDevice = nullptr;
+	ID3D12DescriptorHeap* mSrvHeap = nullptr;
+	UINT mFirstDescriptor = 0;
+	UINT mMaxTextures = 0;
+	UINT mVersionCount = 0;
+	UINT mDescriptorSize = 0;
+
+	ID3D12GraphicsCommandList* mCommandList = nullptr;
+	UINT64 mFrameFence = 0;
+
+	std::vector<Slot> mSlots;
+	std::vector<RetiredResource> mRetired;
+};
@@ -1,64 +1,182 @@
 #pragma once
 
 #include "d3dUtil.h"
+#include "BufferMemoryD3D12.h"
+#include "SubresourceCopy.h"
 
 template<typename T>
 class UploadBuffer
 {
 public:
     UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer) : 
+        mOwnedMemory(std::make_unique<BufferMemoryD3D12>(device)),
+        mMemory(mOwnedMemory.get()),
         mIsConstantBuffer(isConstantBuffer)
     {
-        mElementByteSize = sizeof(T);
-
-        //    ũ ݵ 256Ʈ ̾ 
-        // ̴ ϵ m*256Ʈ ¿ ϴ n*256 Ʈ 
-        //  ڷḸ   ֱ 
-        // typedef struct D3D12_CONSTANT_BUFFER_VIEW_DESC {
-        // UINT64 OffsetInBytes; // 256 
-        // UINT   SizeInBytes;   // 256 
-        // } D3D12_CONSTANT_BUFFER_VIEW_DESC;
-        if(isConstantBuffer)
-            mElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
-
-        ThrowIfFailed(device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(mElementByteSize*elementCount),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&mUploadBuffer)));
-
-        ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
+        Create(elementCount);
+    }
 
-        // ڿ  ϱ    ʿ䰡 . ׷, ڿ GPU ϴ ߿ CPU ڿ
-        //  ʾƾ Ѵ. 
+    // Takes its memory from memory, such as a HostBufferMemory to build frames without a
+    // device.  memory must outlive the buffer.
+    UploadBuffer(BufferMemoryBackend& memory, UINT elementCount, bool isConstantBuffer) :
+        mMemory(&memory),
+        mIsConstantBuffer(isConstantBuffer)
+    {
+        Create(elementCount);
     }
 
     UploadBuffer(const UploadBuffer& rhs) = delete;
     UploadBuffer& operator=(const UploadBuffer& rhs) = delete;
     ~UploadBuffer()
     {
-        if(mUploadBuffer != nullptr)
-            mUploadBuffer->Unmap(0, nullptr);
+        if(mBuffer.CPU != nullptr)
+        {
+            mMemory->ReleaseBuffer(mBuffer);
+            MemoryTracker::Free(GetMemoryTag(), mBuffer.Size);
+        }
 
         mMappedData = nullptr;
     }
 
+    // Null for buffers in host memory.
     ID3D12Resource* Resource()const
     {
-        return mUploadBuffer.Get();
+        return static_cast<ID3D12Resource*>(mBuffer.Resource);
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress()const
+    {
+        return mBuffer.GPU;
     }
 
     void CopyData(int elementIndex, const T& data)
     {
+        if(!mWritten.empty())
+        {
+            CopyRange(elementIndex, &data, 1);
+            return;
+        }
+
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
+        mWrittenBytes += sizeof(T);
+    }
+
+    // Copies count elements to [firstElement, firstElement + count) in one call.  The
+    // elements are spread out to the constant buffer stride and written with streaming
+    // stores, since the mapped memory is write-combined.
+    void CopyRange(int firstElement, const T* data, UINT count)
+    {
+        assert(firstElement >= 0 && firstElement + count <= mElementCount);
+
+        if(mWritten.empty())
+        {
+            WriteElements(firstElement, data, count);
+            return;
+        }
+
+        // Only the runs of elements whose bytes differ from the last copy are written.
+        UINT i = 0;
+        while(i < count)
+        {
+            if(!IsChanged(firstElement + i, data[i]))
+            {
+                ++i;
+                continue;
+            }
+
+            UINT end = i + 1;
+            while(end < count && IsChanged(firstElement + end, data[end]))
+                ++end;
+
+            for(UINT j = i; j < end; ++j)
+            {
+                memcpy(&mShadow[(firstElement + j)*sizeof(T)], &data[j], sizeof(T));
+                mWritten[firstElement + j] = 1;
+            }
+
+            WriteElements(firstElement + i, &data[i], end - i);
+            i = end;
+        }
+    }
+
+    // Keeps a copy of the last data copied to each element, so CopyData() and CopyRange()
+    // skip elements that did not change.  Enable it before the first copy.
+    void SetChangeTracking(bool enable)
+    {
+        mShadow.assign(enable ? (size_t)mElementCount*sizeof(T) : 0, 0);
+        mWritten.assign(enable ? mElementCount : 0, 0);
+    }
+
+    // Bytes written to the mapped memory so far, padding excluded.
+    UINT64 GetWrittenBytes()const
+    {
+        return mWrittenBytes;
+    }
+
+private:
+    MemoryTag GetMemoryTag()const
+    {
+        return mIsConstantBuffer ? MemoryTag::ConstantBuffers : MemoryTag::Upload;
+    }
+
+    bool IsChanged(UINT elementIndex, const T& data)const
+    {
+        return !mWritten[elementIndex] || memcmp(&mShadow[elementIndex*sizeof(T)], &data, sizeof(T)) != 0;
+    }
+
+    void WriteElements(UINT firstElement, const T* data, UINT count)
+    {
+        SubresourceCopyDesc desc;
+        desc.Dst = &mMappedData[firstElement*mElementByteSize];
+        desc.DstRowPitch = mElementByteSize;
+        desc.DstSlicePitch = (size_t)mElementByteSize*count;
+        desc.Src = reinterpret_cast<const std::uint8_t*>(data);
+        desc.SrcRowPitch = sizeof(T);
+        desc.SrcSlicePitch = sizeof(T)*count;
+        desc.RowBytes = sizeof(T);
+        desc.NumRows = count;
+        SubresourceCopy::Copy(&desc, 1, SubresourceCopy::Destination::WriteCombined);
+
+        mWrittenBytes += (UINT64)sizeof(T)*count;
+    }
+
+    void Create(UINT elementCount)
+    {
+        mElementCount = elementCount;
+        mElementByteSize = sizeof(T);
+
+        //    ũ ݵ 256Ʈ ̾ 
+        // ̴ ϵ m*256Ʈ ¿ ϴ n*256 Ʈ 
+        //  ڷḸ   ֱ 
+        // typedef struct D3D12_CONSTANT_BUFFER_VIEW_DESC {
+        // UINT64 OffsetInBytes; // 256 
+        // UINT   SizeInBytes;   // 256 
+        // } D3D12_CONSTANT_BUFFER_VIEW_DESC;
+        if(mIsConstantBuffer)
+            mElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
+
+        if(!mMemory->CreateUploadBuffer((UINT64)mElementByteSize*elementCount, mBuffer))
+            ThrowIfFailed(E_OUTOFMEMORY);
+
+        MemoryTracker::Allocate(GetMemoryTag(), mBuffer.Size);
+        mMappedData = mBuffer.CPU;
+
+        // ڿ  ϱ    ʿ䰡 . ׷, ڿ GPU ϴ ߿ CPU ڿ
+        //  ʾƾ Ѵ. 
     }
 
 private:
-    Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
+    std::unique_ptr<BufferMemoryD3D12> mOwnedMemory;
+    BufferMemoryBackend* mMemory = nullptr;
+    BufferAllocation mBuffer;
     BYTE* mMappedData = nullptr;
 
+    UINT mElementCount = 0;
     UINT mElementByteSize = 0;
     bool mIsConstantBuffer = false;
+
+    // Change tracking; empty when it is off.
+    std::vector<BYTE> mShadow;
+    std::vector<BYTE> mWritten;
+    UINT64 mWrittenBytes = 0;
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+//***************************************************************************************
+// UploadRing.cpp
+//***************************************************************************************
+
+#include "UploadRing.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+
+namespace
+{
+	std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+const std::uint64_t UploadRing::ConstantBufferAlignment;
+const std::uint64_t UploadRing::MaxAlignment;
+
+UploadRing::UploadRing(BufferMemoryBackend& backend, std::uint64_t initialSize)
+	: mBackend(backend)
+{
+	Grow(initialSize);
+}
+
+UploadRing::~UploadRing()
+{
+	for(const RetiredBlock& r : mRetired)
+		ReleaseBlock(r.Block);
+
+	if(mBlock.CPU != nullptr)
+		ReleaseBlock(mBlock);
+}
+
+void UploadRing::BeginFrame(std::uint64_t completedFence)
+{
+	while(!mFrames.empty() && mFrames.front().Fence <= completedFence)
+	{
+		mTail = mFrames.front().End;
+		mFrames.pop_front();
+	}
+
+	auto retired = std::remove_if(mRetired.begin(), mRetired.end(),
+		[completedFence](const RetiredBlock& r) { return r.Fence != 0 && r.Fence <= completedFence; });
+	for(auto it = retired; it != mRetired.end(); ++it)
+		ReleaseBlock(it->Block);
+	mRetired.erase(retired, mRetired.end());
+}
+
+UploadAllocation UploadRing::Allocate(std::uint64_t byteSize, std::uint64_t alignment)
+{
+	UploadAllocation allocation;
+
+	std::uint64_t position = AlignUp(mHead, alignment);
+
+	// Pieces never wrap around the end of the block; start over at its beginning.
+	if(mBlock.CPU != nullptr && position % mBlock.Size + byteSize > mBlock.Size)
+		position = (position / mBlock.Size + 1) * mBlock.Size;
+
+	if(mBlock.CPU == nullptr || position + byteSize - mTail > mBlock.Size)
+	{
+		if(!Grow(byteSize))
+			return allocation;
+
+		position = 0;
+	}
+
+	mHead = position + byteSize;
+
+	const std::uint64_t offset = position % mBlock.Size;
+	allocation.CPU = mBlock.CPU + offset;
+	allocation.GPU = mBlock.GPU + offset;
+	allocation.Size = byteSize;
+	return allocation;
+}
+
+void UploadRing::EndFrame(std::uint64_t frameFence)
+{
+	FrameMark mark;
+	mark.Fence = frameFence;
+	mark.End = mHead;
+	mFrames.push_back(mark);
+
+	for(RetiredBlock& r : mRetired)
+	{
+		if(r.Fence == 0)
+			r.Fence = frameFence;
+	}
+}
+
+std::uint64_t UploadRing::GetCapacity()const
+{
+	return mBlock.Size;
+}
+
+std::uint64_t UploadRing::GetUsedBytes()const
+{
+	return mHead - mTail;
+}
+
+bool UploadRing::Grow(std::uint64_t byteSize)
+{
+	// Sizes stay multiples of MaxAlignment, so aligned positions give aligned offsets.
+	std::uint64_t size = mBlock.CPU != nullptr ? mBlock.Size * 2 :
+		AlignUp(std::max<std::uint64_t>(byteSize, 1), MaxAlignment);
+	while(size < byteSize)
+		size *= 2;
+
+	BufferAllocation block;
+	if(!mBackend.CreateUploadBuffer(size, block))
+		return false;
+
+	MemoryTracker::Allocate(MemoryTag::Upload, block.Size);
+
+	// Frames still in flight read the old block; it goes once the frame being built,
+	// the last to use it, is done.
+	if(mBlock.CPU != nullptr)
+	{
+		RetiredBlock retired;
+		retired.Block = mBlock;
+		mRetired.push_back(retired);
+	}
+
+	mBlock = block;
+	mHead = 0;
+	mTail = 0;
+	mFrames.clear();
+	return true;
+}
+
+void UploadRing::ReleaseBlock(const BufferAllocation& block)
+{
+	mBackend.ReleaseBuffer(block);
+	MemoryTracker::Free(MemoryTag::Upload, block.Size);
+}
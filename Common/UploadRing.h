@@ -0,0 +1,105 @@
+//***************************************************************************************
+// UploadRing.h
+//
+// One persistently mapped block of upload memory shared by every frame in flight, handed
+// out front to back in aligned pieces, each with its CPU pointer and GPU virtual address.
+// A frame's pieces are returned all at once, when the fence passes the value the frame
+// was submitted with.  If a frame asks for more than is free, a block twice the size
+// replaces the current one, which is released after the GPU has finished the frame.
+//
+// The blocks are upload buffers of a BufferMemoryBackend, so with HostBufferMemory the
+// allocator runs without a device.
+//***************************************************************************************
+
+#pragma once
+
+#include "BufferMemory.h"
+#include <cstring>
+#include <deque>
+
+// A piece of an UploadRing block.
+struct UploadAllocation
+{
+	std::uint8_t* CPU = nullptr;
+	std::uint64_t GPU = 0;
+	std::uint64_t Size = 0;
+};
+
+class UploadRing
+{
+public:
+	// D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT.
+	static const std::uint64_t ConstantBufferAlignment = 256;
+
+	// Largest alignment Allocate() takes; block sizes are multiples of it too.
+	static const std::uint64_t MaxAlignment = BufferAllocation::Alignment;
+
+	UploadRing(BufferMemoryBackend& backend, std::uint64_t initialSize);
+	UploadRing(const UploadRing& rhs) = delete;
+	UploadRing& operator=(const UploadRing& rhs) = delete;
+
+	// The GPU must be done with every frame.
+	~UploadRing();
+
+	///<summary>
+	/// Call at the start of a frame, once the frame resource's fence wait is over.
+	/// completedFence is the fence's current value; every frame submitted with a fence
+	/// value up to it gives its memory back.
+	///</summary>
+	void BeginFrame(std::uint64_t completedFence);
+
+	///<summary>
+	/// Returns byteSize bytes aligned to alignment, a power of two no greater than
+	/// MaxAlignment, which stay valid until the fence passes the frame's value.  CPU is
+	/// null if the backend could not create a larger block.
+	///</summary>
+	UploadAllocation Allocate(std::uint64_t byteSize, std::uint64_t alignment = ConstantBufferAlignment);
+
+	// Allocates and fills one constant buffer.
+	template<typename T>
+	UploadAllocation AllocateConstants(const T& constants)
+	{
+		UploadAllocation allocation = Allocate(sizeof(T));
+		if(allocation.CPU != nullptr)
+			std::memcpy(allocation.CPU, &constants, sizeof(T));
+		return allocation;
+	}
+
+	// Ties everything allocated since BeginFrame() to the frame's fence value.
+	void EndFrame(std::uint64_t frameFence);
+
+	std::uint64_t GetCapacity()const;
+
+	// Bytes the GPU may still read, including those of the frame being built.
+	std::uint64_t GetUsedBytes()const;
+
+private:
+	struct FrameMark
+	{
+		std::uint64_t Fence = 0;
+		std::uint64_t End = 0;
+	};
+
+	struct RetiredBlock
+	{
+		BufferAllocation Block;
+
+		// 0 until the frame that stopped using the block has been given its value.
+		std::uint64_t Fence = 0;
+	};
+
+	bool Grow(std::uint64_t byteSize);
+	void ReleaseBlock(const BufferAllocation& block);
+
+private:
+	BufferMemoryBackend& mBackend;
+	BufferAllocation mBlock;
+
+	// Positions count every byte ever handed out, so they only grow; the offset into
+	// the block is the position modulo its size.  [mTail, mHead) is in use.
+	std::uint64_t mHead = 0;
+	std::uint64_t mTail = 0;
+
+	std::deque<FrameMark> mFrames;
+	std::vector<RetiredBlock> mRetired;
+};
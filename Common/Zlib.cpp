@@ -0,0 +1,915 @@
+//***************************************************************************************
+// Zlib.cpp
+//***************************************************************************************
+
+#include "Zlib.h"
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+namespace
+{
+	const int MaxCodeBits = 15;
+	const int LitLenSymbols = 288;
+	const int DistSymbols = 30;
+	const int CodeLengthSymbols = 19;
+	const std::size_t WindowSize = 32768;
+	const int MinMatch = 3;
+	const int MaxMatch = 258;
+
+	const std::uint16_t LengthBase[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const std::uint8_t LengthExtra[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const std::uint16_t DistBase[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const std::uint8_t DistExtra[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	// Order the code length code lengths are stored in.
+	const std::uint8_t CodeLengthOrder[CodeLengthSymbols] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	std::uint32_t ReverseBits(std::uint32_t code, int length)
+	{
+		std::uint32_t result = 0;
+		for(int i = 0; i < length; ++i)
+		{
+			result = (result << 1) | (code & 1);
+			code >>= 1;
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------------
+	// Decompression
+	//-----------------------------------------------------------------------------------
+
+	// Reads the deflate bit stream, least significant bit first, keeping 56 or more bits
+	// buffered after every Refill.  Past the end of the input zeros are shifted in;
+	// Overrun() tells whether any of them were consumed.
+	class BitReader
+	{
+	public:
+		BitReader(const std::uint8_t* data, std::size_t size) : mData(data), mEnd(data + size) {}
+
+		void Refill()
+		{
+			if(mEnd - mData >= 8)
+			{
+				// Little endian load of the next eight bytes; only the whole bytes that fit
+				// are consumed.
+				std::uint64_t next;
+				std::memcpy(&next, mData, sizeof(next));
+				mBits |= next << mCount;
+				mData += (63 - mCount) >> 3;
+				mCount |= 56;
+			}
+			else
+			{
+				while(mCount <= 56)
+				{
+					if(mData < mEnd)
+						mBits |= (std::uint64_t)*mData++ << mCount;
+					else
+						++mPastEnd;
+					mCount += 8;
+				}
+			}
+		}
+
+		std::uint32_t Peek(int count)const { return (std::uint32_t)(mBits & ((1ull << count) - 1)); }
+		void Consume(int count) { mBits >>= count; mCount -= count; }
+
+		std::uint32_t Bits(int count)
+		{
+			if(mCount < count)
+				Refill();
+			const std::uint32_t bits = Peek(count);
+			Consume(count);
+			return bits;
+		}
+
+		void AlignToByte() { Consume(mCount & 7); }
+
+		// Copies count bytes of a stored block, buffered bytes first.
+		bool CopyBytes(std::uint8_t* dst, std::size_t count)
+		{
+			while(count > 0 && mCount >= 8)
+			{
+				*dst++ = (std::uint8_t)Bits(8);
+				--count;
+			}
+
+			if(Overrun() || count > (std::size_t)(mEnd - mData))
+				return false;
+
+			// Refill may have buffered more than the whole bytes it counted; those bytes
+			// are now read directly, so drop them from the buffer.
+			if(count > 0)
+			{
+				mBits = 0;
+				std::memcpy(dst, mData, count);
+				mData += count;
+			}
+			return true;
+		}
+
+		bool Overrun()const { return mPastEnd*8 > mCount; }
+
+	private:
+		const std::uint8_t* mData;
+		const std::uint8_t* mEnd;
+		std::uint64_t mBits = 0;
+		int mCount = 0;
+		int mPastEnd = 0;
+	};
+
+	// Canonical Huffman decoder.  Codes up to FastBits long are found with one lookup
+	// of the next FastBits stream bits; longer ones are walked a bit at a time using
+	// the code counts per length.
+	class HuffmanDecoder
+	{
+	public:
+		// Returns false for over-subscribed code lengths.  Incomplete codes are accepted;
+		// their unused codes decode as errors.
+		bool Build(const std::uint8_t* lengths, int count)
+		{
+			std::fill(std::begin(mCounts), std::end(mCounts), (std::uint16_t)0);
+			for(int i = 0; i < count; ++i)
+				++mCounts[lengths[i]];
+			mCounts[0] = 0;
+
+			int left = 1;
+			for(int len = 1; len <= MaxCodeBits; ++len)
+			{
+				left = 2*left - mCounts[len];
+				if(left < 0)
+					return false;
+			}
+
+			std::uint16_t offsets[MaxCodeBits + 2] = {};
+			for(int len = 1; len <= MaxCodeBits; ++len)
+				offsets[len + 1] = offsets[len] + mCounts[len];
+
+			for(int i = 0; i < count; ++i)
+			{
+				if(lengths[i] != 0)
+					mSymbols[offsets[lengths[i]]++] = (std::uint16_t)i;
+			}
+
+			std::fill(std::begin(mFast), std::end(mFast), (std::uint16_t)0);
+
+			std::uint32_t code = 0;
+			int index = 0;
+			for(int len = 1; len <= FastBits; ++len)
+			{
+				for(int i = 0; i < mCounts[len]; ++i, ++code, ++index)
+				{
+					const std::uint16_t entry = (std::uint16_t)(mSymbols[index] << 4 | len);
+					for(std::uint32_t j = ReverseBits(code, len); j < (1u << FastBits); j += 1u << len)
+						mFast[j] = entry;
+				}
+				code <<= 1;
+			}
+
+			return true;
+		}
+
+		// Expects at least MaxCodeBits bits buffered.  Returns -1 for an invalid code.
+		int Decode(BitReader& in)const
+		{
+			const std::uint16_t entry = mFast[in.Peek(FastBits)];
+			if(entry != 0)
+			{
+				in.Consume(entry & 15);
+				return entry >> 4;
+			}
+
+			int code = 0;
+			int first = 0;
+			int index = 0;
+			for(int len = 1; len <= MaxCodeBits; ++len)
+			{
+				code |= (int)in.Bits(1);
+				const int count = mCounts[len];
+				if(code - first < count)
+					return mSymbols[index + code - first];
+
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+
+			return -1;
+		}
+
+	private:
+		static const int FastBits = 10;
+
+		// symbol << 4 | code length, 0 where the code is longer than FastBits.
+		std::uint16_t mFast[1 << FastBits];
+		std::uint16_t mCounts[MaxCodeBits + 1];
+		std::uint16_t mSymbols[LitLenSymbols];
+	};
+
+	bool ReadDynamicTables(BitReader& in, HuffmanDecoder& litLen, HuffmanDecoder& dist)
+	{
+		in.Refill();
+		const int litLenCount = (int)in.Bits(5) + 257;
+		const int distCount = (int)in.Bits(5) + 1;
+		const int codeLengthCount = (int)in.Bits(4) + 4;
+		if(litLenCount > 286 || distCount > DistSymbols)
+			return false;
+
+		std::uint8_t codeLengthLengths[CodeLengthSymbols] = {};
+		for(int i = 0; i < codeLengthCount; ++i)
+			codeLengthLengths[CodeLengthOrder[i]] = (std::uint8_t)in.Bits(3);
+
+		HuffmanDecoder codeLengths;
+		if(!codeLengths.Build(codeLengthLengths, CodeLengthSymbols))
+			return false;
+
+		std::uint8_t lengths[286 + DistSymbols] = {};
+		int count = 0;
+		while(count < litLenCount + distCount)
+		{
+			in.Refill();
+			const int symbol = codeLengths.Decode(in);
+			if(symbol < 0)
+				return false;
+
+			if(symbol < 16)
+			{
+				lengths[count++] = (std::uint8_t)symbol;
+				continue;
+			}
+
+			std::uint8_t value = 0;
+			int repeat;
+			if(symbol == 16)
+			{
+				if(count == 0)
+					return false;
+				value = lengths[count - 1];
+				repeat = 3 + (int)in.Bits(2);
+			}
+			else if(symbol == 17)
+				repeat = 3 + (int)in.Bits(3);
+			else
+				repeat = 11 + (int)in.Bits(7);
+
+			if(count + repeat > litLenCount + distCount)
+				return false;
+
+			std::fill(lengths + count, lengths + count + repeat, value);
+			count += repeat;
+		}
+
+		// The end of block code has to be there.
+		if(lengths[256] == 0)
+			return false;
+
+		return litLen.Build(lengths, litLenCount) && dist.Build(lengths + litLenCount, distCount);
+	}
+
+	bool InflateBlock(BitReader& in, const HuffmanDecoder& litLen, const HuffmanDecoder& dist,
+		std::uint8_t* dst, std::size_t dstSize, std::size_t& pos)
+	{
+		for(;;)
+		{
+			// Enough bits for a length code, its extra bits, a distance code and its
+			// extra bits: 15 + 5 + 15 + 13.
+			in.Refill();
+
+			const int symbol = litLen.Decode(in);
+			if(symbol < 256)
+			{
+				if(symbol < 0 || pos == dstSize)
+					return false;
+				dst[pos++] = (std::uint8_t)symbol;
+				continue;
+			}
+
+			if(symbol == 256)
+				return !in.Overrun();
+
+			const int lengthCode = symbol - 257;
+			if(lengthCode >= 29)
+				return false;
+
+			const std::size_t length = LengthBase[lengthCode] + in.Bits(LengthExtra[lengthCode]);
+
+			const int distCode = dist.Decode(in);
+			if(distCode < 0 || distCode >= DistSymbols)
+				return false;
+
+			const std::size_t distance = DistBase[distCode] + in.Bits(DistExtra[distCode]);
+			if(distance > pos || length > dstSize - pos)
+				return false;
+
+			std::uint8_t* out = dst + pos;
+			const std::uint8_t* from = out - distance;
+			if(distance >= length)
+			{
+				std::memcpy(out, from, length);
+			}
+			else
+			{
+				// Overlapping copies repeat the last distance bytes.
+				for(std::size_t i = 0; i < length; ++i)
+					out[i] = from[i];
+			}
+			pos += length;
+		}
+	}
+
+	const HuffmanDecoder& GetFixedLitLen()
+	{
+		static const HuffmanDecoder decoder = []()
+		{
+			std::uint8_t lengths[LitLenSymbols];
+			std::fill(lengths, lengths + 144, (std::uint8_t)8);
+			std::fill(lengths + 144, lengths + 256, (std::uint8_t)9);
+			std::fill(lengths + 256, lengths + 280, (std::uint8_t)7);
+			std::fill(lengths + 280, lengths + LitLenSymbols, (std::uint8_t)8);
+
+			HuffmanDecoder d;
+			d.Build(lengths, LitLenSymbols);
+			return d;
+		}();
+		return decoder;
+	}
+
+	const HuffmanDecoder& GetFixedDist()
+	{
+		static const HuffmanDecoder decoder = []()
+		{
+			std::uint8_t lengths[DistSymbols];
+			std::fill(lengths, lengths + DistSymbols, (std::uint8_t)5);
+
+			HuffmanDecoder d;
+			d.Build(lengths, DistSymbols);
+			return d;
+		}();
+		return decoder;
+	}
+
+	//-----------------------------------------------------------------------------------
+	// Compression
+	//-----------------------------------------------------------------------------------
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<std::uint8_t>& out) : mOut(out) {}
+
+		void Put(std::uint32_t bits, int count)
+		{
+			mBits |= (std::uint64_t)bits << mCount;
+			mCount += count;
+			while(mCount >= 8)
+			{
+				mOut.push_back((std::uint8_t)mBits);
+				mBits >>= 8;
+				mCount -= 8;
+			}
+		}
+
+		void AlignToByte()
+		{
+			if(mCount > 0)
+				Put(0, 8 - mCount);
+		}
+
+	private:
+		std::vector<std::uint8_t>& mOut;
+		std::uint64_t mBits = 0;
+		int mCount = 0;
+	};
+
+	// Huffman code lengths for the symbol frequencies, no longer than limit.  Lengths
+	// past the limit are clamped, then codes just under the limit are lengthened until
+	// the Kraft sum fits again, and finally frequent codes are shortened into any space
+	// left, since zlib rejects incomplete codes.  A lone symbol gets a partner for the
+	// same reason.
+	void BuildCodeLengths(const std::uint32_t* freqs, int count, int limit, std::uint8_t* lengths)
+	{
+		std::fill(lengths, lengths + count, (std::uint8_t)0);
+
+		struct Node
+		{
+			std::uint64_t Freq;
+			int Index;
+			bool operator>(const Node& rhs)const { return Freq != rhs.Freq ? Freq > rhs.Freq : Index > rhs.Index; }
+		};
+
+		std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+		std::vector<int> parents(2*count, -1);
+		int used = 0;
+		for(int i = 0; i < count; ++i)
+		{
+			if(freqs[i] != 0)
+			{
+				queue.push({ freqs[i], i });
+				++used;
+			}
+		}
+
+		if(used == 0)
+			return;
+
+		if(used == 1)
+		{
+			const int symbol = queue.top().Index;
+			lengths[symbol] = 1;
+			lengths[symbol == 0 ? 1 : 0] = 1;
+			return;
+		}
+
+		int next = count;
+		while(queue.size() > 1)
+		{
+			const Node a = queue.top(); queue.pop();
+			const Node b = queue.top(); queue.pop();
+			parents[a.Index] = next;
+			parents[b.Index] = next;
+			queue.push({ a.Freq + b.Freq, next++ });
+		}
+
+		std::vector<int> depths(next, 0);
+		for(int node = next - 2; node >= 0; --node)
+		{
+			if(parents[node] >= 0)
+				depths[node] = depths[parents[node]] + 1;
+		}
+
+		std::uint32_t kraft = 0;
+		for(int i = 0; i < count; ++i)
+		{
+			if(freqs[i] != 0)
+			{
+				lengths[i] = (std::uint8_t)std::min<int>(depths[i], limit);
+				kraft += 1u << (limit - lengths[i]);
+			}
+		}
+
+		while(kraft > (1u << limit))
+		{
+			int longest = -1;
+			for(int i = 0; i < count; ++i)
+			{
+				if(lengths[i] != 0 && lengths[i] < limit && (longest < 0 || lengths[i] > lengths[longest]))
+					longest = i;
+			}
+
+			kraft -= 1u << (limit - lengths[longest] - 1);
+			++lengths[longest];
+		}
+
+		std::vector<int> byFreq;
+		for(int i = 0; i < count; ++i)
+		{
+			if(freqs[i] != 0)
+				byFreq.push_back(i);
+		}
+		std::stable_sort(byFreq.begin(), byFreq.end(), [freqs](int a, int b) { return freqs[a] > freqs[b]; });
+
+		// The space left is a multiple of the longest code's share, so this ends complete.
+		bool changed = true;
+		while(kraft < (1u << limit) && changed)
+		{
+			changed = false;
+			for(int i : byFreq)
+			{
+				const std::uint32_t gain = 1u << (limit - lengths[i]);
+				if(lengths[i] > 1 && kraft + gain <= (1u << limit))
+				{
+					kraft += gain;
+					--lengths[i];
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// Code of every symbol, bit reversed for the LSB first stream.
+	void BuildCodes(const std::uint8_t* lengths, int count, std::uint16_t* codes)
+	{
+		std::uint16_t lengthCounts[MaxCodeBits + 1] = {};
+		for(int i = 0; i < count; ++i)
+			++lengthCounts[lengths[i]];
+		lengthCounts[0] = 0;
+
+		std::uint32_t nextCode[MaxCodeBits + 1] = {};
+		std::uint32_t code = 0;
+		for(int len = 1; len <= MaxCodeBits; ++len)
+		{
+			code = (code + lengthCounts[len - 1]) << 1;
+			nextCode[len] = code;
+		}
+
+		for(int i = 0; i < count; ++i)
+			codes[i] = lengths[i] != 0 ? (std::uint16_t)ReverseBits(nextCode[lengths[i]]++, lengths[i]) : 0;
+	}
+
+	int GetLengthCode(int length)
+	{
+		int code = 0;
+		while(code < 28 && LengthBase[code + 1] <= length)
+			++code;
+		return code;
+	}
+
+	int GetDistCode(int distance)
+	{
+		int code = 0;
+		while(code < 29 && DistBase[code + 1] <= distance)
+			++code;
+		return code;
+	}
+
+	// A literal (Length 0, Value the byte) or a match (Length and distance Value).
+	struct Token
+	{
+		std::uint16_t Length;
+		std::uint16_t Value;
+	};
+
+	void WriteStoredBlocks(BitWriter& bits, const std::uint8_t* data, std::size_t size, bool last,
+		std::vector<std::uint8_t>& out)
+	{
+		do
+		{
+			const std::size_t chunk = std::min<std::size_t>(size, 65535);
+			const bool final = last && chunk == size;
+
+			bits.Put(final ? 1 : 0, 1);
+			bits.Put(0, 2);
+			bits.AlignToByte();
+			bits.Put((std::uint32_t)chunk, 16);
+			bits.Put((std::uint32_t)~chunk & 0xffff, 16);
+			out.insert(out.end(), data, data + chunk);
+
+			data += chunk;
+			size -= chunk;
+		}
+		while(size > 0);
+	}
+
+	// Writes the tokens as one dynamic Huffman block, or as stored blocks when that is
+	// smaller.
+	void WriteBlock(BitWriter& bits, const std::vector<Token>& tokens, const std::uint8_t* data, std::size_t size,
+		bool last, std::vector<std::uint8_t>& out)
+	{
+		std::uint32_t litLenFreqs[LitLenSymbols] = {};
+		std::uint32_t distFreqs[DistSymbols] = {};
+		for(const Token& t : tokens)
+		{
+			if(t.Length == 0)
+				++litLenFreqs[t.Value];
+			else
+			{
+				++litLenFreqs[257 + GetLengthCode(t.Length)];
+				++distFreqs[GetDistCode(t.Value)];
+			}
+		}
+		litLenFreqs[256] = 1;
+
+		std::uint8_t lengths[286 + DistSymbols];
+		std::uint8_t* litLenLengths = lengths;
+		std::uint8_t distLengths[DistSymbols];
+		BuildCodeLengths(litLenFreqs, 286, MaxCodeBits, litLenLengths);
+		BuildCodeLengths(distFreqs, DistSymbols, MaxCodeBits, distLengths);
+
+		// A block without matches still needs one distance code.
+		if(std::all_of(distLengths, distLengths + DistSymbols, [](std::uint8_t l) { return l == 0; }))
+			distLengths[0] = distLengths[1] = 1;
+
+		int litLenCount = 286;
+		while(litLenCount > 257 && litLenLengths[litLenCount - 1] == 0)
+			--litLenCount;
+		int distCount = DistSymbols;
+		while(distCount > 1 && distLengths[distCount - 1] == 0)
+			--distCount;
+
+		std::memmove(lengths + litLenCount, distLengths, distCount);
+		const int total = litLenCount + distCount;
+
+		// Run length code the code lengths: (symbol, extra bits) pairs.
+		std::vector<std::pair<std::uint8_t, std::uint8_t>> runs;
+		std::uint32_t codeLengthFreqs[CodeLengthSymbols] = {};
+		for(int i = 0; i < total;)
+		{
+			const std::uint8_t value = lengths[i];
+			int run = 1;
+			while(i + run < total && lengths[i + run] == value)
+				++run;
+
+			int left = run;
+			if(value == 0)
+			{
+				while(left >= 11)
+				{
+					const int n = std::min<int>(left, 138);
+					runs.push_back({ 18, (std::uint8_t)(n - 11) });
+					left -= n;
+				}
+				if(left >= 3)
+				{
+					runs.push_back({ 17, (std::uint8_t)(left - 3) });
+					left = 0;
+				}
+			}
+			else if(left >= 4)
+			{
+				runs.push_back({ value, 0 });
+				--left;
+				while(left >= 3)
+				{
+					const int n = std::min<int>(left, 6);
+					runs.push_back({ 16, (std::uint8_t)(n - 3) });
+					left -= n;
+				}
+			}
+
+			for(; left > 0; --left)
+				runs.push_back({ value, 0 });
+
+			i += run;
+		}
+
+		for(const auto& r : runs)
+			++codeLengthFreqs[r.first];
+
+		std::uint8_t codeLengthLengths[CodeLengthSymbols];
+		BuildCodeLengths(codeLengthFreqs, CodeLengthSymbols, 7, codeLengthLengths);
+
+		int codeLengthCount = CodeLengthSymbols;
+		while(codeLengthCount > 4 && codeLengthLengths[CodeLengthOrder[codeLengthCount - 1]] == 0)
+			--codeLengthCount;
+
+		std::uint8_t fullLitLen[LitLenSymbols] = {};
+		std::uint8_t fullDist[DistSymbols] = {};
+		std::copy(lengths, lengths + litLenCount, fullLitLen);
+		std::copy(lengths + litLenCount, lengths + total, fullDist);
+
+		// Compare the sizes before writing anything.
+		std::uint64_t blockBits = 3 + 14 + 3*codeLengthCount;
+		for(const auto& r : runs)
+			blockBits += codeLengthLengths[r.first] + (r.first == 16 ? 2 : r.first == 17 ? 3 : r.first == 18 ? 7 : 0);
+		for(int i = 0; i < LitLenSymbols; ++i)
+			blockBits += (std::uint64_t)litLenFreqs[i]*fullLitLen[i];
+		for(int i = 0; i < 29; ++i)
+			blockBits += (std::uint64_t)litLenFreqs[257 + i]*LengthExtra[i];
+		for(int i = 0; i < DistSymbols; ++i)
+			blockBits += (std::uint64_t)distFreqs[i]*(fullDist[i] + DistExtra[i]);
+
+		const std::uint64_t storedBits = ((size + 65534)/65535)*40 + (std::uint64_t)size*8;
+		if(blockBits >= storedBits)
+		{
+			WriteStoredBlocks(bits, data, size, last, out);
+			return;
+		}
+
+		std::uint16_t litLenCodes[LitLenSymbols];
+		std::uint16_t distCodes[DistSymbols];
+		std::uint16_t codeLengthCodes[CodeLengthSymbols];
+		BuildCodes(fullLitLen, LitLenSymbols, litLenCodes);
+		BuildCodes(fullDist, DistSymbols, distCodes);
+		BuildCodes(codeLengthLengths, CodeLengthSymbols, codeLengthCodes);
+
+		bits.Put(last ? 1 : 0, 1);
+		bits.Put(2, 2);
+		bits.Put(litLenCount - 257, 5);
+		bits.Put(distCount - 1, 5);
+		bits.Put(codeLengthCount - 4, 4);
+		for(int i = 0; i < codeLengthCount; ++i)
+			bits.Put(codeLengthLengths[CodeLengthOrder[i]], 3);
+
+		for(const auto& r : runs)
+		{
+			bits.Put(codeLengthCodes[r.first], codeLengthLengths[r.first]);
+			if(r.first == 16)      bits.Put(r.second, 2);
+			else if(r.first == 17) bits.Put(r.second, 3);
+			else if(r.first == 18) bits.Put(r.second, 7);
+		}
+
+		for(const Token& t : tokens)
+		{
+			if(t.Length == 0)
+			{
+				bits.Put(litLenCodes[t.Value], fullLitLen[t.Value]);
+				continue;
+			}
+
+			const int lengthCode = GetLengthCode(t.Length);
+			bits.Put(litLenCodes[257 + lengthCode], fullLitLen[257 + lengthCode]);
+			bits.Put(t.Length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+
+			const int distCode = GetDistCode(t.Value);
+			bits.Put(distCodes[distCode], fullDist[distCode]);
+			bits.Put(t.Value - DistBase[distCode], DistExtra[distCode]);
+		}
+
+		bits.Put(litLenCodes[256], fullLitLen[256]);
+	}
+}
+
+std::uint32_t Zlib::Adler32(const std::uint8_t* data, std::size_t size, std::uint32_t adler)
+{
+	// 5552 is the most bytes that can be summed before the 32 bit sums need reducing.
+	std::uint32_t a = adler & 0xffff;
+	std::uint32_t b = adler >> 16;
+
+	while(size > 0)
+	{
+		const std::size_t n = std::min<std::size_t>(size, 5552);
+		for(std::size_t i = 0; i < n; ++i)
+		{
+			a += data[i];
+			b += a;
+		}
+
+		a %= 65521;
+		b %= 65521;
+		data += n;
+		size -= n;
+	}
+
+	return (b << 16) | a;
+}
+
+bool Zlib::Decompress(const std::uint8_t* src, std::size_t srcSize, std::uint8_t* dst, std::size_t dstSize)
+{
+	// CMF: deflate with a window of at most 32K; FLG: check bits, no preset dictionary.
+	if(srcSize < 6 || (src[0] & 0x0f) != 8 || (src[0] >> 4) > 7 || ((src[0] << 8) | src[1]) % 31 != 0 || (src[1] & 0x20))
+		return false;
+
+	BitReader in(src + 2, srcSize - 2);
+	std::size_t pos = 0;
+	HuffmanDecoder litLen;
+	HuffmanDecoder dist;
+
+	bool last = false;
+	while(!last)
+	{
+		last = in.Bits(1) != 0;
+
+		switch(in.Bits(2))
+		{
+		case 0:
+		{
+			in.AlignToByte();
+			const std::uint32_t length = in.Bits(16);
+			const std::uint32_t inverse = in.Bits(16);
+			if(length != (~inverse & 0xffff) || length > dstSize - pos || !in.CopyBytes(dst + pos, length))
+				return false;
+			pos += length;
+			break;
+		}
+
+		case 1:
+			if(!InflateBlock(in, GetFixedLitLen(), GetFixedDist(), dst, dstSize, pos))
+				return false;
+			break;
+
+		case 2:
+			if(!ReadDynamicTables(in, litLen, dist) || !InflateBlock(in, litLen, dist, dst, dstSize, pos))
+				return false;
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	in.AlignToByte();
+	std::uint32_t adler = 0;
+	for(int i = 0; i < 4; ++i)
+		adler = (adler << 8) | in.Bits(8);
+
+	return !in.Overrun() && pos == dstSize && adler == Adler32(dst, dstSize);
+}
+
+void Zlib::Compress(const std::uint8_t* src, std::size_t srcSize, std::vector<std::uint8_t>& out, int effort)
+{
+	effort = std::min<int>(std::max<int>(effort, 1), 9);
+	const int maxChain = 4 << effort;
+	const int niceLength = std::min<int>(16 << (effort / 2), MaxMatch);
+
+	// 32K window, no dictionary, default level flags; the check bits make it a
+	// multiple of 31.
+	out.push_back(0x78);
+	out.push_back(0x9c);
+
+	BitWriter bits(out);
+
+	const int HashBits = 15;
+	std::vector<std::int32_t> head(1 << HashBits, -1);
+	std::vector<std::int32_t> prev(WindowSize, -1);
+
+	auto hash = [src](std::size_t pos)
+	{
+		const std::uint32_t v = src[pos] | (src[pos + 1] << 8) | (src[pos + 2] << 16);
+		return (v*2654435761u) >> (32 - HashBits);
+	};
+
+	auto insert = [&](std::size_t pos)
+	{
+		if(pos + MinMatch <= srcSize)
+		{
+			const std::uint32_t h = hash(pos);
+			prev[pos & (WindowSize - 1)] = head[h];
+			head[h] = (std::int32_t)pos;
+		}
+	};
+
+	std::vector<Token> tokens;
+	const std::size_t MaxBlockTokens = 1 << 16;
+	tokens.reserve(MaxBlockTokens);
+
+	std::size_t blockStart = 0;
+	std::size_t pos = 0;
+	for(;;)
+	{
+		int bestLength = 0;
+		std::size_t bestDistance = 0;
+
+		if(pos + MinMatch <= srcSize)
+		{
+			const std::size_t maxLength = std::min<std::size_t>(MaxMatch, srcSize - pos);
+			std::int32_t candidate = head[hash(pos)];
+
+			for(int chain = 0; chain < maxChain && candidate >= 0; ++chain)
+			{
+				const std::size_t distance = pos - (std::size_t)candidate;
+				if(distance == 0 || distance > WindowSize)
+					break;
+
+				const std::uint8_t* a = src + candidate;
+				const std::uint8_t* b = src + pos;
+				if(a[bestLength] == b[bestLength])
+				{
+					std::size_t length = 0;
+					while(length < maxLength && a[length] == b[length])
+						++length;
+
+					if((int)length > bestLength)
+					{
+						bestLength = (int)length;
+						bestDistance = distance;
+						if(bestLength >= niceLength || length == maxLength)
+							break;
+					}
+				}
+
+				const std::int32_t older = prev[candidate & (WindowSize - 1)];
+				if(older >= candidate)
+					break;
+				candidate = older;
+			}
+		}
+
+		if(bestLength >= MinMatch)
+		{
+			tokens.push_back({ (std::uint16_t)bestLength, (std::uint16_t)bestDistance });
+			for(int i = 0; i < bestLength; ++i)
+				insert(pos + i);
+			pos += bestLength;
+		}
+		else if(pos < srcSize)
+		{
+			tokens.push_back({ 0, src[pos] });
+			insert(pos);
+			++pos;
+		}
+
+		const bool done = pos >= srcSize;
+		if(done || tokens.size() == MaxBlockTokens)
+		{
+			WriteBlock(bits, tokens, src + blockStart, pos - blockStart, done, out);
+			tokens.clear();
+			blockStart = pos;
+			if(done)
+				break;
+		}
+	}
+
+	bits.AlignToByte();
+
+	const std::uint32_t adler = Adler32(src, srcSize);
+	out.push_back((std::uint8_t)(adler >> 24));
+	out.push_back((std::uint8_t)(adler >> 16));
+	out.push_back((std::uint8_t)(adler >> 8));
+	out.push_back((std::uint8_t)adler);
+}
+
+void Zlib::Compress(const std::uint8_t* src, std::size_t srcSize, std::vector<std::uint8_t>& out)
+{
+	Compress(src, srcSize, out, 6);
+}
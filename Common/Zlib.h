@@ -0,0 +1,36 @@
+//***************************************************************************************
+// Zlib.h
+//
+// Self-contained zlib (RFC 1950/1951) compression, so KTX2 files with zlib
+// supercompression can be read and written without an external library.
+//
+// Decompression is table driven and writes straight into a caller provided buffer of
+// the known uncompressed size.  Compression uses hash chained LZ77 matching and dynamic
+// Huffman blocks, falling back to stored blocks for data that does not compress.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Zlib
+{
+public:
+	///<summary>
+	/// Decompresses a zlib stream into dst, which must be exactly the uncompressed size.
+	/// Returns false for corrupt or truncated streams, streams that do not fill dst
+	/// exactly, and streams that need a preset dictionary.
+	///</summary>
+	static bool Decompress(const std::uint8_t* src, std::size_t srcSize, std::uint8_t* dst, std::size_t dstSize);
+
+	///<summary>
+	/// Appends the zlib stream of src to out.  effort (1 to 9) bounds how many earlier
+	/// positions are tried for every match, trading speed for size like zlib's levels.
+	///</summary>
+	static void Compress(const std::uint8_t* src, std::size_t srcSize, std::vector<std::uint8_t>& out, int effort);
+	static void Compress(const std::uint8_t* src, std::size_t srcSize, std::vector<std::uint8_t>& out);
+
+	static std::uint32_t Adler32(const std::uint8_t* data, std::size_t size, std::uint32_t adler = 1);
+};
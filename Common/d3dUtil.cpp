@@ -1,9 +1,101 @@
 
 #include "d3dUtil.h"
+#include "SubresourceCopy.h"
 #include <comdef.h>
 #include <fstream>
 
 using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// Private data slot of D3D12 objects reported by d3dUtil::TrackObject().
+	// {6B1F3C2A-4E8D-4F1B-9A3E-2C715D90B417}
+	const GUID TrackedMemoryGuid =
+		{ 0x6b1f3c2a, 0x4e8d, 0x4f1b, { 0x9a, 0x3e, 0x2c, 0x71, 0x5d, 0x90, 0xb4, 0x17 } };
+
+	// Set as private data of a D3D12 object, which releases it when it is destroyed; the
+	// memory is reported free then.
+	class TrackedMemory : public IUnknown
+	{
+	public:
+		TrackedMemory(MemoryTag tag, UINT64 byteSize) : mTag(tag), mByteSize(byteSize)
+		{
+			MemoryTracker::Allocate(mTag, mByteSize);
+		}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object)override
+		{
+			if(object == nullptr)
+				return E_POINTER;
+
+			if(riid != __uuidof(IUnknown))
+			{
+				*object = nullptr;
+				return E_NOINTERFACE;
+			}
+
+			*object = static_cast<IUnknown*>(this);
+			AddRef();
+			return S_OK;
+		}
+
+		ULONG STDMETHODCALLTYPE AddRef()override
+		{
+			return (ULONG)InterlockedIncrement(&mRefCount);
+		}
+
+		ULONG STDMETHODCALLTYPE Release()override
+		{
+			const LONG count = InterlockedDecrement(&mRefCount);
+			if(count == 0)
+				delete this;
+			return (ULONG)count;
+		}
+
+	private:
+		~TrackedMemory()
+		{
+			MemoryTracker::Free(mTag, mByteSize);
+		}
+
+	private:
+		volatile LONG mRefCount = 1;
+		MemoryTag mTag;
+		UINT64 mByteSize;
+	};
+
+	// ID3DBlob that owns its bytes and reports them to MemoryTracker.
+	class TrackedBlob : public Microsoft::WRL::RuntimeClass<
+		Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>, ID3DBlob>
+	{
+	public:
+		TrackedBlob(SIZE_T byteSize, MemoryTag tag) :
+			mData(new std::uint8_t[byteSize]), mByteSize(byteSize), mTag(tag)
+		{
+			MemoryTracker::Allocate(mTag, mByteSize);
+		}
+
+		~TrackedBlob()
+		{
+			MemoryTracker::Free(mTag, mByteSize);
+		}
+
+		LPVOID STDMETHODCALLTYPE GetBufferPointer()override
+		{
+			return mData.get();
+		}
+
+		SIZE_T STDMETHODCALLTYPE GetBufferSize()override
+		{
+			return mByteSize;
+		}
+
+	private:
+		std::unique_ptr<std::uint8_t[]> mData;
+		SIZE_T mByteSize = 0;
+		MemoryTag mTag;
+	};
+}
  
 DxException::DxException(HRESULT hr, const std::wstring& functionName, const std::wstring& filename, int lineNumber) :
     ErrorCode(hr),
@@ -64,6 +156,8 @@ Microsoft::WRL::ComPtr<ID3D12Resource> d3dUtil::CreateDefaultBuffer(
         nullptr,
         IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
 
+    TrackResource(defaultBuffer.Get(), MemoryTag::Geometry);
+    TrackResource(uploadBuffer.Get(), MemoryTag::Upload);
 
     // ⺻ ۿ  ڷḦ Ѵ.
     D3D12_SUBRESOURCE_DATA subResourceData = {};
@@ -76,7 +170,7 @@ Microsoft::WRL::ComPtr<ID3D12Resource> d3dUtil::CreateDefaultBuffer(
     // ID3D12CommandList::CopySubresourceRegion ̿ؼ ӽ ε  ڷḦ mBuffer Ѵ.
 	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(defaultBuffer.Get(), 
 		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
-    UpdateSubresources<1>(cmdList, defaultBuffer.Get(), uploadBuffer.Get(), 0, 0, 1, &subResourceData);
+    UploadSubresources(cmdList, defaultBuffer.Get(), uploadBuffer.Get(), 0, 0, 1, &subResourceData);
 	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(defaultBuffer.Get(),
 		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
 
@@ -88,6 +182,121 @@ Microsoft::WRL::ComPtr<ID3D12Resource> d3dUtil::CreateDefaultBuffer(
     return defaultBuffer;
 }
 
+BufferAllocation d3dUtil::CreateDefaultBuffer(
+    BufferMemoryBackend& memory,
+    const void* initData,
+    UINT64 byteSize)
+{
+    BufferAllocation buffer;
+    if(!memory.CreateDefaultBuffer(initData, byteSize, buffer))
+        ThrowIfFailed(E_FAIL);
+
+    return buffer;
+}
+
+UINT64 d3dUtil::UploadSubresources(
+    ID3D12GraphicsCommandList* cmdList,
+    ID3D12Resource* destination,
+    ID3D12Resource* intermediate,
+    UINT64 intermediateOffset,
+    UINT firstSubresource,
+    UINT numSubresources,
+    const D3D12_SUBRESOURCE_DATA* srcData)
+{
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresources);
+    std::vector<UINT> numRows(numSubresources);
+    std::vector<UINT64> rowSizes(numSubresources);
+    UINT64 requiredSize = 0;
+
+    D3D12_RESOURCE_DESC destinationDesc = destination->GetDesc();
+    ComPtr<ID3D12Device> device;
+    destination->GetDevice(IID_PPV_ARGS(device.GetAddressOf()));
+    device->GetCopyableFootprints(&destinationDesc, firstSubresource, numSubresources, intermediateOffset,
+        layouts.data(), numRows.data(), rowSizes.data(), &requiredSize);
+
+    // The same validation as UpdateSubresources.
+    D3D12_RESOURCE_DESC intermediateDesc = intermediate->GetDesc();
+    if(numSubresources == 0 ||
+        intermediateDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER ||
+        intermediateDesc.Width < requiredSize + layouts[0].Offset ||
+        requiredSize > (SIZE_T)-1 ||
+        (destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER &&
+            (firstSubresource != 0 || numSubresources != 1)))
+    {
+        return 0;
+    }
+
+    // Nothing is read back through the mapping.
+    BYTE* data = nullptr;
+    CD3DX12_RANGE readRange(0, 0);
+    if(FAILED(intermediate->Map(0, &readRange, reinterpret_cast<void**>(&data))))
+        return 0;
+
+    std::vector<SubresourceCopyDesc> copies(numSubresources);
+    for(UINT i = 0; i < numSubresources; ++i)
+    {
+        SubresourceCopyDesc& copy = copies[i];
+        copy.Dst = data + layouts[i].Offset;
+        copy.DstRowPitch = layouts[i].Footprint.RowPitch;
+        copy.DstSlicePitch = (SIZE_T)layouts[i].Footprint.RowPitch * numRows[i];
+        copy.Src = static_cast<const std::uint8_t*>(srcData[i].pData);
+        copy.SrcRowPitch = (SIZE_T)srcData[i].RowPitch;
+        copy.SrcSlicePitch = (SIZE_T)srcData[i].SlicePitch;
+        copy.RowBytes = (SIZE_T)rowSizes[i];
+        copy.NumRows = numRows[i];
+        copy.NumSlices = layouts[i].Footprint.Depth;
+    }
+
+    SubresourceCopy::Copy(copies.data(), copies.size(), SubresourceCopy::Destination::WriteCombined);
+    intermediate->Unmap(0, nullptr);
+
+    if(destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        cmdList->CopyBufferRegion(
+            destination, 0, intermediate, layouts[0].Offset, layouts[0].Footprint.Width);
+    }
+    else
+    {
+        for(UINT i = 0; i < numSubresources; ++i)
+        {
+            CD3DX12_TEXTURE_COPY_LOCATION dst(destination, i + firstSubresource);
+            CD3DX12_TEXTURE_COPY_LOCATION src(intermediate, layouts[i]);
+            cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+        }
+    }
+
+    return requiredSize;
+}
+
+void d3dUtil::TrackObject(ID3D12Object* object, MemoryTag tag, UINT64 byteSize)
+{
+    if(object == nullptr)
+        return;
+
+    // The object holds the only reference from here on.
+    TrackedMemory* memory = new TrackedMemory(tag, byteSize);
+    object->SetPrivateDataInterface(TrackedMemoryGuid, memory);
+    memory->Release();
+}
+
+void d3dUtil::TrackResource(ID3D12Resource* resource, MemoryTag tag)
+{
+    if(resource == nullptr)
+        return;
+
+    ComPtr<ID3D12Device> device;
+    ThrowIfFailed(resource->GetDevice(IID_PPV_ARGS(device.GetAddressOf())));
+
+    const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+    const D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &desc);
+    TrackObject(resource, tag, info.SizeInBytes);
+}
+
+ComPtr<ID3DBlob> d3dUtil::CreateTrackedBlob(SIZE_T byteSize, MemoryTag tag)
+{
+    return Microsoft::WRL::Make<TrackedBlob>(byteSize, tag);
+}
+
 ComPtr<ID3DBlob> d3dUtil::CompileShader(
 	const std::wstring& filename,
 	const D3D_SHADER_MACRO* defines,
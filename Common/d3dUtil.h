@@ -28,6 +28,8 @@
 #include "d3dx12.h"
 #include "DDSTextureLoader.h"
 #include "MathHelper.h"
+#include "BufferMemory.h"
+#include "MemoryTracker.h"
 
 extern const int gNumFrameResources;
 
@@ -121,6 +123,35 @@ public:
         UINT64 byteSize,
         Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
 
+    // Creates the buffer through memory, which records any upload it needs; with
+    // HostBufferMemory no device is involved.  Throws if memory could not create it.
+    static BufferAllocation CreateDefaultBuffer(
+        BufferMemoryBackend& memory,
+        const void* initData,
+        UINT64 byteSize);
+
+    // Does what d3dx12.h's UpdateSubresources does, but fills the intermediate upload
+    // buffer with SubresourceCopy: split over TaskPool::Default() and with streaming
+    // stores.  Returns the bytes used in intermediate, or 0 on failure.
+    static UINT64 UploadSubresources(
+        ID3D12GraphicsCommandList* cmdList,
+        ID3D12Resource* destination,
+        ID3D12Resource* intermediate,
+        UINT64 intermediateOffset,
+        UINT firstSubresource,
+        UINT numSubresources,
+        const D3D12_SUBRESOURCE_DATA* srcData);
+
+    // Reports byteSize bytes under tag to MemoryTracker until object is destroyed.
+    static void TrackObject(ID3D12Object* object, MemoryTag tag, UINT64 byteSize);
+
+    // TrackObject() with the size the device allocates for resource.  Use it for
+    // committed resources only; placed resources live in a heap that is tracked instead.
+    static void TrackResource(ID3D12Resource* resource, MemoryTag tag);
+
+    // Like D3DCreateBlob, but the blob's bytes are reported under tag while it lives.
+    static Microsoft::WRL::ComPtr<ID3DBlob> CreateTrackedBlob(SIZE_T byteSize, MemoryTag tag);
+
 	static Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
 		const std::wstring& filename,
 		const D3D_SHADER_MACRO* defines,
@@ -154,6 +185,27 @@ struct SubmeshGeometry
 
     //  κ ޽ð ϴ ϱ (bounding box).
 	DirectX::BoundingBox Bounds;
+
+	//  ϱ  (bounding sphere).
+	DirectX::BoundingSphere SphereBounds;
+
+	//  ִ  (OBB). û  Ǹ, ׷  HasOrientedBounds false.
+	DirectX::BoundingOrientedBox OrientedBounds;
+	bool HasOrientedBounds = false;
+};
+
+// What a MeshGeometry does with VertexBufferCPU/IndexBufferCPU once its buffers are on
+// the GPU; see MeshGeometry::ReleaseCpuGeometry() and MeshCache::AcquireCpuGeometry().
+enum class CpuGeometryPolicy
+{
+	// Hold the system memory copy for the lifetime of the geometry.
+	Keep,
+
+	// Release it; nothing reads the mesh on the CPU again.
+	Drop,
+
+	// Release it and map CacheFile again when something (picking, collision) needs it.
+	Remap
 };
 
 struct MeshGeometry
@@ -172,6 +224,16 @@ struct MeshGeometry
 	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferUploader = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferUploader = nullptr;
 
+	// Where the buffers start in their resources, for buffers packed by GeometryHeap.
+	UINT64 VertexBufferOffset = 0;
+	UINT64 IndexBufferOffset = 0;
+
+	CpuGeometryPolicy CpuPolicy = CpuGeometryPolicy::Keep;
+
+	// Cooked .mesh file the CPU copy is mapped from under CpuGeometryPolicy::Remap.
+	// MeshCache::Load() sets it.
+	std::wstring CacheFile;
+
     //   ڷ
 	UINT VertexByteStride = 0;
 	UINT VertexBufferByteSize = 0;
@@ -185,7 +247,7 @@ struct MeshGeometry
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
 	{
 		D3D12_VERTEX_BUFFER_VIEW vbv;
-		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress();
+		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress() + VertexBufferOffset;
 		vbv.StrideInBytes = VertexByteStride;
 		vbv.SizeInBytes = VertexBufferByteSize;
 
@@ -195,7 +257,7 @@ struct MeshGeometry
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView()const
 	{
 		D3D12_INDEX_BUFFER_VIEW ibv;
-		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
+		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress() + IndexBufferOffset;
 		ibv.Format = IndexFormat;
 		ibv.SizeInBytes = IndexBufferByteSize;
 
@@ -208,6 +270,27 @@ struct MeshGeometry
 		VertexBufferUploader = nullptr;
 		IndexBufferUploader = nullptr;
 	}
+
+	// Applies CpuPolicy; call once the buffers have been uploaded.
+	void ReleaseCpuGeometry()
+	{
+		if(CpuPolicy == CpuGeometryPolicy::Keep)
+			return;
+
+		VertexBufferCPU = nullptr;
+		IndexBufferCPU = nullptr;
+	}
+
+	// Bytes of the system memory copy currently held, mapped or not.
+	UINT64 GetCpuResidentBytes()const
+	{
+		UINT64 byteSize = 0;
+		if(VertexBufferCPU != nullptr)
+			byteSize += VertexBufferCPU->GetBufferSize();
+		if(IndexBufferCPU != nullptr)
+			byteSize += IndexBufferCPU->GetBufferSize();
+		return byteSize;
+	}
 };
 
 struct Light
@@ -270,6 +353,9 @@ struct Texture
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap = nullptr;
+
+	// TextureCache handle of Resource, if it came from the cache.
+	std::uint32_t CacheHandle = 0xffffffff;
 };
 
 #ifndef ThrowIfFailed
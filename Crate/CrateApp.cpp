@@ -6,6 +6,7 @@
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/TextureStreamerD3D12.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -17,6 +18,9 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
+// Memory the streamed textures may use.  The crate texture needs about 350 KB with every mip.
+const std::uint64_t gTextureBudget = 64 * 1024 * 1024;
+
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
 struct RenderItem
@@ -76,6 +80,7 @@ private:
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
+	void RequestTextureMips(const GameTimer& gt);
 
 	void LoadTextures();
     void BuildRootSignature();
@@ -104,9 +109,12 @@ private:
 
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
-	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 
+	std::unique_ptr<TextureStreamerD3D12> mTextureBackend;
+	std::unique_ptr<TextureStreamer> mTextureStreamer;
+	std::uint32_t mWoodCrateTex = TextureStreamer::InvalidHandle;
+
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
 
     ComPtr<ID3D12PipelineState> mOpaquePSO = nullptr;
@@ -123,6 +131,9 @@ private:
 	XMFLOAT4X4 mView = MathHelper::Identity4x4();
 	XMFLOAT4X4 mProj = MathHelper::Identity4x4();
 
+	// Vertical field of view of mProj.
+	float mFovY = 0.25f*MathHelper::Pi;
+
 	float mTheta = 1.3f*XM_PI;
 	float mPhi = 0.4f*XM_PI;
 	float mRadius = 2.5f;
@@ -177,9 +188,9 @@ bool CrateApp::Initialize()
     mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
  
-	LoadTextures();
     BuildRootSignature();
 	BuildDescriptorHeaps();
+	LoadTextures();
     BuildShadersAndInputLayout();
     BuildShapeGeometry();
 	BuildMaterials();
@@ -203,7 +214,7 @@ void CrateApp::OnResize()
     D3DApp::OnResize();
 
     // The window resized, so update the aspect ratio and recompute the projection matrix.
-    XMMATRIX P = XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
+    XMMATRIX P = XMMatrixPerspectiveFovLH(mFovY, AspectRatio(), 1.0f, 1000.0f);
     XMStoreFloat4x4(&mProj, P);
 }
 
@@ -230,6 +241,7 @@ void CrateApp::Update(const GameTimer& gt)
 	UpdateObjectCBs(gt);
 	UpdateMaterialCBs(gt);
 	UpdateMainPassCB(gt);
+	RequestTextureMips(gt);
 }
 
 void CrateApp::Draw(const GameTimer& gt)
@@ -244,6 +256,12 @@ void CrateApp::Draw(const GameTimer& gt)
     // Reusing the command list reuses memory.
     ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mOpaquePSO.Get()));
 
+	// Page in the mips requested in Update().  The copies are recorded ahead of the draws,
+	// and this frame binds whichever SRV now holds the crate texture.
+	mTextureBackend->BeginFrame(mCommandList.Get(), mCurrentFence + 1, mFence->GetCompletedValue());
+	mTextureStreamer->Update();
+	mMaterials["woodCrate"]->DiffuseSrvHeapIndex = mTextureBackend->GetSrvIndex(mWoodCrateTex);
+
     mCommandList->RSSetViewports(1, &mScreenViewport);
     mCommandList->RSSetScissorRects(1, &mScissorRect);
 
@@ -447,16 +465,25 @@ void CrateApp::UpdateMainPassCB(const GameTimer& gt)
 	currPassCB->CopyData(0, mMainPassCB);
 }
 
+void CrateApp::RequestTextureMips(const GameTimer& gt)
+{
+	// The crate is a unit cube at the origin and each face shows the whole texture, so
+	// the nearest face is about as many pixels high as one unit at its distance.
+	float distance = std::max<float>(mRadius - 0.5f, 1.0f);
+	float pixels = mClientHeight / (2.0f*distance*tanf(0.5f*mFovY));
+
+	mTextureStreamer->RequestMip(mWoodCrateTex, mTextureStreamer->SelectMip(mWoodCrateTex, pixels));
+}
+
 void CrateApp::LoadTextures()
 {
-	auto woodCrateTex = std::make_unique<Texture>();
-	woodCrateTex->Name = "woodCrateTex";
-	woodCrateTex->Filename = L"../Textures/WoodCrate01.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), woodCrateTex->Filename.c_str(),
-		woodCrateTex->Resource, woodCrateTex->UploadHeap));
- 
-	mTextures[woodCrateTex->Name] = std::move(woodCrateTex);
+	// Only the mip tail is uploaded here; the finer mips are streamed in by Draw() as
+	// RequestTextureMips() asks for them.
+	mTextureBackend->BeginFrame(mCommandList.Get(), mCurrentFence + 1, mFence->GetCompletedValue());
+
+	mWoodCrateTex = mTextureStreamer->Add(L"../Textures/WoodCrate01.dds");
+	if(mWoodCrateTex == TextureStreamer::InvalidHandle)
+		ThrowIfFailed(E_FAIL);
 }
 
 void CrateApp::BuildRootSignature()
@@ -502,30 +529,20 @@ void CrateApp::BuildRootSignature()
 void CrateApp::BuildDescriptorHeaps()
 {
 	//
-	// Create the SRV heap.
+	// Create the SRV heap.  The texture streamer writes the descriptors; it needs several
+	// per texture so frames in flight keep their view while a new mip chain is swapped in.
 	//
+	const UINT streamedTextureCount = 1;
+
 	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = 1;
+	srvHeapDesc.NumDescriptors = TextureStreamerD3D12::GetDescriptorCount(streamedTextureCount, gNumFrameResources);
 	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap)));
 
-	//
-	// Fill out the heap with actual descriptors.
-	//
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
-	auto woodCrateTex = mTextures["woodCrateTex"]->Resource;
- 
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Format = woodCrateTex->GetDesc().Format;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = woodCrateTex->GetDesc().MipLevels;
-	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-
-	md3dDevice->CreateShaderResourceView(woodCrateTex.Get(), &srvDesc, hDescriptor);
+	mTextureBackend = std::make_unique<TextureStreamerD3D12>(md3dDevice.Get(),
+		mSrvDescriptorHeap.Get(), 0, streamedTextureCount, gNumFrameResources);
+	mTextureStreamer = std::make_unique<TextureStreamer>(*mTextureBackend, gTextureBudget);
 }
 
 void CrateApp::BuildShadersAndInputLayout()
@@ -6,6 +6,7 @@
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/TextureBatchLoader.h"
 #include "FrameResource.h"
 
 using Microsoft::WRL::ComPtr;
@@ -106,6 +107,7 @@ private:
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+	TextureCache mTextureCache;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
@@ -117,6 +119,9 @@ private:
 	// Render items divided by PSO.
 	std::vector<RenderItem*> mOpaqueRitems;
 
+	// Object constants by ObjCBIndex, as last built.
+	std::vector<ObjectConstants> mObjectConstants;
+
     PassConstants mMainPassCB;
 
 	XMFLOAT3 mEyePos = { 0.0f, 0.0f, 0.0f };
@@ -195,6 +200,8 @@ bool TexColumnsApp::Initialize()
     // Wait until initialization is complete.
     FlushCommandQueue();
 
+    mTextureCache.ReleaseCompleted(mFence->GetCompletedValue());
+
     return true;
 }
  
@@ -365,6 +372,12 @@ void TexColumnsApp::AnimateMaterials(const GameTimer& gt)
 void TexColumnsApp::UpdateObjectCBs(const GameTimer& gt)
 {
 	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
+
+	// Build the dirty objects in place, by ObjCBIndex, and copy the range they span in
+	// one call.  The buffer's change tracking skips the clean objects inside the range.
+	mObjectConstants.resize(mAllRitems.size());
+	UINT firstDirty = UINT_MAX;
+	UINT lastDirty = 0;
 	for(auto& e : mAllRitems)
 	{
 		// Only update the cbuffer data if the constants have changed.  
@@ -374,16 +387,20 @@ void TexColumnsApp::UpdateObjectCBs(const GameTimer& gt)
 			XMMATRIX world = XMLoadFloat4x4(&e->World);
 			XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
 
-			ObjectConstants objConstants;
+			ObjectConstants& objConstants = mObjectConstants[e->ObjCBIndex];
 			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
 			XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
 
-			currObjectCB->CopyData(e->ObjCBIndex, objConstants);
+			firstDirty = std::min<UINT>(firstDirty, e->ObjCBIndex);
+			lastDirty = std::max<UINT>(lastDirty, e->ObjCBIndex);
 
 			// Next FrameResource need to be updated too.
 			e->NumFramesDirty--;
 		}
 	}
+
+	if(firstDirty <= lastDirty)
+		currObjectCB->CopyRange(firstDirty, &mObjectConstants[firstDirty], lastDirty - firstDirty + 1);
 }
 
 void TexColumnsApp::UpdateMaterialCBs(const GameTimer& gt)
@@ -449,30 +466,16 @@ void TexColumnsApp::UpdateMainPassCB(const GameTimer& gt)
 
 void TexColumnsApp::LoadTextures()
 {
-	auto bricksTex = std::make_unique<Texture>();
-	bricksTex->Name = "bricksTex";
-	bricksTex->Filename = L"../Textures/bricks.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), bricksTex->Filename.c_str(),
-		bricksTex->Resource, bricksTex->UploadHeap));
-
-	auto stoneTex = std::make_unique<Texture>();
-	stoneTex->Name = "stoneTex";
-	stoneTex->Filename = L"../Textures/stone.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), stoneTex->Filename.c_str(),
-		stoneTex->Resource, stoneTex->UploadHeap));
-
-	auto tileTex = std::make_unique<Texture>();
-	tileTex->Name = "tileTex";
-	tileTex->Filename = L"../Textures/tile.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), tileTex->Filename.c_str(),
-		tileTex->Resource, tileTex->UploadHeap));
-
-	mTextures[bricksTex->Name] = std::move(bricksTex);
-	mTextures[stoneTex->Name] = std::move(stoneTex);
-	mTextures[tileTex->Name] = std::move(tileTex);
+	std::vector<TextureLoadEntry> textures =
+	{
+		{ "bricksTex", L"../Textures/bricks.dds" },
+		{ "stoneTex", L"../Textures/stone.dds" },
+		{ "tileTex", L"../Textures/tile.dds" },
+	};
+
+	auto report = TextureBatchLoader::Load(md3dDevice.Get(), mCommandList.Get(), mCurrentFence + 1,
+		textures, mTextures, mTextureCache);
+	OutputDebugString(report.ToString().c_str());
 }
 
 void TexColumnsApp::BuildRootSignature()
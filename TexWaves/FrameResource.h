@@ -2,7 +2,7 @@
 
 #include "../Common/d3dUtil.h"
 #include "../Common/MathHelper.h"
-#include "../Common/UploadBuffer.h"
+#include "../Common/FrameArena.h"
 
 struct ObjectConstants
 {
@@ -49,7 +49,7 @@ struct FrameResource
 {
 public:
     
-    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount);
+    FrameResource(ID3D12Device* device);
     FrameResource(const FrameResource& rhs) = delete;
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
@@ -58,16 +58,18 @@ public:
     // So each frame needs their own allocator.
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
-    // We cannot update a cbuffer until the GPU is done processing the commands
-    // that reference it.  So each frame needs their own cbuffers.
-   // std::unique_ptr<UploadBuffer<FrameConstants>> FrameCB = nullptr;
-    std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
-    std::unique_ptr<UploadBuffer<MaterialConstants>> MaterialCB = nullptr;
-    std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
+    // We cannot update a cbuffer or dynamic vertex buffer until the GPU is done processing
+    // the commands that reference it.  So each frame writes its own into the upload ring,
+    // which keeps them until the GPU passes this frame's fence.  ObjectData and MaterialData
+    // are packed structured buffers indexed by ObjCBIndex and MatCBIndex.
+    D3D12_GPU_VIRTUAL_ADDRESS PassCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS MaterialData = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS ObjectData = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS WavesVB = 0;
 
-    // We cannot update a dynamic vertex buffer until the GPU is done processing
-    // the commands that reference it.  So each frame needs their own.
-    std::unique_ptr<UploadBuffer<Vertex>> WavesVB = nullptr;
+    // CPU scratch memory of the frame (draw lists and the like), reset with the
+    // command allocator once the GPU is done with the frame.
+    FrameArena Arena;
 
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
@@ -4,8 +4,13 @@
 
 #include "../Common/d3dApp.h"
 #include "../Common/MathHelper.h"
-#include "../Common/UploadBuffer.h"
+#include "../Common/BufferMemoryD3D12.h"
+#include "../Common/GeometryHeap.h"
+#include "../Common/UploadRing.h"
+#include "../Common/StructuredBufferBuilder.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/TextureBatchLoader.h"
+#include "../Common/FramePacer.h"
 #include "FrameResource.h"
 #include "Waves.h"
 
@@ -16,7 +21,18 @@ using namespace DirectX::PackedVector;
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "D3D12.lib")
 
-const int gNumFrameResources = 3;
+// Frame resources allocated; mFramePacer decides how many of them are cycled through.
+// Material::NumFramesDirty starts at this, so a material reaches every one of them.
+const int gNumFrameResources = FramePacer::MaxDepth;
+
+// UploadRing returns a null CPU pointer when it cannot grow.  A frame cannot be drawn
+// without its constants and vertices, so treat that like any failed allocation.
+UploadAllocation CheckUpload(const UploadAllocation& allocation)
+{
+	if(allocation.CPU == nullptr)
+		ThrowIfFailed(E_OUTOFMEMORY);
+	return allocation;
+}
 
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
@@ -31,13 +47,7 @@ struct RenderItem
 
 	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
 
-	// Dirty flag indicating the object data has changed and we need to update the constant buffer.
-	// Because we have an object cbuffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify obect data we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	int NumFramesDirty = gNumFrameResources;
-
-	// Index into GPU constant buffer corresponding to the ObjectCB for this render item.
+	// Index into the frame's object data array corresponding to this render item.
 	UINT ObjCBIndex = -1;
 
 	Material* Mat = nullptr;
@@ -96,7 +106,7 @@ private:
     void BuildFrameResources();
     void BuildMaterials();
     void BuildRenderItems();
-    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const FrameVector<RenderItem*>& ritems);
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers();
 
@@ -109,15 +119,34 @@ private:
     FrameResource* mCurrFrameResource = nullptr;
     int mCurrFrameResourceIndex = 0;
 
+	// Number of frames in flight: keys 1-4 fix it, P toggles the adaptive mode.
+	FramePacer mFramePacer;
+	bool mAdaptiveKeyDown = false;
+
+	// Per-frame constants and dynamic vertices; the memory must outlive the ring.
+	// HostBufferMemory in place of BufferMemoryD3D12 runs the Update*() code headless.
+	std::unique_ptr<BufferMemoryBackend> mUploadMemory;
+	std::unique_ptr<UploadRing> mUploadRing;
+
+	// Object and material data, built here each frame and uploaded packed.
+	StructuredBufferBuilder<ObjectConstants> mObjectData;
+	StructuredBufferBuilder<MaterialConstants> mMaterialData;
+
     UINT mCbvSrvDescriptorSize = 0;
 
     ComPtr<ID3D12RootSignature> mRootSignature = nullptr;
 
 	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
 
+	// Vertex and index buffers of mGeometries, packed into placed buffers and
+	// uploaded together.
+	std::unique_ptr<GeometryHeap> mGeometryHeap;
+	std::unique_ptr<StagingManager> mStaging;
+
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+	TextureCache mTextureCache;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
@@ -144,6 +173,9 @@ private:
     float mRadius = 50.0f;
 
     POINT mLastMousePos;
+
+	// M writes MemoryTracker's report to MemoryReport.json, once per press.
+	bool mReportKeyDown = false;
 };
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
@@ -193,6 +225,8 @@ bool TexWavesApp::Initialize()
     mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
     mWaves = std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+    mGeometryHeap = std::make_unique<GeometryHeap>(md3dDevice.Get(), 1024*1024);
+    mStaging = std::make_unique<StagingManager>(md3dDevice.Get());
  
 	LoadTextures();
     BuildRootSignature();
@@ -206,6 +240,9 @@ bool TexWavesApp::Initialize()
     BuildFrameResources();
     BuildPSOs();
 
+    // Record the geometry uploads; FlushCommandQueue() signals the next fence value.
+    mStaging->Flush(mCommandList.Get(), mCurrentFence + 1);
+
     // Execute the initialization commands.
     ThrowIfFailed(mCommandList->Close());
     ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
@@ -214,6 +251,15 @@ bool TexWavesApp::Initialize()
     // Wait until initialization is complete.
     FlushCommandQueue();
 
+    mStaging->ReleaseCompleted(mFence->GetCompletedValue());
+    mTextureCache.ReleaseCompleted(mFence->GetCompletedValue());
+
+    StagingManager::Stats staging = mStaging->GetStats();
+    std::wstring text = L"Staging: " + std::to_wstring(staging.CopyCount) + L" copies, " +
+        std::to_wstring(staging.BarrierCount) + L" barriers, peak " +
+        std::to_wstring(staging.PeakBytes / 1024) + L" KB\n";
+    OutputDebugString(text.c_str());
+
     return true;
 }
  
@@ -231,12 +277,13 @@ void TexWavesApp::Update(const GameTimer& gt)
     OnKeyboardInput(gt);
 	UpdateCamera(gt);
 
-    // Cycle through the circular frame resource array.
-    mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % gNumFrameResources;
+    // Cycle through the first mFramePacer.GetDepth() frame resources.
+    mCurrFrameResourceIndex = mFramePacer.BeginFrame();
     mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
 
     // Has the GPU finished processing the commands of the current frame resource?
     // If not, wait until the GPU has completed commands up to this fence point.
+    mFramePacer.BeginFenceWait();
     if(mCurrFrameResource->Fence != 0 && mFence->GetCompletedValue() < mCurrFrameResource->Fence)
     {
         HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
@@ -244,6 +291,13 @@ void TexWavesApp::Update(const GameTimer& gt)
         WaitForSingleObject(eventHandle, INFINITE);
         CloseHandle(eventHandle);
     }
+    mFramePacer.EndFenceWait();
+
+	// Frames the GPU has finished give their upload memory back.
+	mUploadRing->BeginFrame(mFence->GetCompletedValue());
+
+	// Nothing from the last use of this frame resource is in flight any more.
+	mCurrFrameResource->Arena.Reset();
 
 	AnimateMaterials(gt);
 	UpdateObjectCBs(gt);
@@ -283,10 +337,22 @@ void TexWavesApp::Draw(const GameTimer& gt)
 
 	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
-	auto passCB = mCurrFrameResource->PassCB->Resource();
-	mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
+	mCommandList->SetGraphicsRootConstantBufferView(2, mCurrFrameResource->PassCB);
+	mCommandList->SetGraphicsRootShaderResourceView(3, mCurrFrameResource->ObjectData);
+	mCommandList->SetGraphicsRootShaderResourceView(4, mCurrFrameResource->MaterialData);
+
+	// This frame's draw list, ordered by texture so the table is only set when it changes.
+	// It lives in the frame's arena, so building it does not touch the heap.
+	const auto& opaqueLayer = mRitemLayer[(int)RenderLayer::Opaque];
+	FrameVector<RenderItem*> opaqueRitems(FrameAllocator<RenderItem*>(mCurrFrameResource->Arena));
+	opaqueRitems.reserve(opaqueLayer.size());
+	opaqueRitems.assign(opaqueLayer.begin(), opaqueLayer.end());
+	std::sort(opaqueRitems.begin(), opaqueRitems.end(), [](const RenderItem* a, const RenderItem* b)
+	{
+		return a->Mat->DiffuseSrvHeapIndex < b->Mat->DiffuseSrvHeapIndex;
+	});
 
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+    DrawRenderItems(mCommandList.Get(), opaqueRitems);
 
     // Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
@@ -305,11 +371,21 @@ void TexWavesApp::Draw(const GameTimer& gt)
 
     // Advance the fence value to mark commands up to this fence point.
     mCurrFrameResource->Fence = ++mCurrentFence;
+	mUploadRing->EndFrame(mCurrentFence);
 
     // Add an instruction to the command queue to set a new fence point. 
     // Because we are on the GPU timeline, the new fence point won't be 
     // set until the GPU finishes processing all the commands prior to this Signal().
     mCommandQueue->Signal(mFence.Get(), mCurrentFence);
+
+	if(mFramePacer.EndFrame())
+	{
+		FramePacer::Stats stats = mFramePacer.GetStats();
+		std::wstring text = L"Frames in flight: " + std::to_wstring(mFramePacer.GetDepth()) +
+			L" (fence wait " + std::to_wstring(stats.FenceWaitMs) + L" ms, CPU " +
+			std::to_wstring(stats.CpuMs) + L" ms, average " + std::to_wstring(stats.AverageCpuMs) + L" ms)\n";
+		OutputDebugString(text.c_str());
+	}
 }
 
 void TexWavesApp::OnMouseDown(WPARAM btnState, int x, int y)
@@ -359,6 +435,21 @@ void TexWavesApp::OnMouseMove(WPARAM btnState, int x, int y)
  
 void TexWavesApp::OnKeyboardInput(const GameTimer& gt)
 {
+	const bool reportKeyDown = d3dUtil::IsKeyDown('M');
+	if(reportKeyDown && !mReportKeyDown)
+		MemoryTracker::WriteJson(L"MemoryReport.json");
+	mReportKeyDown = reportKeyDown;
+
+	for(int depth = FramePacer::MinDepth; depth <= FramePacer::MaxDepth; ++depth)
+	{
+		if(d3dUtil::IsKeyDown('0' + depth))
+			mFramePacer.SetDepth(depth);
+	}
+
+	const bool adaptiveKeyDown = d3dUtil::IsKeyDown('P');
+	if(adaptiveKeyDown && !mAdaptiveKeyDown)
+		mFramePacer.SetAdaptive(!mFramePacer.IsAdaptive());
+	mAdaptiveKeyDown = adaptiveKeyDown;
 }
  
 void TexWavesApp::UpdateCamera(const GameTimer& gt)
@@ -396,59 +487,41 @@ void TexWavesApp::AnimateMaterials(const GameTimer& gt)
 
 	waterMat->MatTransform(3, 0) = tu;
 	waterMat->MatTransform(3, 1) = tv;
-
-	// Material has changed, so need to update cbuffer.
-	waterMat->NumFramesDirty = gNumFrameResources;
 }
 
 void TexWavesApp::UpdateObjectCBs(const GameTimer& gt)
 {
-	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
+	// The ring hands out fresh memory every frame, so every object is written every frame.
+	mObjectData.Resize(mAllRitems.size());
 	for(auto& e : mAllRitems)
 	{
-		// Only update the cbuffer data if the constants have changed.  
-		// This needs to be tracked per frame resource.
-		if(e->NumFramesDirty > 0)
-		{
-			XMMATRIX world = XMLoadFloat4x4(&e->World);
-			XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
+		XMMATRIX world = XMLoadFloat4x4(&e->World);
+		XMMATRIX texTransform = XMLoadFloat4x4(&e->TexTransform);
 
-			ObjectConstants objConstants;
-			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
-			XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
-
-			currObjectCB->CopyData(e->ObjCBIndex, objConstants);
-
-			// Next FrameResource need to be updated too.
-			e->NumFramesDirty--;
-		}
+		ObjectConstants& objConstants = mObjectData[e->ObjCBIndex];
+		XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
+		XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
 	}
+
+	mCurrFrameResource->ObjectData = CheckUpload(mObjectData.Upload(*mUploadRing)).GPU;
 }
 
 void TexWavesApp::UpdateMaterialCBs(const GameTimer& gt)
 {
-	auto currMaterialCB = mCurrFrameResource->MaterialCB.get();
+	mMaterialData.Resize(mMaterials.size());
 	for(auto& e : mMaterials)
 	{
-		// Only update the cbuffer data if the constants have changed.  If the cbuffer
-		// data changes, it needs to be updated for each FrameResource.
 		Material* mat = e.second.get();
-		if(mat->NumFramesDirty > 0)
-		{
-			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
-
-			MaterialConstants matConstants;
-			matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
-			matConstants.FresnelR0 = mat->FresnelR0;
-			matConstants.Roughness = mat->Roughness;
-			XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
+		XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
 
-			currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
-
-			// Next FrameResource need to be updated too.
-			mat->NumFramesDirty--;
-		}
+		MaterialConstants& matConstants = mMaterialData[mat->MatCBIndex];
+		matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
+		matConstants.FresnelR0 = mat->FresnelR0;
+		matConstants.Roughness = mat->Roughness;
+		XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
 	}
+
+	mCurrFrameResource->MaterialData = CheckUpload(mMaterialData.Upload(*mUploadRing)).GPU;
 }
 
 void TexWavesApp::UpdateMainPassCB(const GameTimer& gt)
@@ -482,8 +555,7 @@ void TexWavesApp::UpdateMainPassCB(const GameTimer& gt)
 	mMainPassCB.Lights[2].Direction = { 0.0f, -0.707f, -0.707f };
 	mMainPassCB.Lights[2].Strength = { 0.2f, 0.2f, 0.2f };
 
-	auto currPassCB = mCurrFrameResource->PassCB.get();
-	currPassCB->CopyData(0, mMainPassCB);
+	mCurrFrameResource->PassCB = CheckUpload(mUploadRing->AllocateConstants(mMainPassCB)).GPU;
 }
 
 void TexWavesApp::UpdateWaves(const GameTimer& gt)
@@ -506,7 +578,8 @@ void TexWavesApp::UpdateWaves(const GameTimer& gt)
 	mWaves->Update(gt.DeltaTime());
 
 	// Update the wave vertex buffer with the new solution.
-	auto currWavesVB = mCurrFrameResource->WavesVB.get();
+	UploadAllocation wavesVB = CheckUpload(mUploadRing->Allocate(sizeof(Vertex) * mWaves->VertexCount()));
+	Vertex* currWavesVB = reinterpret_cast<Vertex*>(wavesVB.CPU);
 	for(int i = 0; i < mWaves->VertexCount(); ++i)
 	{
 		Vertex v;
@@ -519,39 +592,25 @@ void TexWavesApp::UpdateWaves(const GameTimer& gt)
 		v.TexC.x = 0.5f + v.Pos.x / mWaves->Width();
 		v.TexC.y = 0.5f - v.Pos.z / mWaves->Depth();
 
-		currWavesVB->CopyData(i, v);
+		currWavesVB[i] = v;
 	}
 
-	// Set the dynamic VB of the wave renderitem to the current frame VB.
-	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
+	// The wave renderitem draws from the current frame VB.
+	mCurrFrameResource->WavesVB = wavesVB.GPU;
 }
 
 void TexWavesApp::LoadTextures()
 {
-	auto grassTex = std::make_unique<Texture>();
-	grassTex->Name = "grassTex";
-	grassTex->Filename = L"../Textures/grass.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), grassTex->Filename.c_str(),
-		grassTex->Resource, grassTex->UploadHeap));
-
-	auto waterTex = std::make_unique<Texture>();
-	waterTex->Name = "waterTex";
-	waterTex->Filename = L"../Textures/water1.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), waterTex->Filename.c_str(),
-		waterTex->Resource, waterTex->UploadHeap));
-
-	auto fenceTex = std::make_unique<Texture>();
-	fenceTex->Name = "fenceTex";
-	fenceTex->Filename = L"../Textures/WoodCrate01.dds";
-	ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(),
-		mCommandList.Get(), fenceTex->Filename.c_str(),
-		fenceTex->Resource, fenceTex->UploadHeap));
-
-	mTextures[grassTex->Name] = std::move(grassTex);
-	mTextures[waterTex->Name] = std::move(waterTex);
-	mTextures[fenceTex->Name] = std::move(fenceTex);
+	std::vector<TextureLoadEntry> textures =
+	{
+		{ "grassTex", L"../Textures/grass.dds" },
+		{ "waterTex", L"../Textures/water1.dds" },
+		{ "fenceTex", L"../Textures/WoodCrate01.dds" },
+	};
+
+	auto report = TextureBatchLoader::Load(md3dDevice.Get(), mCommandList.Get(), mCurrentFence + 1,
+		textures, mTextures, mTextureCache);
+	OutputDebugString(report.ToString().c_str());
 }
 
 void TexWavesApp::BuildRootSignature()
@@ -560,18 +619,21 @@ void TexWavesApp::BuildRootSignature()
 	texTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
 
     // Root parameter can be a table, root descriptor or root constants.
-    CD3DX12_ROOT_PARAMETER slotRootParameter[4];
+    CD3DX12_ROOT_PARAMETER slotRootParameter[5];
 
 	// Perfomance TIP: Order from most frequent to least frequent.
+	// The object and material indices are root constants; their data are structured
+	// buffers bound once per frame.
 	slotRootParameter[0].InitAsDescriptorTable(1, &texTable, D3D12_SHADER_VISIBILITY_PIXEL);
-    slotRootParameter[1].InitAsConstantBufferView(0);
+    slotRootParameter[1].InitAsConstants(2, 0);
     slotRootParameter[2].InitAsConstantBufferView(1);
-    slotRootParameter[3].InitAsConstantBufferView(2);
+    slotRootParameter[3].InitAsShaderResourceView(1);
+    slotRootParameter[4].InitAsShaderResourceView(2);
 
 	auto staticSamplers = GetStaticSamplers();
 
     // A root signature is an array of root parameters.
-	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(4, slotRootParameter,
+	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(5, slotRootParameter,
 		(UINT)staticSamplers.size(), staticSamplers.data(),
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -677,17 +739,19 @@ void TexWavesApp::BuildLandGeometry()
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "landGeo";
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+	geo->VertexBufferCPU = d3dUtil::CreateTrackedBlob(vbByteSize, MemoryTag::GeometryCpu);
 	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+	geo->IndexBufferCPU = d3dUtil::CreateTrackedBlob(ibByteSize, MemoryTag::GeometryCpu);
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+	GeometryBuffer vb = mGeometryHeap->CreateBuffer(*mStaging, vertices.data(), vbByteSize);
+	geo->VertexBufferGPU = vb.Resource;
+	geo->VertexBufferOffset = vb.Offset;
 
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+	GeometryBuffer ib = mGeometryHeap->CreateBuffer(*mStaging, indices.data(), ibByteSize);
+	geo->IndexBufferGPU = ib.Resource;
+	geo->IndexBufferOffset = ib.Offset;
 
 	geo->VertexByteStride = sizeof(Vertex);
 	geo->VertexBufferByteSize = vbByteSize;
@@ -739,11 +803,12 @@ void TexWavesApp::BuildWavesGeometry()
 	geo->VertexBufferCPU = nullptr;
 	geo->VertexBufferGPU = nullptr;
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+	geo->IndexBufferCPU = d3dUtil::CreateTrackedBlob(ibByteSize, MemoryTag::GeometryCpu);
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+	GeometryBuffer ib = mGeometryHeap->CreateBuffer(*mStaging, indices.data(), ibByteSize);
+	geo->IndexBufferGPU = ib.Resource;
+	geo->IndexBufferOffset = ib.Offset;
 
 	geo->VertexByteStride = sizeof(Vertex);
 	geo->VertexBufferByteSize = vbByteSize;
@@ -782,17 +847,19 @@ void TexWavesApp::BuildBoxGeometry()
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "boxGeo";
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+	geo->VertexBufferCPU = d3dUtil::CreateTrackedBlob(vbByteSize, MemoryTag::GeometryCpu);
 	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+	geo->IndexBufferCPU = d3dUtil::CreateTrackedBlob(ibByteSize, MemoryTag::GeometryCpu);
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+	GeometryBuffer vb = mGeometryHeap->CreateBuffer(*mStaging, vertices.data(), vbByteSize);
+	geo->VertexBufferGPU = vb.Resource;
+	geo->VertexBufferOffset = vb.Offset;
 
-	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+	GeometryBuffer ib = mGeometryHeap->CreateBuffer(*mStaging, indices.data(), ibByteSize);
+	geo->IndexBufferGPU = ib.Resource;
+	geo->IndexBufferOffset = ib.Offset;
 
 	geo->VertexByteStride = sizeof(Vertex);
 	geo->VertexBufferByteSize = vbByteSize;
@@ -846,9 +913,18 @@ void TexWavesApp::BuildFrameResources()
 {
     for(int i = 0; i < gNumFrameResources; ++i)
     {
-        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
-            1, (UINT)mAllRitems.size(), (UINT)mMaterials.size(), mWaves->VertexCount()));
+        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get()));
     }
+
+	// Start with room for every frame in flight; the ring grows if a frame needs more.
+	UINT64 frameByteSize =
+		d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants)) +
+		d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants) * mAllRitems.size()) +
+		d3dUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants) * mMaterials.size()) +
+		d3dUtil::CalcConstantBufferByteSize(sizeof(Vertex) * mWaves->VertexCount());
+
+	mUploadMemory = std::make_unique<BufferMemoryD3D12>(md3dDevice.Get());
+	mUploadRing = std::make_unique<UploadRing>(*mUploadMemory, frameByteSize * gNumFrameResources);
 }
 
 void TexWavesApp::BuildMaterials()
@@ -931,32 +1007,41 @@ void TexWavesApp::BuildRenderItems()
 	mAllRitems.push_back(std::move(boxRitem));
 }
 
-void TexWavesApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+void TexWavesApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const FrameVector<RenderItem*>& ritems)
 {
-    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-    UINT matCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants));
-
-	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
-	auto matCB = mCurrFrameResource->MaterialCB->Resource();
+	int boundSrvHeapIndex = -1;
 
     // For each render item...
     for(size_t i = 0; i < ritems.size(); ++i)
     {
         auto ri = ritems[i];
 
-        cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
+		D3D12_VERTEX_BUFFER_VIEW vbv;
+		if(ri == mWavesRitem)
+		{
+			vbv.BufferLocation = mCurrFrameResource->WavesVB;
+			vbv.StrideInBytes = ri->Geo->VertexByteStride;
+			vbv.SizeInBytes = ri->Geo->VertexBufferByteSize;
+		}
+		else
+		{
+			vbv = ri->Geo->VertexBufferView();
+		}
+
+        cmdList->IASetVertexBuffers(0, 1, &vbv);
         cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
         cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
 
-		CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-		tex.Offset(ri->Mat->DiffuseSrvHeapIndex, mCbvSrvDescriptorSize);
-
-        D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB->GetGPUVirtualAddress() + ri->ObjCBIndex*objCBByteSize;
-		D3D12_GPU_VIRTUAL_ADDRESS matCBAddress = matCB->GetGPUVirtualAddress() + ri->Mat->MatCBIndex*matCBByteSize;
+		if(ri->Mat->DiffuseSrvHeapIndex != boundSrvHeapIndex)
+		{
+			CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+			tex.Offset(ri->Mat->DiffuseSrvHeapIndex, mCbvSrvDescriptorSize);
 
-		cmdList->SetGraphicsRootDescriptorTable(0, tex);
-        cmdList->SetGraphicsRootConstantBufferView(1, objCBAddress);
-        cmdList->SetGraphicsRootConstantBufferView(3, matCBAddress);
+			cmdList->SetGraphicsRootDescriptorTable(0, tex);
+			boundSrvHeapIndex = ri->Mat->DiffuseSrvHeapIndex;
+		}
+        cmdList->SetGraphicsRoot32BitConstant(1, ri->ObjCBIndex, 0);
+        cmdList->SetGraphicsRoot32BitConstant(1, ri->Mat->MatCBIndex, 1);
 
         cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
     }
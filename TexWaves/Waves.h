@@ -11,6 +11,7 @@
 
 #include <vector>
 #include <DirectXMath.h>
+#include "../Common/MemoryTracker.h"
 
 class Waves
 {
@@ -40,6 +41,9 @@ public:
 	void Disturb(int i, int j, float magnitude);
 
 private:
+    // The grids show up in MemoryTracker under MemoryTag::Waves.
+    typedef std::vector<DirectX::XMFLOAT3, TrackingAllocator<DirectX::XMFLOAT3, MemoryTag::Waves>> Grid;
+
     int mNumRows = 0;
     int mNumCols = 0;
 
@@ -54,10 +58,10 @@ private:
     float mTimeStep = 0.0f;
     float mSpatialStep = 0.0f;
 
-    std::vector<DirectX::XMFLOAT3> mPrevSolution;
-    std::vector<DirectX::XMFLOAT3> mCurrSolution;
-    std::vector<DirectX::XMFLOAT3> mNormals;
-    std::vector<DirectX::XMFLOAT3> mTangentX;
+    Grid mPrevSolution;
+    Grid mCurrSolution;
+    Grid mNormals;
+    Grid mTangentX;
 };
 
 #endif // WAVES_H
\ No newline at end of file
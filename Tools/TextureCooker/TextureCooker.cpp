@@ -0,0 +1,344 @@
+//***************************************************************************************
+// TextureCooker.cpp
+//
+// Command line tool that converts BMP files and uncompressed DDS files into block
+// compressed DDS files with full mip chains.
+//
+//   TextureCooker [-o outdir] [-f auto|bc1|bc3|bc7] [-srgb] [-nomips] [-kaiser] [-ktx2] files...
+//
+//   -o       Directory of the cooked files; by default they go next to the inputs.
+//            Inputs that are DDS files need it, since the output has the same name.
+//   -f       Target format.  auto (the default) picks BC1 for opaque images and BC3
+//            for images with alpha; bc7 gives the best quality for opaque images.
+//   -srgb    The images hold sRGB colors: filter the mips in linear space and write
+//            an _SRGB format.  Implied by _SRGB inputs.
+//   -nomips  Keep only the top mip.
+//   -kaiser  Use the Kaiser filter for the mips instead of the box filter.
+//   -ktx2    Write KTX2 files whose mip levels are zlib compressed, which KTXParser
+//            inflates at load time.  Block compressed DDS files are repackaged as
+//            they are.  The reported output size is then that of the whole file.
+//
+// Files are cooked concurrently on TaskPool::Default(), and the mip filtering and block
+// compression of each file are split further over the same pool.  DDS files that are
+// already block compressed are skipped, unless -ktx2 is given.  KTX2 files are read
+// like DDS files.
+//***************************************************************************************
+
+#include "../../Common/BCEncoder.h"
+#include "../../Common/BMPReader.h"
+#include "../../Common/DDSWriter.h"
+#include "../../Common/FileUtil.h"
+#include "../../Common/KTXWriter.h"
+#include "../../Common/MipGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cwctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	enum class TargetFormat
+	{
+		Auto,
+		BC1,
+		BC3,
+		BC7,
+	};
+
+	struct CookOptions
+	{
+		std::wstring OutputDir;
+		TargetFormat Format = TargetFormat::Auto;
+		bool SRGB = false;
+		bool Mips = true;
+		MipGenerator::Filter MipFilter = MipGenerator::Filter::Box;
+		bool KTX2 = false;
+	};
+
+	struct CookResult
+	{
+		std::wstring Message;
+		bool Failed = false;
+
+		// Texel data of the input, and of the cooked file with all its mips.
+		std::uint64_t InputBytes = 0;
+		std::uint64_t OutputBytes = 0;
+	};
+
+	std::wstring ToLower(std::wstring s)
+	{
+		std::transform(s.begin(), s.end(), s.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+		return s;
+	}
+
+	std::wstring GetExtension(const std::wstring& filename)
+	{
+		const std::size_t dot = filename.find_last_of(L'.');
+		const std::size_t slash = filename.find_last_of(L"/\\");
+		if(dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+			return L"";
+
+		return ToLower(filename.substr(dot));
+	}
+
+	std::wstring GetOutputName(const std::wstring& input, const std::wstring& outputDir, const wchar_t* extension)
+	{
+		const std::size_t slash = input.find_last_of(L"/\\");
+		const std::size_t dot = input.find_last_of(L'.');
+
+		std::wstring stem = input.substr(0, dot != std::wstring::npos && (slash == std::wstring::npos || dot > slash) ? dot : input.size());
+		if(!outputDir.empty())
+		{
+			stem = stem.substr(slash == std::wstring::npos ? 0 : slash + 1);
+			const wchar_t last = outputDir.back();
+			stem = outputDir + (last == L'/' || last == L'\\' ? L"" : L"/") + stem;
+		}
+
+		return stem + extension;
+	}
+
+	bool IsBlockCompressed(DXGI_FORMAT format)
+	{
+		return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+			(format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	}
+
+	const wchar_t* GetFormatName(DXGI_FORMAT format)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:      return L"BC1";
+		case DXGI_FORMAT_BC1_UNORM_SRGB: return L"BC1 sRGB";
+		case DXGI_FORMAT_BC2_UNORM:      return L"BC2";
+		case DXGI_FORMAT_BC2_UNORM_SRGB: return L"BC2 sRGB";
+		case DXGI_FORMAT_BC3_UNORM:      return L"BC3";
+		case DXGI_FORMAT_BC3_UNORM_SRGB: return L"BC3 sRGB";
+		case DXGI_FORMAT_BC4_UNORM:      return L"BC4";
+		case DXGI_FORMAT_BC4_SNORM:      return L"BC4 SNORM";
+		case DXGI_FORMAT_BC5_UNORM:      return L"BC5";
+		case DXGI_FORMAT_BC5_SNORM:      return L"BC5 SNORM";
+		case DXGI_FORMAT_BC7_UNORM:      return L"BC7";
+		case DXGI_FORMAT_BC7_UNORM_SRGB: return L"BC7 sRGB";
+		default:                         return L"?";
+		}
+	}
+
+	const wchar_t* GetResultText(DDSParser::Result result)
+	{
+		switch(result)
+		{
+		case DDSParser::Result::FileNotFound: return L"file not found";
+		case DDSParser::Result::NotSupported: return L"format not supported";
+		case DDSParser::Result::EndOfFile:    return L"file is truncated";
+		default:                              return L"invalid file";
+		}
+	}
+
+	// Writes the cooked image in the container options ask for.  OutputBytes is the texel
+	// data of a DDS file, or the whole of a KTX2 file.
+	bool SaveCooked(const std::wstring& output, const DDSImage& cooked, const CookOptions& options, CookResult& result)
+	{
+		if(!options.KTX2)
+		{
+			result.OutputBytes = cooked.BitSize;
+			return DDSWriter::SaveToFile(output, cooked);
+		}
+
+		std::vector<std::uint8_t> data;
+		if(!KTXWriter::SaveToMemory(cooked, KTXWriter::Options(), data))
+			return false;
+
+		result.OutputBytes = data.size();
+		return FileUtil::WriteFile(output, data.data(), data.size());
+	}
+
+	std::wstring Describe(const std::wstring& output, const DDSImage& cooked)
+	{
+		return L"-> " + output + L"  " + GetFormatName(cooked.Format) + L", " +
+			std::to_wstring(cooked.Width) + L"x" + std::to_wstring(cooked.Height) + L", " +
+			std::to_wstring(cooked.MipCount) + L" mips";
+	}
+
+	CookResult CookFile(const std::wstring& input, const CookOptions& options)
+	{
+		CookResult result;
+
+		const std::wstring output = GetOutputName(input, options.OutputDir, options.KTX2 ? L".ktx2" : L".dds");
+		if(ToLower(output) == ToLower(input))
+		{
+			result.Failed = true;
+			result.Message = L"the output would overwrite the input; use -o";
+			return result;
+		}
+
+		const std::wstring extension = GetExtension(input);
+
+		DDSImage image;
+		DDSParser::Result parse = DDSParser::Result::NotSupported;
+		if(extension == L".bmp")
+			parse = BMPReader::ParseFile(input, image);
+		else if(extension == L".dds" || extension == L".ktx2")
+			parse = KTXParser::ParseTextureFile(input, image);
+
+		if(parse != DDSParser::Result::Ok)
+		{
+			result.Failed = true;
+			result.Message = GetResultText(parse);
+			return result;
+		}
+
+		result.InputBytes = image.BitSize;
+
+		// Block compressed files are already cooked and only change container.
+		if(options.KTX2 && IsBlockCompressed(image.Format) && KTXWriter::IsSupported(image.Format))
+		{
+			if(!SaveCooked(output, image, options, result))
+			{
+				result.Failed = true;
+				result.Message = L"cannot write " + output;
+				return result;
+			}
+
+			result.Message = Describe(output, image) + L", repackaged";
+			return result;
+		}
+
+		if(!BCEncoder::IsSupportedSource(image.Format))
+		{
+			// Block compressed files are already cooked; anything else is worth a warning.
+			result.Failed = !IsBlockCompressed(image.Format);
+			result.Message = result.Failed ? L"only RGBA8 and BGRA8 images can be cooked" : L"skipped, already block compressed";
+			return result;
+		}
+
+		const bool srgb = options.SRGB || image.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ||
+			image.Format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+
+		DXGI_FORMAT format;
+		switch(options.Format)
+		{
+		case TargetFormat::BC1: format = DXGI_FORMAT_BC1_UNORM; break;
+		case TargetFormat::BC3: format = DXGI_FORMAT_BC3_UNORM; break;
+		case TargetFormat::BC7: format = DXGI_FORMAT_BC7_UNORM; break;
+		default:                format = BCEncoder::IsOpaque(image) ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM; break;
+		}
+
+		if(srgb)
+			format = DDSParser::MakeSRGB(format);
+
+		if(options.Mips)
+		{
+			MipGenerator::Options mipOptions;
+			mipOptions.MipFilter = options.MipFilter;
+			mipOptions.SRGB = srgb;
+
+			if(!MipGenerator::Generate(image, image, mipOptions))
+			{
+				result.Failed = true;
+				result.Message = L"cannot generate mips for this texture type";
+				return result;
+			}
+		}
+
+		DDSImage cooked;
+		if(!BCEncoder::Compress(image, format, cooked))
+		{
+			result.Failed = true;
+			result.Message = L"cannot compress this texture type";
+			return result;
+		}
+
+		if(!SaveCooked(output, cooked, options, result))
+		{
+			result.Failed = true;
+			result.Message = L"cannot write " + output;
+			return result;
+		}
+
+		result.Message = Describe(output, cooked);
+
+		return result;
+	}
+
+	bool ParseArguments(int argc, wchar_t* argv[], CookOptions& options, std::vector<std::wstring>& inputs)
+	{
+		for(int i = 1; i < argc; ++i)
+		{
+			const std::wstring arg = argv[i];
+
+			if(arg == L"-o" && i + 1 < argc)
+				options.OutputDir = argv[++i];
+			else if(arg == L"-f" && i + 1 < argc)
+			{
+				const std::wstring f = ToLower(argv[++i]);
+				if(f == L"auto")     options.Format = TargetFormat::Auto;
+				else if(f == L"bc1") options.Format = TargetFormat::BC1;
+				else if(f == L"bc3") options.Format = TargetFormat::BC3;
+				else if(f == L"bc7") options.Format = TargetFormat::BC7;
+				else return false;
+			}
+			else if(arg == L"-srgb")
+				options.SRGB = true;
+			else if(arg == L"-nomips")
+				options.Mips = false;
+			else if(arg == L"-kaiser")
+				options.MipFilter = MipGenerator::Filter::Kaiser;
+			else if(arg == L"-ktx2")
+				options.KTX2 = true;
+			else if(!arg.empty() && arg[0] == L'-')
+				return false;
+			else
+				inputs.push_back(arg);
+		}
+
+		return !inputs.empty();
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	CookOptions options;
+	std::vector<std::wstring> inputs;
+	if(!ParseArguments(argc, argv, options, inputs))
+	{
+		std::wcerr << L"usage: TextureCooker [-o outdir] [-f auto|bc1|bc3|bc7] [-srgb] [-nomips] [-kaiser] [-ktx2] files..." << std::endl;
+		return 2;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	TaskPool& pool = TaskPool::Default();
+
+	std::vector<std::future<CookResult>> jobs;
+	for(const auto& input : inputs)
+		jobs.push_back(pool.Submit([&input, &options]() { return CookFile(input, options); }));
+
+	int failures = 0;
+	std::uint64_t inputBytes = 0;
+	std::uint64_t outputBytes = 0;
+
+	for(std::size_t i = 0; i < jobs.size(); ++i)
+	{
+		const CookResult result = jobs[i].get();
+
+		std::wcout << inputs[i] << L": " << result.Message;
+		if(result.OutputBytes > 0)
+		{
+			std::wcout << L", " << result.InputBytes << L" -> " << result.OutputBytes << L" texel bytes";
+			inputBytes += result.InputBytes;
+			outputBytes += result.OutputBytes;
+		}
+		std::wcout << std::endl;
+
+		if(result.Failed)
+			++failures;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::wcout << inputs.size() - failures << L" of " << inputs.size() << L" files, " <<
+		inputBytes << L" -> " << outputBytes << L" texel bytes in " << seconds << L" s" << std::endl;
+
+	return failures == 0 ? 0 : 1;
+}
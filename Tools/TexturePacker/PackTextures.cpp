@@ -0,0 +1,222 @@
+//***************************************************************************************
+// PackTextures.cpp
+//
+// Command line tool that combines BMP and DDS files into one DDS file, so a set of
+// textures binds with a single SRV.
+//
+//   TexturePacker -array|-atlas -o output.dds [-padding n] [-maxsize n] [-nomips] files...
+//
+//   -array    Stack the files, which must share format and size, as the slices of a
+//             Texture2DArray, in command line order.  Any format works; mips are built
+//             for uncompressed files that lack them.
+//   -atlas    Pack the files, which must share an uncompressed format, into an atlas
+//             and write its region table next to it as output.atlas (see
+//             TexturePacker::LoadAtlasTable).  Regions are named after the files.
+//   -padding  Gutter of repeated edge texels around every atlas region (default 4).
+//   -maxsize  Largest atlas width or height (default 8192).
+//   -nomips   Keep only the top mip.
+//
+// The output is uncompressed for uncompressed inputs; run it through TextureCooker to
+// block compress it.  Atlas regions are aligned to the 4x4 blocks for that.
+//***************************************************************************************
+
+#include "../../Common/BMPReader.h"
+#include "../../Common/DDSWriter.h"
+#include "../../Common/MipGenerator.h"
+#include "../../Common/TexturePacker.h"
+#include <algorithm>
+#include <cwchar>
+#include <cwctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	enum class PackMode
+	{
+		None,
+		Array,
+		Atlas,
+	};
+
+	struct PackOptions
+	{
+		PackMode Mode = PackMode::None;
+		std::wstring Output;
+		TexturePacker::AtlasOptions Atlas;
+		bool Mips = true;
+	};
+
+	std::wstring ToLower(std::wstring s)
+	{
+		std::transform(s.begin(), s.end(), s.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+		return s;
+	}
+
+	// Start of the extension of filename, or its length if it has none.
+	std::size_t FindExtension(const std::wstring& filename)
+	{
+		const std::size_t dot = filename.find_last_of(L'.');
+		const std::size_t slash = filename.find_last_of(L"/\\");
+		if(dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+			return filename.size();
+
+		return dot;
+	}
+
+	// File name without directory and extension, as a region name.  Characters the
+	// table cannot hold become underscores.
+	std::string GetRegionName(const std::wstring& filename)
+	{
+		const std::size_t slash = filename.find_last_of(L"/\\");
+		const std::size_t begin = slash == std::wstring::npos ? 0 : slash + 1;
+
+		std::string name;
+		for(std::size_t i = begin; i < FindExtension(filename); ++i)
+		{
+			const wchar_t c = filename[i];
+			name += c > L' ' && c < 0x7f ? (char)c : '_';
+		}
+
+		return name;
+	}
+
+	const wchar_t* GetResultText(DDSParser::Result result)
+	{
+		switch(result)
+		{
+		case DDSParser::Result::FileNotFound: return L"file not found";
+		case DDSParser::Result::NotSupported: return L"format not supported";
+		case DDSParser::Result::EndOfFile:    return L"file is truncated";
+		default:                              return L"invalid file";
+		}
+	}
+
+	bool LoadSource(const std::wstring& filename, DDSImage& image)
+	{
+		const std::wstring extension = ToLower(filename.substr(FindExtension(filename)));
+
+		DDSParser::Result parse = DDSParser::Result::NotSupported;
+		if(extension == L".bmp")
+			parse = BMPReader::ParseFile(filename, image);
+		else if(extension == L".dds")
+			parse = DDSParser::ParseFile(filename, image);
+
+		if(parse != DDSParser::Result::Ok)
+		{
+			std::wcerr << filename << L": " << GetResultText(parse) << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool ParseArguments(int argc, wchar_t* argv[], PackOptions& options, std::vector<std::wstring>& inputs)
+	{
+		for(int i = 1; i < argc; ++i)
+		{
+			const std::wstring arg = argv[i];
+
+			if(arg == L"-array")
+				options.Mode = PackMode::Array;
+			else if(arg == L"-atlas")
+				options.Mode = PackMode::Atlas;
+			else if(arg == L"-o" && i + 1 < argc)
+				options.Output = argv[++i];
+			else if(arg == L"-padding" && i + 1 < argc)
+				options.Atlas.Padding = (std::uint32_t)std::wcstoul(argv[++i], nullptr, 10);
+			else if(arg == L"-maxsize" && i + 1 < argc)
+				options.Atlas.MaxSize = (std::uint32_t)std::wcstoul(argv[++i], nullptr, 10);
+			else if(arg == L"-nomips")
+				options.Mips = false;
+			else if(!arg.empty() && arg[0] == L'-')
+				return false;
+			else
+				inputs.push_back(arg);
+		}
+
+		return options.Mode != PackMode::None && !options.Output.empty() && !inputs.empty();
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	PackOptions options;
+	std::vector<std::wstring> inputs;
+	if(!ParseArguments(argc, argv, options, inputs))
+	{
+		std::wcerr << L"usage: TexturePacker -array|-atlas -o output.dds [-padding n] [-maxsize n] [-nomips] files..." << std::endl;
+		return 2;
+	}
+
+	std::vector<DDSImage> images(inputs.size());
+	std::vector<const DDSImage*> sources;
+	for(std::size_t i = 0; i < inputs.size(); ++i)
+	{
+		if(ToLower(inputs[i]) == ToLower(options.Output))
+		{
+			std::wcerr << inputs[i] << L": the output would overwrite this input" << std::endl;
+			return 1;
+		}
+
+		if(!LoadSource(inputs[i], images[i]))
+			return 1;
+
+		sources.push_back(&images[i]);
+	}
+
+	DDSImage packed;
+
+	if(options.Mode == PackMode::Array)
+	{
+		if(!TexturePacker::BuildArray(sources, packed))
+		{
+			std::wcerr << L"the files must be 2D textures of the same format and size" << std::endl;
+			return 1;
+		}
+
+		// Block compressed arrays keep the mips their files came with.
+		const std::uint32_t mipCount = options.Mips ? MipGenerator::GetFullMipCount(packed.Width, packed.Height) : 1;
+		if(packed.MipCount != mipCount && MipGenerator::IsSupported(packed.Format))
+		{
+			MipGenerator::Options mipOptions;
+			mipOptions.MipCount = mipCount;
+			MipGenerator::Generate(packed, packed, mipOptions);
+		}
+	}
+	else
+	{
+		options.Atlas.MipCount = options.Mips ? 0 : 1;
+
+		std::vector<AtlasRegion> regions;
+		if(!TexturePacker::BuildAtlas(sources, options.Atlas, packed, regions))
+		{
+			std::wcerr << L"the files must share an uncompressed RGBA format and fit in " <<
+				options.Atlas.MaxSize << L"x" << options.Atlas.MaxSize << L" texels" << std::endl;
+			return 1;
+		}
+
+		for(std::size_t i = 0; i < regions.size(); ++i)
+			regions[i].Name = GetRegionName(inputs[i]);
+
+		const std::wstring table = options.Output.substr(0, FindExtension(options.Output)) + L".atlas";
+		if(!TexturePacker::SaveAtlasTable(table, (std::uint32_t)packed.Width, (std::uint32_t)packed.Height, regions))
+		{
+			std::wcerr << L"cannot write " << table << std::endl;
+			return 1;
+		}
+	}
+
+	if(!DDSWriter::SaveToFile(options.Output, packed))
+	{
+		std::wcerr << L"cannot write " << options.Output << std::endl;
+		return 1;
+	}
+
+	std::wcout << inputs.size() << L" files -> " << options.Output << L"  " <<
+		packed.Width << L"x" << packed.Height << L", " << packed.ArraySize << L" slices, " <<
+		packed.MipCount << L" mips" << std::endl;
+
+	return 0;
+}